@@ -0,0 +1,76 @@
+#include "AppStateModel.h"
+
+namespace AppStateModel
+{
+    void ensureDefaults(juce::ValueTree& state, juce::UndoManager* undoManager)
+    {
+        jassert(state.hasType(IDs::APP_STATE));
+
+        auto setDefault = [&state, undoManager](const juce::Identifier& property, const juce::var& value) {
+            if (!state.hasProperty(property))
+                state.setProperty(property, value, undoManager);
+        };
+
+        // Defaults follow PianoXL.tsx / SettingsPanelXL.tsx
+        setDefault(IDs::INVERSION_SELECTED, false);
+        setDefault(IDs::INVERSION_VALUE, 0);
+        setDefault(IDs::SELECTED_KEY, 0);
+        setDefault(IDs::SELECTED_MODE, 0);
+        setDefault(IDs::SELECTED_OCTAVE, 0);
+        setDefault(IDs::SELECTED_SOUND, 0);
+        setDefault(IDs::USE_FLATS, false);
+        setDefault(IDs::SMOOTH_VOICING, false);
+        setDefault(IDs::MIDI_OUTPUT, false);
+        setDefault(IDs::SOFT_CLIP, false);
+        setDefault(IDs::ARP_MODE, 0);
+        setDefault(IDs::ARP_RATE, 4); // 1/16
+        setDefault(IDs::ARP_GATE, 50.0);
+        setDefault(IDs::ARP_PATTERN, "1 3 2 3");
+        setDefault(IDs::KEY_SIZE, 1);
+        setDefault(IDs::FADER_VALUE, 0.25);
+        setDefault(IDs::FLAM_VALUE, 0);
+        setDefault(IDs::BPM, 120.0);
+        setDefault(IDs::EQ_LOW, 0.0);
+        setDefault(IDs::EQ_MID, 0.0);
+        setDefault(IDs::EQ_HIGH, 0.0);
+        setDefault(IDs::SUSTAIN, 100.0);
+        setDefault(IDs::SAMPLE_START, 0.0);
+        setDefault(IDs::DISABLED_SLOT_MASK, (juce::int64) 0);
+        setDefault(IDs::TUNING_A4, 440.0);
+        setDefault(IDs::TUNING_SCALE, juce::String());
+        setDefault(IDs::TUNING_KEYBOARD_MAP, juce::String());
+
+        auto slots = state.getChildWithName(IDs::SLOTS);
+        if (!slots.isValid())
+        {
+            slots = juce::ValueTree(IDs::SLOTS);
+            state.appendChild(slots, undoManager);
+        }
+
+        // Slots are stored in flat index order so lookups don't need to search
+        for (int key = 0; key < numKeys; ++key)
+        {
+            for (int slot = 0; slot < maxSlotsPerKey; ++slot)
+            {
+                const int flatIndex = getFlatSlotIndex(key, slot);
+                if (flatIndex < slots.getNumChildren())
+                    continue;
+
+                juce::ValueTree slotTree(IDs::SLOT);
+                slotTree.setProperty(IDs::KEY_INDEX, key, nullptr);
+                slotTree.setProperty(IDs::SLOT_INDEX, slot, nullptr);
+                slotTree.setProperty(IDs::CHORD_TYPE_INDEX, 0, nullptr);
+                slotTree.setProperty(IDs::BASS_OFFSET, 0, nullptr);
+                slots.appendChild(slotTree, undoManager);
+            }
+        }
+    }
+
+    juce::ValueTree getSlot(const juce::ValueTree& state, int keyIndex, int slotIndex)
+    {
+        if (keyIndex < 0 || keyIndex >= numKeys || slotIndex < 0 || slotIndex >= maxSlotsPerKey)
+            return {};
+
+        return state.getChildWithName(IDs::SLOTS).getChild(getFlatSlotIndex(keyIndex, slotIndex));
+    }
+}
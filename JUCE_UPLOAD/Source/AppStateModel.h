@@ -0,0 +1,23 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Identifiers.h"
+
+// Describes the shape of the application state ValueTree (IDs::APP_STATE).
+// Everything that should survive a reload or a host project save lives in this tree.
+namespace AppStateModel
+{
+    constexpr int numKeys = 12;
+    constexpr int maxSlotsPerKey = 3;
+    constexpr int numSlots = numKeys * maxSlotsPerKey;
+
+    // Flat index used for the slot grid, key-major (C slot 0, C slot 1, C slot 2, C# slot 0...)
+    constexpr int getFlatSlotIndex(int keyIndex, int slotIndex) { return keyIndex * maxSlotsPerKey + slotIndex; }
+
+    // Adds any missing properties and slot children with their default values.
+    // Existing values (e.g. restored from a snapshot) are left untouched.
+    void ensureDefaults(juce::ValueTree& state, juce::UndoManager* undoManager);
+
+    // Returns the SLOT child for a key/slot pair, or an invalid tree if it doesn't exist.
+    juce::ValueTree getSlot(const juce::ValueTree& state, int keyIndex, int slotIndex);
+}
@@ -0,0 +1,198 @@
+#include "Arpeggiator.h"
+
+namespace
+{
+    constexpr double gridTolerance = 1.0e-6; // Beats; keeps a step that lands on a grid line on it
+}
+
+double Arpeggiator::getStepBeats(int rateIndex) noexcept
+{
+    // Notes per whole note; 1/12, 1/24 and 1/48 are the triplet rates
+    static constexpr double divisions[numRates] = { 0.0, 4.0, 8.0, 12.0, 16.0, 24.0, 32.0, 48.0 };
+
+    if (rateIndex <= 0 || rateIndex >= numRates)
+        return 0.0;
+
+    return 4.0 / divisions[rateIndex];
+}
+
+int Arpeggiator::parsePattern(const juce::String& text, juce::int8* dest)
+{
+    int numSteps = 0;
+    for (const auto& token : juce::StringArray::fromTokens(text, " ,", {}))
+    {
+        if (numSteps >= maxPatternLength)
+            break;
+
+        const auto trimmed = token.trim();
+        if (trimmed.isEmpty())
+            continue;
+
+        if (trimmed == "-" || trimmed == "0")
+        {
+            dest[numSteps++] = rest;
+        }
+        else if (trimmed.containsOnly("0123456789"))
+        {
+            const int noteNumber = trimmed.getIntValue();
+            if (noteNumber >= 1 && noteNumber <= Voicing::maxNotes)
+                dest[numSteps++] = (juce::int8) (noteNumber - 1);
+        }
+    }
+
+    return numSteps;
+}
+
+//==============================================================================
+int Arpeggiator::getStrumOrder(const Voicing& voicing, const Settings& settings, juce::int8* order)
+{
+    const int numNotes = voicing.numNotes;
+
+    if (settings.pattern == Pattern::custom && settings.numCustomSteps > 0)
+    {
+        for (int i = 0; i < settings.numCustomSteps; ++i)
+            order[i] = settings.customSteps[i] == rest ? rest : (juce::int8) (settings.customSteps[i] % numNotes);
+
+        return settings.numCustomSteps;
+    }
+
+    bool downwards = settings.pattern == Pattern::down;
+    if (settings.pattern == Pattern::alternate)
+        downwards = (strumCount++ % 2) != 0;
+
+    for (int i = 0; i < numNotes; ++i)
+        order[i] = (juce::int8) (downwards ? numNotes - 1 - i : i);
+
+    if (settings.pattern == Pattern::random)
+    {
+        for (int i = numNotes; --i > 0;)
+            std::swap(order[i], order[random.nextInt(i + 1)]);
+    }
+
+    return numNotes;
+}
+
+//==============================================================================
+void Arpeggiator::start(const Voicing& voicing, int sourceNoteToUse, juce::int64 time, juce::int64 holdSamples)
+{
+    chord = voicing;
+    active = voicing.isPlayable();
+    sourceNote = sourceNoteToUse;
+    stepCount = 0;
+    nextStepTime = (double) time; // The first note plays on the press, the rest on the grid
+    holdEndTime = holdSamples < 0 ? -1 : time + holdSamples;
+    lastIndex = -1;
+}
+
+void Arpeggiator::release(int sourceNoteToRelease) noexcept
+{
+    if (active && sourceNote == sourceNoteToRelease)
+        active = false;
+}
+
+void Arpeggiator::syncToClock(juce::int64 blockStart, const Settings& settings, const Clock& clock) noexcept
+{
+    if (!active || !clock.isLocked || !settings.isArpeggiating() || stepCount == 0)
+        return;
+
+    const double stepBeats = getStepBeats(settings.rate);
+    const double ppq = clock.ppqAtBlockStart;
+    const double nextGridLine = std::ceil(ppq / stepBeats - gridTolerance) * stepBeats;
+
+    nextStepTime = (double) blockStart + (nextGridLine - ppq) * clock.samplesPerBeat;
+}
+
+bool Arpeggiator::getNextStep(juce::int64 blockStart, juce::int64 endTime, const Settings& settings, const Clock& clock, Step& step)
+{
+    if (!active)
+        return false;
+
+    const auto time = (juce::int64) std::llround(nextStepTime);
+    if (!settings.isArpeggiating() || (holdEndTime >= 0 && time >= holdEndTime))
+    {
+        active = false;
+        return false;
+    }
+
+    if (time >= endTime)
+        return false;
+
+    const double stepBeats = getStepBeats(settings.rate);
+    const double stepSamples = stepBeats * clock.samplesPerBeat;
+
+    const int index = getNoteIndex(settings, chord.numNotes);
+    step.time = time;
+    step.note = index >= 0 ? chord.notes[index] : -1;
+    step.length = juce::jmax((juce::int64) 1, (juce::int64) std::llround(stepSamples * settings.gatePercent / 100.0f));
+    if (holdEndTime >= 0)
+        step.length = juce::jmin(step.length, holdEndTime - time);
+
+    ++stepCount;
+
+    if (clock.isLocked)
+    {
+        // Next line of the host's grid after this step
+        const double ppq = clock.ppqAtBlockStart + (nextStepTime - (double) blockStart) / clock.samplesPerBeat;
+        const double nextGridLine = (std::floor(ppq / stepBeats + gridTolerance) + 1.0) * stepBeats;
+        nextStepTime += (nextGridLine - ppq) * clock.samplesPerBeat;
+    }
+    else
+    {
+        nextStepTime += stepSamples;
+    }
+
+    return true;
+}
+
+int Arpeggiator::getNoteIndex(const Settings& settings, int numNotes)
+{
+    const auto position = (int) (stepCount % juce::jmax(1, numNotes));
+    int index = position;
+
+    switch (settings.pattern)
+    {
+        case Pattern::down:
+            index = numNotes - 1 - position;
+            break;
+
+        case Pattern::alternate:
+        {
+            // Up then back down without repeating the top and bottom notes
+            const int period = juce::jmax(1, 2 * numNotes - 2);
+            const auto phase = (int) (stepCount % period);
+            index = phase < numNotes ? phase : period - phase;
+            break;
+        }
+
+        case Pattern::random:
+            // Any note but the last one, so the line keeps moving
+            if (numNotes > 1)
+            {
+                index = random.nextInt(numNotes - 1);
+                if (lastIndex >= 0 && index >= lastIndex)
+                    ++index;
+            }
+            else
+            {
+                index = 0;
+            }
+            break;
+
+        case Pattern::custom:
+            if (settings.numCustomSteps > 0)
+            {
+                const auto value = settings.customSteps[stepCount % settings.numCustomSteps];
+                index = value == rest ? -1 : value % numNotes;
+            }
+            break;
+
+        case Pattern::off:
+        case Pattern::up:
+            break;
+    }
+
+    if (index >= 0)
+        lastIndex = index;
+
+    return index;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Voicing.h"
+
+// Strum and arpeggiator patterns over the notes of one chord voicing.
+//
+// At the STRUM rate the whole chord is played once, in pattern order, with the notes
+// staggered by the flam interval - UP is the reference's flam. At the other rates the
+// held chord is stepped through one note at a time on a tempo grid: the host's beat
+// grid while its transport runs, otherwise a free-running grid from the press.
+//
+// Audio thread only, apart from the static helpers. Nothing allocates.
+class Arpeggiator
+{
+public:
+    enum class Pattern { off, up, down, alternate, random, custom };
+
+    static constexpr int numPatterns = 6;
+    static constexpr int numRates = 8;
+    static constexpr int maxPatternLength = 16;
+    static constexpr juce::int8 rest = -1;
+
+    // In ARP_MODE / ARP_RATE order
+    inline static const char* const patternNames[numPatterns] = { "OFF", "UP", "DOWN", "ALT", "RANDOM", "CUSTOM" };
+    inline static const char* const rateNames[numRates] = { "STRUM", "1/4", "1/8", "1/12", "1/16", "1/24", "1/32", "1/48" };
+
+    // Beats (quarter notes) per step, 0 for STRUM
+    static double getStepBeats(int rateIndex) noexcept;
+
+    // Parses a custom pattern such as "1 3 2 -": 1-based chord note numbers, with "-" or
+    // "0" for a rest. Returns the number of steps written to dest (at most maxPatternLength).
+    static int parsePattern(const juce::String& text, juce::int8* dest);
+
+    struct Settings
+    {
+        Pattern pattern = Pattern::off;
+        int rate = 0;
+        float gatePercent = 50.0f;           // Note length as a share of the step
+        const juce::int8* customSteps = nullptr;
+        int numCustomSteps = 0;
+
+        bool isArpeggiating() const noexcept { return pattern != Pattern::off && rate > 0; }
+    };
+
+    struct Clock
+    {
+        double samplesPerBeat = 24000.0;
+        bool isLocked = false;               // Host transport running: steps fall on its grid
+        double ppqAtBlockStart = 0.0;        // Host position at the start of the block, when locked
+    };
+
+    struct Step
+    {
+        juce::int64 time = 0;                // Absolute sample time
+        juce::int64 length = 0;              // Samples
+        int note = -1;                       // MIDI note, or -1 for a rest
+    };
+
+    Arpeggiator() = default;
+
+    // Note indices for one strum of voicing, in play order (rest for a rest). Returns
+    // how many were written to order, which needs room for maxPatternLength entries.
+    int getStrumOrder(const Voicing& voicing, const Settings& settings, juce::int8* order);
+
+    // Starts stepping through voicing at time. holdSamples < 0 holds until stop() or
+    // release(); otherwise stepping ends after that long.
+    void start(const Voicing& voicing, int sourceNote, juce::int64 time, juce::int64 holdSamples);
+    void stop() noexcept { active = false; }
+
+    // Stops if the held chord was started by sourceNote
+    void release(int sourceNote) noexcept;
+
+    // Call at the start of each block: re-aligns the next step to the host grid, so tempo
+    // changes and transport jumps are followed
+    void syncToClock(juce::int64 blockStart, const Settings& settings, const Clock& clock) noexcept;
+
+    // The next step due before endTime, if any. Call repeatedly until it returns false.
+    bool getNextStep(juce::int64 blockStart, juce::int64 endTime, const Settings& settings, const Clock& clock, Step& step);
+
+    bool isActive() const noexcept { return active; }
+    int getSourceNote() const noexcept { return sourceNote; }
+
+private:
+    int getNoteIndex(const Settings& settings, int numNotes);
+
+    Voicing chord;
+    bool active = false;
+    int sourceNote = -1;
+    juce::int64 stepCount = 0;
+    double nextStepTime = 0.0;
+    juce::int64 holdEndTime = -1;            // -1 = until released
+    int lastIndex = -1;
+    int strumCount = 0;                      // ALT strums alternate direction chord by chord
+    juce::Random random;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Arpeggiator)
+};
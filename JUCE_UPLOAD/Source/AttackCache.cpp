@@ -0,0 +1,381 @@
+#include "AttackCache.h"
+
+namespace
+{
+    constexpr int refreshIntervalMs = 50;
+}
+
+//==============================================================================
+bool AttackCache::Settings::operator==(const Settings& other) const noexcept
+{
+    return sampleRate == other.sampleRate && flamSamples == other.flamSamples
+        && sustainPercent == other.sustainPercent && sampleStartMs == other.sampleStartMs
+        && arpPattern == other.arpPattern && arpRate == other.arpRate;
+}
+
+bool AttackCache::Key::operator==(const Key& other) const noexcept
+{
+    return std::memcmp(&voicing, &other.voicing, sizeof(Voicing)) == 0
+        && numSteps == other.numSteps && std::memcmp(order, other.order, (size_t) numSteps) == 0
+        && flamSamples == other.flamSamples && sustainPercent == other.sustainPercent
+        && sampleStartMs == other.sampleStartMs && sampleRate == other.sampleRate && sound == other.sound
+        && std::memcmp(frequencies, other.frequencies, sizeof(frequencies)) == 0 && bassFrequency == other.bassFrequency;
+}
+
+void AttackCache::Key::setTuning(const TuningTable& tuning) noexcept
+{
+    for (int i = 0; i < Voicing::maxNotes; ++i)
+        frequencies[i] = i < voicing.numNotes ? tuning.getFrequency(voicing.notes[i]) : 0.0f;
+
+    bassFrequency = voicing.bassNote >= 0 ? tuning.getFrequency(voicing.bassNote) : 0.0f;
+}
+
+size_t AttackCache::Entry::getSizeInBytes() const noexcept
+{
+    return sizeof(Entry) + sizeof(float) * (size_t) (chord.getNumSamples() + bass.getNumSamples());
+}
+
+const AttackCache::Entry* AttackCache::Table::find(const Key& key) const noexcept
+{
+    for (const auto& entry : entries)
+        if (entry->key == key)
+            return entry.get();
+
+    return nullptr;
+}
+
+//==============================================================================
+AttackCache::Entry::Ptr AttackCache::SharedPool::find(const Key& key) const
+{
+    const juce::ScopedLock sl(lock);
+
+    for (auto* entry : entries)
+        if (entry->key == key)
+            return entry;
+
+    return nullptr;
+}
+
+AttackCache::Entry::Ptr AttackCache::SharedPool::add(Entry::Ptr entry)
+{
+    const juce::ScopedLock sl(lock);
+
+    // Two instances can render the same key at once; the first one in wins
+    for (auto* existing : entries)
+        if (existing->key == entry->key)
+            return existing;
+
+    entries.add(entry);
+    return entry;
+}
+
+void AttackCache::SharedPool::releaseUnused()
+{
+    const juce::ScopedLock sl(lock);
+
+    for (int i = entries.size(); --i >= 0;)
+        if (entries.getObjectPointerUnchecked(i)->getReferenceCount() == 1)
+            entries.remove(i);
+}
+
+int AttackCache::SharedPool::getNumEntries() const
+{
+    const juce::ScopedLock sl(lock);
+    return entries.size();
+}
+
+size_t AttackCache::SharedPool::getSizeInBytes() const
+{
+    const juce::ScopedLock sl(lock);
+
+    size_t total = 0;
+    for (auto* entry : entries)
+        total += entry->getSizeInBytes();
+
+    return total;
+}
+
+//==============================================================================
+class AttackCache::RenderJob : public juce::ThreadPoolJob
+{
+public:
+    RenderJob(AttackCache& ownerToUse, const Key& keyToRender)
+        : juce::ThreadPoolJob("PianoXL attack render"), owner(ownerToUse), key(keyToRender)
+    {
+    }
+
+    // A job removed before it ran still has to say so, or its key would stay in flight
+    ~RenderJob() override
+    {
+        if (!hasRun)
+            owner.jobFinished(key, nullptr);
+    }
+
+    JobStatus runJob() override
+    {
+        hasRun = true;
+        owner.jobFinished(key, shouldExit() ? nullptr : render(key));
+        return jobHasFinished;
+    }
+
+private:
+    AttackCache& owner;
+    const Key key;
+    bool hasRun = false;
+};
+
+//==============================================================================
+AttackCache::AttackCache(EngineStateBridge& bridgeToUse, TuningManager& tuningToUse, size_t budgetBytes)
+    : bridge(bridgeToUse),
+      tuning(tuningToUse),
+      budget(budgetBytes),
+      pool(juce::jlimit(1, 2, juce::SystemStats::getNumCpus() - 1))
+{
+    startTimer(refreshIntervalMs);
+}
+
+AttackCache::~AttackCache()
+{
+    stopTimer();
+    pool.removeAllJobs(true, 2000);
+
+    // Let go of everything, then let the shared pool free whatever no other instance uses
+    finished.clear();
+    tables.clear();
+    entries.clear();
+    sharedPool->releaseUnused();
+}
+
+AttackCache::Entry::Ptr AttackCache::render(const Key& key)
+{
+    const int numSamples = juce::jmax(1, (int) std::ceil(attackSeconds * key.sampleRate));
+
+    Entry::Ptr entry(new Entry());
+    entry->key = key;
+    entry->chord.setSize(1, numSamples);
+    entry->bass.setSize(1, numSamples);
+    entry->chord.clear();
+    entry->bass.clear();
+
+    // The fader is applied at playback, so both buses render at unity
+    juce::HeapBlock<float> unityGains((size_t) numSamples);
+    juce::FloatVectorOperations::fill(unityGains.get(), 1.0f, numSamples);
+
+    // Started exactly as ChordEngine::playVoicing starts them
+    const auto length = SynthVoice::getNoteLengthSamples(key.sustainPercent, key.sampleRate);
+    const int lengthSamples = (int) juce::jmin(length, (juce::int64) std::numeric_limits<int>::max());
+    const float chordGain = SynthVoice::getChordNoteGain(key.voicing.numNotes);
+    const SynthVoice::Shape shape(key.sampleRate, key.sustainPercent, key.sampleStartMs);
+
+    for (int i = 0; i < key.numSteps; ++i)
+    {
+        if (key.order[i] != Arpeggiator::rest && key.frequencies[key.order[i]] > 0.0f)
+            entry->voices[(size_t) entry->numVoices++].start(key.frequencies[key.order[i]], chordGain, false, -1,
+                                                             juce::roundToInt(i * key.flamSamples), lengthSamples, shape);
+    }
+
+    if (key.voicing.bassNote >= 0 && key.bassFrequency > 0.0f)
+        entry->voices[(size_t) entry->numVoices++].start(key.bassFrequency, SynthVoice::noteGain * SynthVoice::bassGain, true, -1,
+                                                         0, (int) length, shape);
+
+    for (int i = 0; i < entry->numVoices; ++i)
+    {
+        auto& voice = entry->voices[(size_t) i];
+        voice.render((voice.isBass ? entry->bass : entry->chord).getWritePointer(0), nullptr, unityGains.get(), numSamples);
+    }
+
+    return entry;
+}
+
+//==============================================================================
+void AttackCache::setSettings(const Settings& newSettings) noexcept
+{
+    settingsBuffer.getWriteBuffer() = newSettings;
+    settingsBuffer.publish();
+}
+
+void AttackCache::buildNow()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    collectFinished();
+    needsRefresh = true;
+    refresh(true);
+}
+
+//==============================================================================
+void AttackCache::timerCallback()
+{
+    collectFinished();
+    refresh(false);
+
+    if (tables.releaseUnused())
+        sharedPool->releaseUnused(); // They may have held the last use of entries trimmed earlier
+}
+
+void AttackCache::refresh(bool renderMissingNow)
+{
+    const auto& state = bridge.getCompiledState();
+    const auto settings = settingsBuffer.read();
+    if (settings.sampleRate <= 0.0)
+        return; // The engine hasn't run yet
+
+    const auto currentTuning = tuning.getCurrentTable();
+    const bool changed = state.version != lastStateVersion || settings != lastSettings || currentTuning != lastTuning;
+    if (!changed && !needsRefresh)
+        return;
+
+    // Renders queued for the old slots would be wasted; ones already running still land in the LRU list
+    if (changed)
+        pool.removeAllJobs(false, 0);
+
+    lastStateVersion = state.version;
+    lastSettings = settings;
+    lastTuning = currentTuning;
+    needsRefresh = false;
+
+    Arpeggiator::Settings arpSettings;
+    arpSettings.pattern = (Arpeggiator::Pattern) juce::jlimit(0, Arpeggiator::numPatterns - 1, settings.arpPattern);
+    arpSettings.rate = juce::jlimit(0, Arpeggiator::numRates - 1, settings.arpRate);
+    arpSettings.customSteps = state.arpSteps;
+    arpSettings.numCustomSteps = juce::jlimit(0, Arpeggiator::maxPatternLength, (int) state.numArpSteps);
+
+    Table::Ptr table(new Table());
+
+    // Arp steps and random strums differ press by press, and MIDI output plays nothing
+    const bool isCacheable = state.midiOutput == 0 && !arpSettings.isArpeggiating()
+                          && arpSettings.pattern != Arpeggiator::Pattern::random;
+
+    for (int keyIndex = 0; isCacheable && keyIndex < 12; ++keyIndex)
+    {
+        for (int slotIndex = 0; slotIndex < state.slotsPerKey; ++slotIndex)
+        {
+            const auto& voicing = state.getVoicing(keyIndex, slotIndex);
+            if (!state.isSlotEnabled(keyIndex, slotIndex) || !voicing.isPlayable())
+                continue;
+
+            Key key;
+            key.voicing = voicing;
+            key.numSteps = Arpeggiator().getStrumOrder(voicing, arpSettings, key.order); // A fresh ALT strums upwards
+            key.flamSamples = settings.flamSamples;
+            key.sustainPercent = settings.sustainPercent;
+            key.sampleStartMs = settings.sampleStartMs;
+            key.sampleRate = settings.sampleRate;
+            key.sound = state.sound;
+            key.setTuning(*currentTuning);
+
+            Entry::Ptr entry;
+            for (int i = entries.size(); --i >= 0;)
+            {
+                if (entries.getObjectPointerUnchecked(i)->key == key)
+                {
+                    entry = entries[i];
+                    entries.move(i, -1); // Most recently used last
+                    break;
+                }
+            }
+
+            // Another instance may already have rendered it
+            if (entry == nullptr)
+            {
+                entry = sharedPool->find(key);
+                if (entry != nullptr)
+                    addEntry(entry);
+            }
+
+            if (entry == nullptr && renderMissingNow)
+            {
+                entry = sharedPool->add(render(key));
+                addEntry(entry);
+            }
+
+            if (entry != nullptr)
+            {
+                table->entries.push_back(entry);
+                continue;
+            }
+
+            const juce::ScopedLock lock(jobLock);
+            if (std::find(keysInFlight.begin(), keysInFlight.end(), key) == keysInFlight.end())
+            {
+                keysInFlight.push_back(key);
+                pool.addJob(new RenderJob(*this, key), true);
+            }
+        }
+    }
+
+    tables.publish(table);
+    trimToBudget();
+}
+
+void AttackCache::jobFinished(const Key& key, Entry::Ptr entry)
+{
+    const juce::ScopedLock lock(jobLock);
+    keysInFlight.erase(std::remove(keysInFlight.begin(), keysInFlight.end(), key), keysInFlight.end());
+
+    if (entry != nullptr)
+        finished.add(entry);
+}
+
+void AttackCache::collectFinished()
+{
+    juce::ReferenceCountedArray<Entry> rendered;
+    {
+        const juce::ScopedLock lock(jobLock);
+        rendered.swapWith(finished);
+    }
+
+    for (auto* entry : rendered)
+        addEntry(sharedPool->add(entry));
+
+    if (!rendered.isEmpty())
+        needsRefresh = true; // Rebuild the table with them in it
+}
+
+void AttackCache::addEntry(Entry::Ptr entry)
+{
+    // A key this instance was still rendering can turn up from the shared pool first
+    const int existing = entries.indexOf(entry.get());
+    if (existing >= 0)
+    {
+        entries.move(existing, -1);
+        return;
+    }
+
+    entries.add(entry);
+    totalBytes += entry->getSizeInBytes();
+}
+
+void AttackCache::trimToBudget()
+{
+    // Least recently used first; entries a table still uses stay until it's released.
+    // Other instances share entries, so the reference count can't tell which those are.
+    bool trimmed = false;
+    for (int i = 0; totalBytes > budget && i < entries.size();)
+    {
+        auto* candidate = entries.getObjectPointerUnchecked(i);
+        if (!isInUse(candidate))
+        {
+            totalBytes -= candidate->getSizeInBytes();
+            entries.remove(i);
+            trimmed = true;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    if (trimmed)
+        sharedPool->releaseUnused();
+}
+
+bool AttackCache::isInUse(const Entry* entry) const noexcept
+{
+    for (auto* table : tables.getRetained())
+        for (const auto& used : table->entries)
+            if (used.get() == entry)
+                return true;
+
+    return false;
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include "EngineStateBridge.h"
+#include "TripleBuffer.h"
+#include "RealtimeHandoff.h"
+#include "SynthVoice.h"
+#include "TuningManager.h"
+#include "Arpeggiator.h"
+
+// Prerendered openings of the visible slots' chords, so a press starts by copying
+// audio instead of spinning up every voice at once.
+//
+// A slot's sound is fixed by its voicing, strum order, flam, sustain, sample start,
+// instrument and tuning. Whenever one of those changes, the slots that aren't cached yet are
+// rendered on worker threads with the same SynthVoice code the engine plays, chord and
+// bass kept apart so the fader still applies at playback. Each entry also keeps the
+// voices' state at the end of its audio, so the engine hands over to live voices on
+// exactly the next sample.
+//
+// Entries sit in an LRU list bounded by a byte budget, so going back to a recent key or
+// setting finds them still there. Rendered entries are also shared through a
+// process-wide SharedPool, so every instance of the plugin in a session plays the same
+// buffers. The audio thread only sees an immutable Table of the current slots' entries,
+// handed over through a RealtimeHandoff.
+class AttackCache : private juce::Timer
+{
+public:
+    static constexpr int maxVoicesPerChord = Arpeggiator::maxPatternLength + 1; // Strum steps plus bass
+    static constexpr double attackSeconds = 0.05;
+    static constexpr size_t defaultBudgetBytes = 8 * 1024 * 1024;
+
+    // What the engine is currently playing presses with, published from the audio thread
+    struct Settings
+    {
+        double sampleRate = 0.0;      // 0 until the engine has processed a block
+        double flamSamples = 0.0;
+        float sustainPercent = 100.0f;
+        float sampleStartMs = 0.0f;
+        int arpPattern = 0;
+        int arpRate = 0;
+
+        bool operator==(const Settings& other) const noexcept;
+        bool operator!=(const Settings& other) const noexcept { return !(*this == other); }
+    };
+
+    // Everything a chord's opening depends on
+    struct Key
+    {
+        Voicing voicing;
+        juce::int8 order[Arpeggiator::maxPatternLength] = {}; // Strum order, as Arpeggiator::getStrumOrder
+        int numSteps = 0;
+        double flamSamples = 0.0;
+        float sustainPercent = 100.0f;
+        float sampleStartMs = 0.0f;
+        double sampleRate = 44100.0;
+        int sound = 0;
+        float frequencies[Voicing::maxNotes] = {};   // Of the voicing's notes, from the tuning in use
+        float bassFrequency = 0.0f;
+
+        // Fills in the frequencies, once the voicing is set
+        void setTuning(const TuningTable& tuning) noexcept;
+
+        bool operator==(const Key& other) const noexcept;
+    };
+
+    class Entry : public juce::ReferenceCountedObject
+    {
+    public:
+        using Ptr = juce::ReferenceCountedObjectPtr<Entry>;
+
+        Key key;
+        juce::AudioBuffer<float> chord, bass;                  // Mono, at unity bus gain
+        std::array<SynthVoice, maxVoicesPerChord> voices {};   // State after the last cached sample
+        int numVoices = 0;
+
+        int getNumSamples() const noexcept { return chord.getNumSamples(); }
+        size_t getSizeInBytes() const noexcept;
+    };
+
+    class Table : public juce::ReferenceCountedObject
+    {
+    public:
+        using Ptr = juce::ReferenceCountedObjectPtr<Table>;
+
+        // Audio thread. The cached opening for key, if there is one.
+        const Entry* find(const Key& key) const noexcept;
+
+        std::vector<Entry::Ptr> entries;
+    };
+
+    // Entries shared by every AttackCache in the process, keyed by Key (which includes the
+    // sample rate), so a session with many instances keeps one copy of each distinct opening.
+    // Entries never change once rendered. The pool drops one as soon as no cache holds it,
+    // and goes away with the last cache. Any thread.
+    class SharedPool
+    {
+    public:
+        SharedPool() = default;
+
+        // The entry for key, if any instance has rendered it
+        Entry::Ptr find(const Key& key) const;
+
+        // Adds a newly rendered entry and returns it, or returns the one already there if
+        // another instance rendered the same key first
+        Entry::Ptr add(Entry::Ptr entry);
+
+        // Drops the entries nothing but the pool holds any more
+        void releaseUnused();
+
+        int getNumEntries() const;
+        size_t getSizeInBytes() const;
+
+    private:
+        juce::CriticalSection lock;
+        juce::ReferenceCountedArray<Entry> entries;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedPool)
+    };
+
+    AttackCache(EngineStateBridge& bridgeToUse, TuningManager& tuningToUse, size_t budgetBytes = defaultBudgetBytes);
+    ~AttackCache() override;
+
+    // Renders one chord's opening. Any thread.
+    static Entry::Ptr render(const Key& key);
+
+    // Audio thread
+    void setSettings(const Settings& newSettings) noexcept;
+
+    // Audio thread. Swaps a newly built table into current, if one is waiting.
+    void updateTable(Table::Ptr& current) noexcept { tables.tryTake(current); }
+
+    // Message thread. Renders whatever is missing right away instead of on the worker
+    // threads, for hosts without a running message loop.
+    void buildNow();
+
+    size_t getSizeInBytes() const noexcept { return totalBytes; }
+
+private:
+    class RenderJob;
+
+    // Message thread. Works out the current slots' keys and queues the missing ones.
+    void refresh(bool renderMissingNow);
+    void collectFinished();
+    void addEntry(Entry::Ptr entry);
+    void trimToBudget();
+    bool isInUse(const Entry* entry) const noexcept;
+
+    // Any thread, from the render jobs
+    void jobFinished(const Key& key, Entry::Ptr entry);
+
+    // juce::Timer - picks up rendered entries, follows changes and frees old tables
+    void timerCallback() override;
+
+    EngineStateBridge& bridge;
+    TuningManager& tuning;
+    const size_t budget;
+
+    TripleBuffer<Settings> settingsBuffer;
+    Settings lastSettings;
+    juce::uint32 lastStateVersion = 0;
+    TuningTable::Ptr lastTuning;
+    bool needsRefresh = true;
+
+    juce::SharedResourcePointer<SharedPool> sharedPool; // Before the entries, so it outlives them
+    juce::ReferenceCountedArray<Entry> entries;   // Least recently used first
+    size_t totalBytes = 0;
+
+    juce::CriticalSection jobLock;
+    std::vector<Key> keysInFlight;                // Guarded by jobLock
+    juce::ReferenceCountedArray<Entry> finished;  // Guarded by jobLock
+
+    RealtimeHandoff<Table> tables;
+
+    juce::ThreadPool pool;                        // Last, so its jobs are gone before anything they use
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AttackCache)
+};
@@ -0,0 +1,34 @@
+#include "ChordDisplayComponent.h"
+
+ChordDisplayComponent::ChordDisplayComponent()
+{
+    setInterceptsMouseClicks(false, false);
+}
+
+void ChordDisplayComponent::setFont(const juce::Font& newFont)
+{
+    font = newFont;
+    repaint();
+}
+
+void ChordDisplayComponent::setTextColour(juce::Colour newColour)
+{
+    textColour = newColour;
+    repaint();
+}
+
+void ChordDisplayComponent::setChordName(const MusicTheory::ChordName& newName)
+{
+    if (chordName != newName)
+    {
+        chordName = newName;
+        repaint();
+    }
+}
+
+void ChordDisplayComponent::paint(juce::Graphics& g)
+{
+    // Inset as a Label's default border
+    g.setColour(textColour);
+    glyphCache->draw(g, chordName.getText(), font, getLocalBounds().toFloat().reduced(5.0f, 1.0f), juce::Justification::centred);
+}
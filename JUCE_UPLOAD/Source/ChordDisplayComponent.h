@@ -0,0 +1,32 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MusicTheory.h"
+#include "GlyphCache.h"
+
+// The settings panel's chord display: the name of the last chord played, centred.
+// Stands in for a juce::Label so that showing a chord is a byte copy and painting it
+// reuses the glyphs shaped the first time that name appeared.
+class ChordDisplayComponent : public juce::Component
+{
+public:
+    ChordDisplayComponent();
+
+    void setFont(const juce::Font& newFont);
+    void setTextColour(juce::Colour newColour);
+
+    // Only repaints if the name changed
+    void setChordName(const MusicTheory::ChordName& newName);
+    const MusicTheory::ChordName& getChordName() const noexcept { return chordName; }
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    MusicTheory::ChordName chordName;
+    juce::Font font { juce::FontOptions() };
+    juce::Colour textColour = juce::Colours::white;
+
+    juce::SharedResourcePointer<GlyphCache> glyphCache;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChordDisplayComponent)
+};
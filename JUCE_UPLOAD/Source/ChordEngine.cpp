@@ -0,0 +1,611 @@
+#include "ChordEngine.h"
+#include "VoiceLeading.h"
+#include "Flam.h"
+
+namespace
+{
+    constexpr float chordStopSeconds = 0.01f;   // Previous chord fading out under a new one
+    constexpr double faderRampSeconds = 0.02;
+    constexpr int chordChannel = 1;
+    constexpr int bassChannel = 2;
+    constexpr int midiOutputReserveBytes = 4096;
+}
+
+void ChordEngine::prepare(double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+
+    chordGains.allocate((size_t) maxBlockSize, true);
+    bassGains.allocate((size_t) maxBlockSize, true);
+    fader.reset(sampleRate, faderRampSeconds);
+    cacheSettings = {};
+    shapeSustainPercent = -1.0f; // Redo the voice shape for the new rate
+    numCachedPresses = 0;
+    eq.prepare(sampleRate, 2);
+    voiceRenderer.prepare(maxBlockSize, maxVoices);
+    midiOutput.ensureSize(midiOutputReserveBytes);
+    reset();
+}
+
+void ChordEngine::reset()
+{
+    for (auto& voice : voices)
+        voice = SynthVoice();
+
+    for (auto& player : attackPlayers)
+        player = AttackPlayer();
+
+    lastVoicing = Voicing();
+    heldTouches = 0;
+    lastBlockWallTime = 0.0;
+    arpeggiator.stop();
+    playbackIndex = playback != nullptr ? playback->chords.size() : 0;
+    fader.setCurrentAndTargetValue(fader.getTargetValue());
+    eq.reset();
+    scheduler.reset();
+    blockStartTime = 0;
+    position = 0;
+}
+
+void ChordEngine::process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi, const EngineState& state,
+                          const PluginParameters::Values& parameters, const Transport& transport)
+{
+    const double blockWallTime = juce::Time::getMillisecondCounterHiRes();
+    const int numSamples = buffer.getNumSamples();
+
+    fader.setTargetValue(juce::jlimit(0.0f, 1.0f, parameters.fader));
+    eq.setTargetGains(parameters.eqLowDb, parameters.eqMidDb, parameters.eqHighDb);
+    sustainPercent = juce::jlimit(10.0f, 200.0f, parameters.sustainPercent);
+    sampleStartMs = juce::jlimit(0.0f, 500.0f, parameters.sampleStartMs);
+
+    if (sustainPercent != shapeSustainPercent || sampleStartMs != shapeSampleStartMs)
+    {
+        voiceShape = SynthVoice::Shape(sampleRate, sustainPercent, sampleStartMs);
+        shapeSustainPercent = sustainPercent;
+        shapeSampleStartMs = sampleStartMs;
+    }
+
+    if (tuning != nullptr)
+        tuning->updateTable(tuningTable);
+
+    // The host's tempo wins over the BPM parameter, so flams and arps follow the session
+    const double bpm = transport.bpm > 0.0 ? transport.bpm : (double) juce::jmax(1.0f, parameters.bpm);
+    flamSamples = Flam::getDelaySeconds(parameters.flam, bpm) * sampleRate;
+
+    arpSettings.pattern = (Arpeggiator::Pattern) juce::jlimit(0, Arpeggiator::numPatterns - 1, parameters.arpMode);
+    arpSettings.rate = juce::jlimit(0, Arpeggiator::numRates - 1, parameters.arpRate);
+    arpSettings.gatePercent = juce::jlimit(10.0f, 100.0f, parameters.arpGatePercent);
+    arpSettings.customSteps = state.arpSteps;
+    arpSettings.numCustomSteps = juce::jlimit(0, Arpeggiator::maxPatternLength, (int) state.numArpSteps);
+
+    arpClock.samplesPerBeat = sampleRate * 60.0 / bpm;
+    arpClock.isLocked = transport.isPlaying && transport.hasPpqPosition;
+    arpClock.ppqAtBlockStart = transport.ppqPosition;
+    arpeggiator.syncToClock(blockStartTime, arpSettings, arpClock);
+    hostPpq = transport.hasPpqPosition ? transport.ppqPosition : -1.0;
+    sound = state.sound;
+
+    if (attackCache != nullptr)
+    {
+        // The cache renders for whatever presses are being played with right now
+        AttackCache::Settings settings;
+        settings.sampleRate = sampleRate;
+        settings.flamSamples = flamSamples;
+        settings.sustainPercent = sustainPercent;
+        settings.sampleStartMs = sampleStartMs;
+        settings.arpPattern = (int) arpSettings.pattern;
+        settings.arpRate = arpSettings.rate;
+
+        if (settings != cacheSettings)
+        {
+            cacheSettings = settings;
+            attackCache->setSettings(settings);
+        }
+
+        attackCache->updateTable(attackTable);
+    }
+
+    midiOutput.clear();
+    position = 0;
+
+    // Switching modes ends whatever the other mode was playing
+    if ((state.midiOutput != 0) != midiOutputMode)
+    {
+        stopAll();
+        midiOutputMode = state.midiOutput != 0;
+    }
+
+    updatePlayback();
+    voiceRenderer.beginBlock(voices.data(), maxVoices);
+
+    // An event from partway through the last block's period lands as far into this one.
+    // Commands arrive in the order they were posted, so their offsets never go backwards.
+    int numBlockCommands = 0;
+    commands.popAll([&](const ChordCommand& command) {
+        int offset = 0;
+        if (command.timestamp > 0.0 && lastBlockWallTime > 0.0)
+            offset = juce::roundToInt((command.timestamp - lastBlockWallTime) * 0.001 * sampleRate);
+
+        offset = juce::jlimit(numBlockCommands > 0 ? blockCommands[(size_t) numBlockCommands - 1].offset : 0,
+                              juce::jmax(0, numSamples - 1), offset);
+        blockCommands[(size_t) numBlockCommands++] = { command, offset };
+    });
+
+    lastBlockWallTime = blockWallTime;
+    int nextCommand = 0;
+
+    auto handleCommandsUntil = [&](int endPosition) {
+        for (; nextCommand < numBlockCommands && blockCommands[(size_t) nextCommand].offset <= endPosition; ++nextCommand)
+        {
+            renderUntil(buffer, juce::jmax(position, blockCommands[(size_t) nextCommand].offset));
+            handleCommand(state, blockCommands[(size_t) nextCommand], blockWallTime);
+        }
+    };
+
+    for (const auto metadata : midi)
+    {
+        const int eventPosition = juce::jlimit(position, numSamples, metadata.samplePosition);
+        handleCommandsUntil(eventPosition);
+        renderUntil(buffer, eventPosition);
+
+        const auto message = metadata.getMessage();
+        if (message.isNoteOn())
+        {
+            const int note = message.getNoteNumber();
+            playSlot(state, note % 12, juce::jlimit(0, AppStateModel::maxSlotsPerKey - 1, note / 12 - 5), note);
+        }
+        else if (message.isNoteOff())
+        {
+            releaseNote(message.getNoteNumber());
+        }
+        else if (message.isAllNotesOff() || message.isAllSoundOff())
+        {
+            stopAll();
+        }
+        else if (midiOutputMode)
+        {
+            midiOutput.addEvent(message, position); // Controllers, pitch bend etc. pass through to the synth
+        }
+    }
+
+    handleCommandsUntil(numSamples);
+    renderUntil(buffer, numSamples);
+    voiceRenderer.endBlock();
+    eq.process(buffer, 0, numSamples);
+
+    // Copied rather than swapped, so the reserve stays with midiOutput instead of going to the host
+    midi.clear();
+    midi.addEvents(midiOutput, 0, -1, 0);
+    blockStartTime += numSamples;
+}
+
+void ChordEngine::handleCommand(const EngineState& state, const TimedCommand& timed, double blockWallTime)
+{
+    const auto& command = timed.command;
+    const int source = ChordCommand::getTouchSource(command.touchIndex);
+    const auto touchBit = juce::isPositiveAndBelow((int) command.touchIndex, ChordCommand::maxTouches)
+                              ? (juce::uint32) 1 << command.touchIndex : 0u;
+
+    switch (command.type)
+    {
+        case ChordCommand::Type::playSlot:
+            // Held before it plays, so the new chord doesn't stop its own touch's notes
+            heldTouches |= touchBit;
+
+            if (playSlot(state, command.keyIndex, command.slotIndex, source)
+                && command.timestamp > 0.0 && measuringLatency.load(std::memory_order_relaxed))
+            {
+                // Input event to the press's sample, on the block's wall-clock timeline
+                latencyMeasurements.push(blockWallTime - command.timestamp + timed.offset * 1000.0 / sampleRate);
+            }
+            break;
+
+        case ChordCommand::Type::releaseTouch:
+            heldTouches &= ~touchBit;
+            releaseNote(source);
+            break;
+
+        case ChordCommand::Type::stopAll:
+            stopAll();
+            break;
+    }
+}
+
+void ChordEngine::renderUntil(juce::AudioBuffer<float>& buffer, int endPosition)
+{
+    // Chords of a progression being played back start at their exact sample
+    while (playback != nullptr && playbackIndex < playback->chords.size())
+    {
+        const auto& chord = playback->chords[playbackIndex];
+        const auto time = playbackStartTime + chord.time;
+        if (time >= blockStartTime + endPosition)
+            break;
+
+        renderSegment(buffer, (int) juce::jlimit((juce::int64) position, (juce::int64) endPosition, time - blockStartTime));
+        playVoicing(chord.voicing, -1);
+        ++playbackIndex;
+    }
+
+    renderSegment(buffer, endPosition);
+}
+
+void ChordEngine::renderSegment(juce::AudioBuffer<float>& buffer, int endPosition)
+{
+    // Arp steps due in this stretch start first, so they're rendered from their exact sample
+    Arpeggiator::Step step;
+    while (arpeggiator.getNextStep(blockStartTime, blockStartTime + endPosition, arpSettings, arpClock, step))
+        if (step.note >= 0)
+            startChordNote(step.note, step.time, step.length, arpeggiator.getSourceNote());
+
+    if (midiOutputMode)
+    {
+        scheduler.renderUntil(midiOutput, blockStartTime, blockStartTime + endPosition);
+    }
+    else
+    {
+        auto* left = buffer.getWritePointer(0, position);
+        auto* right = buffer.getNumChannels() > 1 ? buffer.getWritePointer(1, position) : nullptr;
+        render(left, right, endPosition - position);
+    }
+
+    position = endPosition;
+}
+
+bool ChordEngine::playSlot(const EngineState& state, int keyIndex, int slotIndex, int sourceNote)
+{
+    if (!state.isSlotEnabled(keyIndex, slotIndex))
+        return false;
+
+    const int index = AppStateModel::getFlatSlotIndex(keyIndex, slotIndex);
+    const Voicing& voicing = state.smoothVoicing != 0 ? VoiceLeading::chooseVoicing(state.candidates[index], &lastVoicing)
+                                                      : state.voicings[index];
+    if (!voicing.isPlayable())
+        return false;
+
+    if (recorder != nullptr && recorder->isRecording())
+    {
+        const double ppq = hostPpq >= 0.0 ? hostPpq + position / arpClock.samplesPerBeat : -1.0;
+        recorder->record(blockStartTime + position, ppq, keyIndex, slotIndex, voicing, getNoteLengthSamples());
+    }
+
+    playVoicing(voicing, sourceNote);
+    return true;
+}
+
+void ChordEngine::playVoicing(const Voicing& voicing, int sourceNote)
+{
+    // As in the reference, a new chord replaces whatever was sounding - other than
+    // chords a touch is still holding down
+    stopUnheld();
+
+    // The fader is applied while rendering, so it can move under held notes
+    chordNoteGain = SynthVoice::getChordNoteGain(voicing.numNotes);
+
+    const auto now = blockStartTime + position;
+    const auto length = getNoteLengthSamples();
+
+    if (arpSettings.isArpeggiating())
+    {
+        // MIDI- and touch-triggered chords are held until their release; playback has none
+        arpeggiator.start(voicing, sourceNote, now, sourceNote != -1 ? -1 : length);
+    }
+    else
+    {
+        juce::int8 order[Arpeggiator::maxPatternLength];
+        const int numSteps = arpeggiator.getStrumOrder(voicing, arpSettings, order);
+
+        // Bass included; the cached voices take over once its audio runs out
+        if (startCachedChord(voicing, order, numSteps, sourceNote))
+        {
+            lastVoicing = voicing;
+            return;
+        }
+
+        for (int i = 0; i < numSteps; ++i)
+        {
+            if (order[i] != Arpeggiator::rest)
+            {
+                const auto noteOnTime = now + (juce::int64) juce::roundToInt(i * flamSamples);
+                startChordNote(voicing.notes[order[i]], noteOnTime, length, sourceNote);
+            }
+        }
+    }
+
+    if (voicing.bassNote >= 0)
+        startBassNote(voicing.bassNote, sourceNote);
+
+    lastVoicing = voicing;
+}
+
+void ChordEngine::startChordNote(int midiNote, juce::int64 time, juce::int64 lengthSamples, int sourceNote)
+{
+    const auto now = blockStartTime + position;
+    jassert(time >= now);
+
+    if (midiOutputMode)
+    {
+        // Velocities follow the fader; a side that's faded right out isn't sent at all
+        if (const int velocity = juce::roundToInt(127.0f * fader.getTargetValue()); velocity > 0)
+        {
+            scheduler.scheduleNoteOn(time, chordChannel, midiNote, velocity, sourceNote);
+            scheduler.scheduleNoteOff(time + lengthSamples, chordChannel, midiNote, sourceNote);
+        }
+    }
+    else
+    {
+        startVoice(midiNote, chordNoteGain, false, sourceNote, (int) juce::jmax((juce::int64) 0, time - now),
+                   (int) juce::jmin(lengthSamples, (juce::int64) std::numeric_limits<int>::max()));
+    }
+}
+
+void ChordEngine::startBassNote(int midiNote, int sourceNote)
+{
+    const auto length = getNoteLengthSamples();
+
+    if (midiOutputMode)
+    {
+        if (const int velocity = juce::roundToInt(127.0f * (1.0f - fader.getTargetValue())); velocity > 0)
+        {
+            const auto now = blockStartTime + position;
+            scheduler.scheduleNoteOn(now, bassChannel, midiNote, velocity, sourceNote);
+            scheduler.scheduleNoteOff(now + length, bassChannel, midiNote, sourceNote);
+        }
+    }
+    else
+    {
+        startVoice(midiNote, SynthVoice::noteGain * SynthVoice::bassGain, true, sourceNote, 0, (int) length);
+    }
+}
+
+juce::int64 ChordEngine::getNoteLengthSamples() const noexcept
+{
+    return SynthVoice::getNoteLengthSamples(sustainPercent, sampleRate);
+}
+
+void ChordEngine::releaseNote(int sourceNote)
+{
+    arpeggiator.release(sourceNote);
+    scheduler.stopSource(blockStartTime + position, sourceNote);
+
+    for (auto& player : attackPlayers)
+        if (player.entry != nullptr && player.sourceNote == sourceNote && player.releaseStep == 0.0f)
+            stopAttackPlayer(player, SynthVoice::releaseSeconds);
+
+    for (auto& voice : voices)
+        if (voice.active && voice.sourceNote == sourceNote && voice.releaseStep == 0.0f)
+            voice.stop(SynthVoice::releaseSeconds, sampleRate);
+}
+
+void ChordEngine::stopAll()
+{
+    heldTouches = 0;
+    arpeggiator.stop();
+    scheduler.stopAll(blockStartTime + position);
+
+    for (auto& player : attackPlayers)
+        if (player.entry != nullptr)
+            stopAttackPlayer(player, chordStopSeconds);
+
+    for (auto& voice : voices)
+        if (voice.active)
+            voice.stop(chordStopSeconds, sampleRate);
+}
+
+bool ChordEngine::isHeld(int sourceNote) const noexcept
+{
+    const int touchIndex = -2 - sourceNote;
+    return juce::isPositiveAndBelow(touchIndex, ChordCommand::maxTouches) && (heldTouches & ((juce::uint32) 1 << touchIndex)) != 0;
+}
+
+void ChordEngine::stopUnheld()
+{
+    if (heldTouches == 0)
+    {
+        stopAll();
+        return;
+    }
+
+    // The arp only ever follows the newest chord
+    arpeggiator.stop();
+    scheduler.stopWhere(blockStartTime + position, [this](int source) { return !isHeld(source); });
+
+    for (auto& player : attackPlayers)
+        if (player.entry != nullptr && !isHeld(player.sourceNote))
+            stopAttackPlayer(player, chordStopSeconds);
+
+    for (auto& voice : voices)
+        if (voice.active && !isHeld(voice.sourceNote))
+            voice.stop(chordStopSeconds, sampleRate);
+}
+
+void ChordEngine::setTuning(TuningManager* tuningToUse)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    tuning = tuningToUse;
+    if (tuning != nullptr)
+        tuningTable = tuning->getCurrentTable();
+}
+
+void ChordEngine::setPlayback(RecordedProgression::Ptr progression)
+{
+    // Playback only changes here, so anything from earlier the audio thread is done with goes now
+    playbackHandoff.releaseUnused();
+    playbackHandoff.publish(progression);
+}
+
+void ChordEngine::updatePlayback()
+{
+    if (!playbackHandoff.tryTake(playback))
+        return;
+
+    playbackIndex = 0;
+    playbackStartTime = blockStartTime;
+
+    if (playback == nullptr)
+        stopAll();
+}
+
+int ChordEngine::getNumActiveVoices() const noexcept
+{
+    int count = 0;
+    for (const auto& voice : voices)
+        count += voice.active ? 1 : 0;
+
+    return count;
+}
+
+SynthVoice& ChordEngine::allocateVoice() noexcept
+{
+    // A free voice, or failing that the quietest one
+    SynthVoice* target = nullptr;
+    for (auto& voice : voices)
+    {
+        if (!voice.active)
+            return voice;
+
+        if (target == nullptr || voice.getLoudness() < target->getLoudness())
+            target = &voice;
+    }
+
+    return *target;
+}
+
+void ChordEngine::startVoice(int midiNote, float gain, bool isBass, int sourceNote, int startDelay, int lengthSamples)
+{
+    const float frequency = tuningTable->getFrequency(midiNote);
+    if (frequency <= 0.0f)
+        return; // Left unmapped by the keyboard map
+
+    allocateVoice().start(frequency, gain, isBass, sourceNote, startDelay, lengthSamples, voiceShape);
+}
+
+bool ChordEngine::startCachedChord(const Voicing& voicing, const juce::int8* order, int numSteps, int sourceNote)
+{
+    if (attackTable == nullptr || midiOutputMode)
+        return false;
+
+    AttackCache::Key key;
+    key.voicing = voicing;
+    key.numSteps = numSteps;
+    std::copy(order, order + numSteps, key.order);
+    key.flamSamples = flamSamples;
+    key.sustainPercent = sustainPercent;
+    key.sampleStartMs = sampleStartMs;
+    key.sampleRate = sampleRate;
+    key.sound = sound;
+    key.setTuning(*tuningTable);
+
+    const auto* entry = attackTable->find(key);
+    if (entry == nullptr)
+        return false;
+
+    auto* player = std::find_if(attackPlayers.begin(), attackPlayers.end(), [](const AttackPlayer& p) { return p.entry == nullptr; });
+    if (player == attackPlayers.end())
+        return false;
+
+    *player = AttackPlayer();
+    player->table = attackTable;
+    player->entry = entry;
+    player->sourceNote = sourceNote;
+
+    // The voices carry on from the end of the cached audio
+    for (int i = 0; i < entry->numVoices; ++i)
+    {
+        const auto& cached = entry->voices[(size_t) i];
+        if (!cached.active)
+            continue;
+
+        auto& voice = allocateVoice();
+        voice = cached;
+        voice.sourceNote = sourceNote;
+        voice.startDelay += entry->getNumSamples();
+    }
+
+    ++numCachedPresses;
+    return true;
+}
+
+void ChordEngine::stopAttackPlayer(AttackPlayer& player, float seconds)
+{
+    const float step = 1.0f / juce::jmax(1.0f, seconds * (float) sampleRate);
+    player.releaseStep = player.releaseStep > 0.0f ? juce::jmax(player.releaseStep, step) : step;
+
+    // Voices that were sounding in the cached audio take over partway through the fade,
+    // at the gain it will have reached by then; ones still waiting on their flam are dropped
+    const int remaining = player.entry->getNumSamples() - player.position;
+    const float gainAtHandover = player.releaseGain - player.releaseStep * (float) remaining;
+
+    for (auto& voice : voices)
+    {
+        if (voice.active && voice.sourceNote == player.sourceNote && voice.startDelay == remaining)
+        {
+            voice.active = gainAtHandover > 0.0f;
+            voice.releaseStep = player.releaseStep;
+            voice.releaseGain = gainAtHandover;
+        }
+    }
+}
+
+void ChordEngine::render(float* left, float* right, int numSamples)
+{
+    // The gain buffers hold maxBlockSize samples, so a host that sends a longer block than it
+    // prepared for is rendered in pieces rather than cut short
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+    {
+        const int numThisTime = juce::jmin(maxBlockSize, numSamples - start);
+        auto* chunkLeft = left + start;
+        auto* chunkRight = right != nullptr ? right + start : nullptr;
+
+        // One fader ramp shared by every voice
+        for (int i = 0; i < numThisTime; ++i)
+        {
+            const float faderValue = fader.getNextValue();
+            chordGains[i] = faderValue;
+            bassGains[i] = 1.0f - faderValue;
+        }
+
+        voiceRenderer.render(voices.data(), maxVoices, chunkLeft, chunkRight, chordGains.get(), bassGains.get(), numThisTime);
+
+        renderAttackPlayers(chunkLeft, chunkRight, numThisTime);
+    }
+}
+
+void ChordEngine::renderAttackPlayers(float* left, float* right, int numSamples)
+{
+    for (auto& player : attackPlayers)
+    {
+        if (player.entry == nullptr)
+            continue;
+
+        const auto* chord = player.entry->chord.getReadPointer(0, player.position);
+        const auto* bass = player.entry->bass.getReadPointer(0, player.position);
+        const int numToPlay = juce::jmin(numSamples, player.entry->getNumSamples() - player.position);
+        bool finished = player.position + numToPlay >= player.entry->getNumSamples();
+
+        for (int i = 0; i < numToPlay; ++i)
+        {
+            const float sample = (chord[i] * chordGains[i] + bass[i] * bassGains[i]) * player.releaseGain;
+            left[i] += sample;
+            if (right != nullptr)
+                right[i] += sample;
+
+            if (player.releaseStep > 0.0f)
+            {
+                player.releaseGain -= player.releaseStep;
+                if (player.releaseGain <= 0.0f)
+                {
+                    finished = true;
+                    break;
+                }
+            }
+        }
+
+        player.position += numToPlay;
+
+        // Dropping the table here never frees it: the cache's pool still holds it
+        if (finished)
+            player = AttackPlayer();
+    }
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include "EngineState.h"
+#include "CommandQueue.h"
+#include "PluginParameters.h"
+#include "ThreeBandEq.h"
+#include "MidiNoteScheduler.h"
+#include "Arpeggiator.h"
+#include "PerformanceRecorder.h"
+#include "RealtimeHandoff.h"
+#include "SynthVoice.h"
+#include "TuningManager.h"
+#include "AttackCache.h"
+#include "VoiceRenderPool.h"
+
+// A request from the UI, queued for the audio thread
+struct ChordCommand
+{
+    enum class Type : juce::uint8 { playSlot, releaseTouch, stopAll };
+
+    static constexpr int maxTouches = 10;
+
+    Type type = Type::playSlot;
+    juce::int8 keyIndex = 0;
+    juce::int8 slotIndex = 0;
+    juce::int8 touchIndex = -1;       // Pointer holding the chord, -1 for a one-shot press
+    double timestamp = 0.0;           // Time::getMillisecondCounterHiRes() of the input event, 0 = next block
+
+    // Voices a touch starts are tagged with this in place of a MIDI note number
+    static int getTouchSource(int touchIndex) noexcept { return touchIndex >= 0 ? -2 - touchIndex : -1; }
+};
+
+//==============================================================================
+// Audio-thread chord player. Key presses arrive either as ChordCommands from the
+// UI or as MIDI notes from the host, and are turned into voices using the prebuilt
+// voicings in EngineState. Follows playChord/playBassNote in audio-utils.ts: a new
+// chord stops the previous one, each note decays towards the sustain level over two
+// seconds and the bass plays at 0.85 x (1 - fader).
+//
+// Continuous parameters (fader, EQ) are ramped sample by sample from wherever they
+// were to the value read at the start of each block, so dense automation doesn't
+// zipper. Per-note parameters (sustain, sample start) are read once per block too,
+// and every note started in the block uses those values; JUCE gives no automation
+// points within a block to read them at each note-on.
+//
+// MIDI input: note number % 12 picks the key, and the octave picks the slot
+// (C4 and below = slot 0, C5 = slot 1, C6 and up = slot 2).
+//
+// UI presses are held by their touch until its releaseTouch, like a MIDI note, and
+// several touches can hold chords at once: a new chord only stops the ones that
+// nothing holds any more. A timestamped command lands at the same offset into the
+// block as its input event had into the previous block's period, so every press
+// sees one steady block of latency instead of however much happened to be left of
+// the block it arrived in.
+//
+// Flam staggers the chord notes by getFlamDelay's interval, in the arp pattern's order
+// (upwards when the arp is off). At the other arp rates the chord is held and stepped
+// through one note at a time, locked to the host's beat grid while its transport runs;
+// MIDI- and touch-triggered chords are held until their release, playback chords for the
+// sustain time.
+// The bass always plays with the press.
+//
+// Voices sound at the TuningManager's table, looked up at note-on; without one they're
+// in 12-TET at A4 = 440 Hz. MIDI output is note numbers, so tuning doesn't touch it.
+//
+// With an AttackCache attached, a press whose chord is in the cache starts by playing
+// the cached opening and hands over to live voices where it ends, so the voices'
+// first stretch isn't computed at the moment of the press.
+//
+// Dense polyphony (held touches, long sustains) is rendered across the worker threads
+// every instance's VoiceRenderPool shares; light loads stay on the audio thread.
+//
+// Every press is handed to the PerformanceRecorder while it records, and a recorded
+// progression can be played back with each chord landing on its original sample
+// offset from the first. With MIDI_OUTPUT
+// on, nothing is synthesised: the chord (channel 1) and bass (channel 2) are written
+// to the output MidiBuffer at their exact sample offsets instead, with velocities from
+// the fader. Note-offs and flammed note-ons that land in later blocks wait in a
+// fixed-capacity MidiNoteScheduler.
+class ChordEngine
+{
+public:
+    static constexpr int maxVoices = 128;
+
+    // The host's transport for one block, from its play head where it has one
+    struct Transport
+    {
+        double bpm = 0.0;             // 0 = no host tempo; the BPM parameter is used instead
+        bool isPlaying = false;
+        bool hasPpqPosition = false;
+        double ppqPosition = 0.0;     // Beats at the block's first sample
+    };
+
+    ChordEngine() = default;
+
+    void prepare(double newSampleRate, int maximumBlockSize);
+    void reset();
+
+    // Message thread. Returns false if the queue is full and the command was dropped.
+    bool postCommand(const ChordCommand& command) { return commands.push(command); }
+
+    // Message thread. While measuring, every timestamped press that starts a chord
+    // queues the milliseconds from its input event to its first sample in the output
+    // block; the device's own output latency comes on top.
+    void setMeasuringLatency(bool shouldMeasure) noexcept { measuringLatency = shouldMeasure; }
+    bool isMeasuringLatency() const noexcept { return measuringLatency.load(); }
+
+    template <typename Handler>
+    void popLatencyMeasurements(Handler&& handler) { latencyMeasurements.popAll(handler); }
+
+    // Message thread, before playback starts. Presses are recorded while it's recording.
+    void setRecorder(PerformanceRecorder* recorderToUse) noexcept { recorder = recorderToUse; }
+
+    // Message thread, before playback starts. Presses use its prerendered openings where they can.
+    void setAttackCache(AttackCache* cacheToUse) noexcept { attackCache = cacheToUse; }
+
+    // Message thread, before playback starts. Voices follow its tuning from then on.
+    void setTuning(TuningManager* tuningToUse);
+
+    // Message thread. Plays progression from the start of the next block; nullptr stops
+    // playback.
+    void setPlayback(RecordedProgression::Ptr progression);
+
+    // Audio thread. Adds the engine's output to buffer; MIDI events are applied at
+    // their sample positions. On return midi holds the MIDI output: the generated notes
+    // plus any non-note input in MIDI_OUTPUT mode, nothing otherwise.
+    void process(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi, const EngineState& state,
+                 const PluginParameters::Values& parameters, const Transport& transport = {});
+
+    // Audio thread. Act at the current position within the block being processed.
+    // playSlot returns false if the slot had no chord to play.
+    bool playSlot(const EngineState& state, int keyIndex, int slotIndex, int sourceNote = -1);
+    void releaseNote(int sourceNote);
+    void stopAll();
+
+    int getNumActiveVoices() const noexcept;
+
+    // Audio thread, or while no block is being processed
+    const std::array<SynthVoice, maxVoices>& getVoices() const noexcept { return voices; }
+
+    // Presses that started from the attack cache, since prepare()
+    int getNumCachedPresses() const noexcept { return numCachedPresses.load(); }
+
+private:
+    struct TimedCommand
+    {
+        ChordCommand command;
+        int offset = 0;               // Samples into the block
+    };
+
+    static constexpr int commandQueueCapacity = 64;
+
+    void handleCommand(const EngineState& state, const TimedCommand& timed, double blockWallTime);
+    bool isHeld(int sourceNote) const noexcept;
+    void stopUnheld();
+
+    // A cached chord's opening, played back while its voices wait to take over
+    struct AttackPlayer
+    {
+        AttackCache::Table::Ptr table;    // Keeps entry alive; the cache frees tables, never the audio thread
+        const AttackCache::Entry* entry = nullptr;
+        int sourceNote = -1;
+        int position = 0;
+        float releaseStep = 0.0f;
+        float releaseGain = 1.0f;
+    };
+
+    static constexpr int maxAttackPlayers = 4;
+
+    SynthVoice& allocateVoice() noexcept;
+    void startVoice(int midiNote, float gain, bool isBass, int sourceNote, int startDelay, int lengthSamples);
+    void playVoicing(const Voicing& voicing, int sourceNote);
+    bool startCachedChord(const Voicing& voicing, const juce::int8* order, int numSteps, int sourceNote);
+    void renderAttackPlayers(float* left, float* right, int numSamples);
+    void stopAttackPlayer(AttackPlayer& player, float seconds);
+    void updatePlayback();
+
+    // Starts one note at time (at or after the current position), as a voice or as scheduled MIDI
+    void startChordNote(int midiNote, juce::int64 time, juce::int64 lengthSamples, int sourceNote);
+    void startBassNote(int midiNote, int sourceNote);
+    juce::int64 getNoteLengthSamples() const noexcept;
+
+    void renderUntil(juce::AudioBuffer<float>& buffer, int endPosition);
+    void renderSegment(juce::AudioBuffer<float>& buffer, int endPosition);
+    void render(float* left, float* right, int numSamples);
+
+    CommandQueue<ChordCommand, commandQueueCapacity> commands;
+    std::array<TimedCommand, commandQueueCapacity> blockCommands; // This block's, in offset order
+    double lastBlockWallTime = 0.0;   // Millisecond counter at the previous block's start
+    juce::uint32 heldTouches = 0;     // Bit per touch whose chord is still held
+
+    std::atomic<bool> measuringLatency { false };
+    CommandQueue<double, commandQueueCapacity> latencyMeasurements;
+    std::array<SynthVoice, maxVoices> voices;
+    VoiceRenderPool voiceRenderer;
+
+    Voicing lastVoicing;              // Previous chord, for smooth voicing
+    double sampleRate = 44100.0;
+    float sustainPercent = 100.0f;    // 10..200, as currentSustain in audio-utils.ts
+    float sampleStartMs = 0.0f;       // 0..500, as currentSampleStart
+    SynthVoice::Shape voiceShape;     // For the three above, redone only when one changes
+    float shapeSustainPercent = -1.0f, shapeSampleStartMs = -1.0f;
+
+    TuningManager* tuning = nullptr;
+    TuningTable::Ptr tuningTable { TuningTable::createEqualTemperament(TuningTable::defaultA4) }; // The manager's are never freed here
+
+    juce::SmoothedValue<float> fader { 0.25f };
+    juce::HeapBlock<float> chordGains, bassGains; // Per-sample fader ramp, sized in prepare()
+    int maxBlockSize = 0;
+    ThreeBandEq eq;
+
+    MidiNoteScheduler scheduler;
+    juce::MidiBuffer midiOutput;      // Preallocated in prepare(), copied into the host's buffer
+    juce::int64 blockStartTime = 0;   // Sample clock at the start of the current block
+    int position = 0;                 // Current position within the block
+    double flamSamples = 0.0;
+    bool midiOutputMode = false;
+
+    Arpeggiator arpeggiator;
+    Arpeggiator::Settings arpSettings; // Read at the start of each block
+    Arpeggiator::Clock arpClock;
+    float chordNoteGain = 0.0f;        // Per-note level of the chord being played
+
+    AttackCache* attackCache = nullptr;
+    AttackCache::Settings cacheSettings;    // Last published to the cache
+    AttackCache::Table::Ptr attackTable;
+    std::array<AttackPlayer, maxAttackPlayers> attackPlayers;
+    int sound = 0;                          // SELECTED_SOUND, part of every cache key
+    std::atomic<int> numCachedPresses { 0 };
+
+    PerformanceRecorder* recorder = nullptr;
+    double hostPpq = -1.0;             // Host beat position at the block start, -1 if unknown
+
+    RealtimeHandoff<RecordedProgression> playbackHandoff; // Progressions are freed in setPlayback()
+    RecordedProgression::Ptr playback;
+    size_t playbackIndex = 0;
+    juce::int64 playbackStartTime = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChordEngine)
+};
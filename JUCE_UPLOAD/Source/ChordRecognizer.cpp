@@ -0,0 +1,258 @@
+#include "ChordRecognizer.h"
+#include <algorithm>
+#include <array>
+
+namespace ChordRecognizer
+{
+    namespace
+    {
+        constexpr int numMasks = 1 << MusicTheory::numPitchClasses;
+        constexpr int drumChannel = 9;
+
+        juce::uint16 rotate(juce::uint16 mask, int semitones) noexcept
+        {
+            const juce::uint32 wide = (juce::uint32) mask << semitones;
+            return (juce::uint16) ((wide | (wide >> MusicTheory::numPitchClasses)) & 0x0fff);
+        }
+
+        juce::uint16 getChordTypeMask(int chordTypeId) noexcept
+        {
+            const auto& type = MusicTheory::getChordType(chordTypeId);
+
+            juce::uint16 mask = 0;
+            for (int i = 0; i < type.numIntervals; ++i)
+                mask |= (juce::uint16) (1 << MusicTheory::wrapPitchClass(type.intervals[i]));
+
+            return mask;
+        }
+
+        // Best root and chord type for every pitch-class set and bass, -1 where nothing fits
+        struct MatchTable
+        {
+            struct Match
+            {
+                juce::int8 root = -1, chordType = -1;
+            };
+
+            std::array<Match, (size_t) numMasks * MusicTheory::numPitchClasses> matches;
+
+            MatchTable()
+            {
+                const int numChordTypes = MusicTheory::getNumChordTypes();
+
+                struct Candidate
+                {
+                    int root, chordType, numTones;
+                };
+
+                std::vector<Candidate> candidates;
+                candidates.reserve((size_t) numChordTypes * MusicTheory::numPitchClasses);
+
+                std::vector<juce::uint16> typeMasks;
+                for (int type = 0; type < numChordTypes; ++type)
+                    typeMasks.push_back(getChordTypeMask(type));
+
+                for (int mask = 1; mask < numMasks; ++mask)
+                {
+                    const int numNotes = juce::countNumberOfBits((juce::uint32) mask);
+
+                    candidates.clear();
+                    for (int type = 0; type < numChordTypes; ++type)
+                    {
+                        const int numTones = juce::countNumberOfBits((juce::uint32) typeMasks[(size_t) type]);
+
+                        // A two-note type (the power chord) only when it's all there is
+                        if (numTones * 2 < numNotes || (numTones < 3 && numTones != numNotes))
+                            continue;
+
+                        for (int root = 0; root < MusicTheory::numPitchClasses; ++root)
+                        {
+                            const auto chordMask = rotate(typeMasks[(size_t) type], root);
+                            if ((chordMask & ~mask) == 0)
+                                candidates.push_back({ root, type, numTones });
+                        }
+                    }
+
+                    for (int bass = 0; bass < MusicTheory::numPitchClasses; ++bass)
+                    {
+                        if ((mask & (1 << bass)) == 0)
+                            continue;
+
+                        // Most notes covered, then rooted on the bass, then the bass in the chord
+                        int bestScore = -1;
+                        auto& match = matches[getIndex(mask, bass)];
+
+                        for (const auto& candidate : candidates)
+                        {
+                            const bool bassIsChordTone = (rotate(typeMasks[(size_t) candidate.chordType], candidate.root) & (1 << bass)) != 0;
+                            const int score = candidate.numTones * 4 + (candidate.root == bass ? 2 : 0) + (bassIsChordTone ? 1 : 0);
+
+                            if (score > bestScore)
+                            {
+                                bestScore = score;
+                                match.root = (juce::int8) candidate.root;
+                                match.chordType = (juce::int8) candidate.chordType;
+                            }
+                        }
+                    }
+                }
+            }
+
+            static size_t getIndex(int mask, int bass) noexcept
+            {
+                return (size_t) mask * MusicTheory::numPitchClasses + (size_t) bass;
+            }
+        };
+
+        const MatchTable& getMatchTable()
+        {
+            static const MatchTable table;
+            return table;
+        }
+    }
+
+    Chord recognise(juce::uint16 pitchClassMask, int bassPitchClass) noexcept
+    {
+        bassPitchClass = MusicTheory::wrapPitchClass(bassPitchClass);
+        pitchClassMask = (juce::uint16) ((pitchClassMask | (1 << bassPitchClass)) & 0x0fff);
+
+        const auto& match = getMatchTable().matches[MatchTable::getIndex(pitchClassMask, bassPitchClass)];
+
+        Chord chord;
+        if (match.chordType < 0)
+            return chord;
+
+        chord.root = match.root;
+        chord.chordType = match.chordType;
+        chord.bassOffset = MusicTheory::wrapPitchClass(bassPitchClass - chord.root);
+        chord.inversion = -1;
+
+        const auto& type = MusicTheory::getChordType(chord.chordType);
+        for (int i = 0; i < type.numIntervals; ++i)
+        {
+            if (MusicTheory::wrapPitchClass(type.intervals[i]) == chord.bassOffset)
+            {
+                chord.inversion = i;
+                break;
+            }
+        }
+
+        return chord;
+    }
+
+    void estimateKey(const double (&durations)[MusicTheory::numPitchClasses], int& key, int& modeIndex) noexcept
+    {
+        key = 0;
+        modeIndex = (int) MusicTheory::Mode::free;
+
+        double total = 0.0;
+        for (auto duration : durations)
+            total += duration;
+
+        if (total <= 0.0)
+            return;
+
+        // Time in the scale against time outside it; relative major and minor share a
+        // scale, so the tonic triad's time decides between them
+        double bestScore = -std::numeric_limits<double>::max();
+        for (const auto mode : { MusicTheory::Mode::major, MusicTheory::Mode::minor })
+        {
+            const int third = mode == MusicTheory::Mode::major ? 4 : 3;
+
+            for (int tonic = 0; tonic < MusicTheory::numPitchClasses; ++tonic)
+            {
+                const auto scale = MusicTheory::getScaleMask(tonic, (int) mode);
+
+                double inScale = 0.0;
+                for (int pitchClass = 0; pitchClass < MusicTheory::numPitchClasses; ++pitchClass)
+                    if ((scale & (1 << pitchClass)) != 0)
+                        inScale += durations[pitchClass];
+
+                const double triad = durations[tonic] + durations[MusicTheory::wrapPitchClass(tonic + third)]
+                                   + durations[MusicTheory::wrapPitchClass(tonic + 7)];
+                const double score = 2.0 * inScale - total + 0.5 * triad;
+
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    key = tonic;
+                    modeIndex = (int) mode;
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    void analyse(const std::vector<SmfReader::Note>& notes, juce::int64 groupingTicks, Analysis& analysis)
+    {
+        auto& chords = analysis.chords;
+        auto& sounding = analysis.sounding;
+        chords.clear();
+        sounding.clear();
+
+        double durations[MusicTheory::numPitchClasses] = {};
+        bool isOpen = false;          // The last chord is still sounding
+        juce::int64 openEnd = 0;      // When its notes run out, unless another chord takes over first
+
+        for (size_t next = 0; next < notes.size();)
+        {
+            const auto onset = notes[next].start;
+            const auto groupEnd = onset + juce::jmax((juce::int64) 0, groupingTicks);
+
+            // Notes held from earlier onsets go once they've stopped; this onset's notes all count
+            sounding.erase(std::remove_if(sounding.begin(), sounding.end(),
+                                          [&notes, groupEnd](size_t i) { return notes[i].end <= groupEnd; }),
+                           sounding.end());
+
+            for (; next < notes.size() && notes[next].start <= groupEnd; ++next)
+            {
+                const auto& note = notes[next];
+                if (note.channel == drumChannel)
+                    continue;
+
+                sounding.push_back(next);
+                durations[note.note % MusicTheory::numPitchClasses] += (double) (note.end - note.start);
+            }
+
+            juce::uint16 mask = 0;
+            int bassNote = 128;
+            juce::int64 soundingEnd = onset;
+            for (auto i : sounding)
+            {
+                mask |= (juce::uint16) (1 << (notes[i].note % MusicTheory::numPitchClasses));
+                bassNote = juce::jmin(bassNote, (int) notes[i].note);
+                soundingEnd = juce::jmax(soundingEnd, notes[i].end);
+            }
+
+            const auto chord = sounding.empty() ? Chord() : recognise(mask, bassNote);
+
+            if (isOpen && chord.isValid())
+            {
+                const auto& last = chords.back().chord;
+                if (last.root == chord.root && last.chordType == chord.chordType && last.bassOffset == chord.bassOffset)
+                {
+                    openEnd = juce::jmax(openEnd, soundingEnd);
+                    continue;
+                }
+            }
+
+            if (isOpen)
+            {
+                chords.back().end = juce::jmin(openEnd, onset);
+                isOpen = false;
+            }
+
+            if (chord.isValid())
+            {
+                chords.push_back({ onset, soundingEnd, chord, bassNote });
+                openEnd = soundingEnd;
+                isOpen = true;
+            }
+        }
+
+        if (isOpen)
+            chords.back().end = openEnd;
+
+        estimateKey(durations, analysis.key, analysis.modeIndex);
+    }
+}
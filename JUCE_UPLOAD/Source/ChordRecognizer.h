@@ -0,0 +1,57 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "MusicTheory.h"
+#include "SmfReader.h"
+
+// Names the chords in a set of notes, using MusicTheory's chord types - the reverse of
+// VoicingEngine. Every pitch-class set (and bass) is looked up in a table built once,
+// so labelling costs the same whatever the chord.
+//
+// A chord type matches when all of its pitch classes sound; the match covering the
+// most notes wins, then one rooted on the bass, then the earlier chord type. Notes
+// outside the chord are allowed as long as the chord covers at least half of them.
+namespace ChordRecognizer
+{
+    struct Chord
+    {
+        int root = -1;           // Pitch class
+        int chordType = -1;      // MusicTheory chord type id, -1 if nothing matched
+        int bassOffset = 0;      // Semitones from the root to the bass, as a slot's BASS_OFFSET
+        int inversion = 0;       // Which of the chord type's intervals is in the bass, -1 for none
+
+        bool isValid() const noexcept { return chordType >= 0; }
+    };
+
+    // Bit n set = pitch class n sounds. Thread-safe.
+    Chord recognise(juce::uint16 pitchClassMask, int bassPitchClass) noexcept;
+
+    // Scale (from MusicTheory::getScaleMask) that best explains how long each pitch class
+    // sounded, major or minor; MusicTheory::Mode::free if nothing sounded.
+    void estimateKey(const double (&durations)[MusicTheory::numPitchClasses], int& key, int& modeIndex) noexcept;
+
+    //==============================================================================
+    struct Segment
+    {
+        juce::int64 start = 0, end = 0; // Ticks
+        Chord chord;
+        int bassNote = 0;               // Lowest note sounding at the start
+    };
+
+    // The chords of a whole file. Reused across files, so its buffers stop growing.
+    struct Analysis
+    {
+        std::vector<Segment> chords;
+        int key = 0;
+        int modeIndex = 0;
+
+        std::vector<size_t> sounding;   // Scratch
+    };
+
+    // Labels the sounding notes at every onset (notes starting within groupingTicks of
+    // each other count as one onset, so a rolled chord is one chord). Runs of the same
+    // chord are merged; onsets that aren't a chord end the one before. Notes must be
+    // sorted by start, as SmfReader gives them; the GM drum channel is ignored.
+    void analyse(const std::vector<SmfReader::Note>& notes, juce::int64 groupingTicks, Analysis& analysis);
+}
@@ -0,0 +1,216 @@
+#include <JuceHeader.h>
+#include "SmfReader.h"
+#include "ChordRecognizer.h"
+#include <atomic>
+#include <iostream>
+
+// Batch chord analysis of MIDI file collections, for seeding memory banks from large
+// libraries. Every .mid/.midi file under the given paths is labelled chord by chord
+// (root, chord type, bass, inversion) with an estimated key, and the result written
+// as a small tab-separated text file.
+//
+// Usage: PianoXLChordScan [--output DIR] [--threads N] PATH...
+// Results go next to each file as NAME.chords.txt, or under DIR mirroring the layout of
+// the scanned folders. Files are shared out across all cores; each is memory-mapped and
+// parsed in place. Exits non-zero if any file couldn't be read or written.
+
+namespace
+{
+    struct Options
+    {
+        juce::Array<juce::File> paths;
+        juce::File outputDirectory;
+        int numThreads = juce::SystemStats::getNumCpus();
+    };
+
+    Options parseOptions(const juce::StringArray& args)
+    {
+        Options options;
+        for (int i = 0; i < args.size(); ++i)
+        {
+            const auto next = i + 1 < args.size() ? args[i + 1] : juce::String();
+
+            if (args[i] == "--output")       { options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(next); ++i; }
+            else if (args[i] == "--threads") { options.numThreads = juce::jlimit(1, 256, next.getIntValue()); ++i; }
+            else                             { options.paths.add(juce::File::getCurrentWorkingDirectory().getChildFile(args[i])); }
+        }
+        return options;
+    }
+
+    // One file to scan, and the folder it was found under so the output can mirror it
+    struct Job
+    {
+        juce::File file, root;
+    };
+
+    //==============================================================================
+    class ChordScan
+    {
+    public:
+        explicit ChordScan(const Options& optionsToUse)
+            : options(optionsToUse)
+        {
+        }
+
+        int run()
+        {
+            for (const auto& path : options.paths)
+            {
+                if (path.isDirectory())
+                {
+                    // Wildcards match case-sensitively on some systems; hasFileExtension() never does
+                    for (const auto& file : path.findChildFiles(juce::File::findFiles, true))
+                        if (file.hasFileExtension("mid;midi"))
+                            jobs.push_back({ file, path });
+                }
+                else if (path.existsAsFile())
+                {
+                    jobs.push_back({ path, path.getParentDirectory() });
+                }
+                else
+                {
+                    std::cout << "Not found: " << path.getFullPathName() << std::endl;
+                    ++numFailed;
+                }
+            }
+
+            if (jobs.empty())
+            {
+                std::cout << "Usage: PianoXLChordScan [--output DIR] [--threads N] PATH..." << std::endl;
+                return 1;
+            }
+
+            const auto startTime = juce::Time::getMillisecondCounterHiRes();
+            const int numWorkers = juce::jmin(options.numThreads, (int) jobs.size());
+            numWorkersLeft = numWorkers;
+
+            {
+                // Workers take the next file as they finish one, so a few huge files don't
+                // leave the other cores idle
+                juce::ThreadPool pool(numWorkers);
+                for (int i = 0; i < numWorkers; ++i)
+                    pool.addJob([this] { runWorker(); });
+
+                allDone.wait();
+            }
+
+            const double seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+            std::cout << "Scanned " << numScanned.load() << " file(s), " << numChords.load() << " chord(s) in "
+                      << juce::String(seconds, 2) << " s on " << numWorkers << " thread(s)";
+            if (numFailed > 0)
+                std::cout << "; " << numFailed.load() << " failed";
+            std::cout << std::endl;
+
+            return numFailed == 0 ? 0 : 1;
+        }
+
+    private:
+        // Buffers are the worker's own and reused from file to file
+        struct Worker
+        {
+            std::vector<SmfReader::Note> notes;
+            ChordRecognizer::Analysis analysis;
+            juce::MemoryOutputStream output;
+        };
+
+        void runWorker()
+        {
+            Worker worker;
+
+            for (size_t i = nextJob++; i < jobs.size(); i = nextJob++)
+            {
+                juce::String error;
+                if (scanFile(jobs[i], worker, error))
+                {
+                    ++numScanned;
+                }
+                else
+                {
+                    ++numFailed;
+                    const juce::ScopedLock sl(outputLock);
+                    std::cout << jobs[i].file.getFullPathName() << ": " << error << std::endl;
+                }
+            }
+
+            if (--numWorkersLeft == 0)
+                allDone.signal();
+        }
+
+        bool scanFile(const Job& job, Worker& worker, juce::String& error)
+        {
+            SmfReader::Header header;
+            {
+                const juce::MemoryMappedFile mapped(job.file, juce::MemoryMappedFile::readOnly);
+                if (mapped.getData() == nullptr)
+                {
+                    error = "couldn't be mapped";
+                    return false;
+                }
+
+                if (!SmfReader::readNotes(mapped.getData(), mapped.getSize(), header, worker.notes, error))
+                    return false;
+            }
+
+            // A 64th note: chords rolled or played loosely still count as one onset
+            ChordRecognizer::analyse(worker.notes, header.ticksPerQuarterNote / 16, worker.analysis);
+            const auto& analysis = worker.analysis;
+
+            auto& out = worker.output;
+            out.reset();
+            out << "# " << job.file.getFileName() << "\n"
+                << "# key: " << MusicTheory::getNoteName(analysis.key, false) << " " << MusicTheory::getModeName(analysis.modeIndex)
+                << ", ticks per quarter note: " << header.ticksPerQuarterNote << "\n"
+                << "# start\tlength\tchord\troot\ttype\tbass\tinversion\n";
+
+            for (const auto& segment : analysis.chords)
+            {
+                const auto& chord = segment.chord;
+                out << segment.start << "\t" << (segment.end - segment.start) << "\t"
+                    << MusicTheory::getChordName(chord.root, chord.chordType, chord.bassOffset, false, analysis.modeIndex) << "\t"
+                    << MusicTheory::getNoteName(chord.root, false) << "\t"
+                    << juce::CharPointer_UTF8(MusicTheory::getChordType(chord.chordType).id) << "\t"
+                    << chord.bassOffset << "\t" << chord.inversion << "\n";
+            }
+
+            const auto outputFile = getOutputFile(job);
+            if (!outputFile.getParentDirectory().createDirectory() || !outputFile.replaceWithData(out.getData(), out.getDataSize()))
+            {
+                error = "couldn't write " + outputFile.getFullPathName();
+                return false;
+            }
+
+            numChords += (int) analysis.chords.size();
+            return true;
+        }
+
+        juce::File getOutputFile(const Job& job) const
+        {
+            const auto name = job.file.getFileNameWithoutExtension() + ".chords.txt";
+
+            if (options.outputDirectory == juce::File())
+                return job.file.getSiblingFile(name);
+
+            const auto relativeFolder = job.file.getParentDirectory().getRelativePathFrom(job.root);
+            return options.outputDirectory.getChildFile(relativeFolder).getChildFile(name);
+        }
+
+        const Options options;
+        std::vector<Job> jobs;
+        std::atomic<size_t> nextJob { 0 };
+        std::atomic<int> numWorkersLeft { 0 };
+        juce::WaitableEvent allDone;
+
+        std::atomic<int> numScanned { 0 }, numFailed { 0 }, numChords { 0 };
+        juce::CriticalSection outputLock;
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    ChordScan scan(parseOptions(args));
+    return scan.run();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// Fixed-capacity single-producer / single-consumer queue for small trivially
+// copyable commands. Neither side ever locks or allocates, so the UI can post
+// into it and the audio thread can drain it once per block.
+template <typename Command, int capacity>
+class CommandQueue
+{
+public:
+    CommandQueue() = default;
+
+    // Producer side. Returns false (and drops the command) if the queue is full.
+    bool push(const Command& command) noexcept
+    {
+        const auto scope = fifo.write(1);
+        if (scope.blockSize1 > 0)
+        {
+            items[(size_t) scope.startIndex1] = command;
+            return true;
+        }
+
+        return false;
+    }
+
+    // Consumer side. Calls handler for every queued command, oldest first.
+    template <typename Handler>
+    void popAll(Handler&& handler) noexcept
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            handler(items[(size_t) (scope.startIndex1 + i)]);
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            handler(items[(size_t) (scope.startIndex2 + i)]);
+    }
+
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<Command, (size_t) capacity> items {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CommandQueue)
+};
@@ -0,0 +1,156 @@
+#include "DeferredInitialiser.h"
+#include "StartupProfiler.h"
+#include <algorithm>
+
+// Takes tasks one after another until there are none left or the pool is shutting down
+class DeferredInitialiser::Runner : public juce::ThreadPoolJob
+{
+public:
+    explicit Runner(DeferredInitialiser& ownerToUse)
+        : juce::ThreadPoolJob("PianoXL deferred init"), owner(ownerToUse)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        while (!shouldExit() && owner.runNextTask())
+        {
+        }
+
+        return jobHasFinished;
+    }
+
+private:
+    DeferredInitialiser& owner;
+};
+
+//==============================================================================
+DeferredInitialiser::DeferredInitialiser()
+{
+    startTimer(fallbackStartMs);
+}
+
+DeferredInitialiser::~DeferredInitialiser()
+{
+    stopTimer();
+
+    if (pool != nullptr)
+        pool->removeAllJobs(true, 5000);
+}
+
+void DeferredInitialiser::addTask(const char* name, Priority priority, std::function<void()> work, std::function<void()> onDone)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    jassert(!started); // Too late: the order has been fixed
+
+    tasks.push_back({ name, priority, std::move(work), std::move(onDone) });
+}
+
+void DeferredInitialiser::start()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (started)
+        return;
+
+    started = true;
+    std::stable_sort(tasks.begin(), tasks.end(), [](const Task& a, const Task& b) { return a.priority < b.priority; });
+
+    if (tasks.empty())
+    {
+        deliverFinishedTasks();
+        return;
+    }
+
+    // Enough threads to keep a slow file from holding up the rest, without competing with
+    // the audio and render threads for every core
+    const int numThreads = juce::jlimit(1, 2, juce::SystemStats::getNumCpus() - 1);
+    pool = std::make_unique<juce::ThreadPool>(numThreads);
+
+    for (int i = 0; i < juce::jmin(numThreads, (int) tasks.size()); ++i)
+        pool->addJob(new Runner(*this), true);
+
+    startTimer(pollIntervalMs);
+}
+
+void DeferredInitialiser::runAllNow()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    start();
+
+    while (runNextTask())
+    {
+    }
+
+    if (pool != nullptr)
+        pool->removeAllJobs(false, 10000); // Waits for tasks other threads are still running
+
+    deliverFinishedTasks();
+}
+
+bool DeferredInitialiser::runNextTask()
+{
+    Task* task = nullptr;
+    {
+        const juce::ScopedLock sl(lock);
+        if (nextTask == tasks.size())
+            return false;
+
+        task = &tasks[nextTask++];
+    }
+
+    {
+        const StartupProfiler::Scope scope(task->name);
+        task->work();
+    }
+
+    const juce::ScopedLock sl(lock);
+    task->hasRun = true;
+    return true;
+}
+
+void DeferredInitialiser::deliverFinishedTasks()
+{
+    bool allDelivered = true;
+
+    for (auto& task : tasks)
+    {
+        if (task.isDelivered)
+            continue;
+
+        bool hasRun;
+        {
+            const juce::ScopedLock sl(lock);
+            hasRun = task.hasRun;
+        }
+
+        if (!hasRun)
+        {
+            allDelivered = false;
+            continue;
+        }
+
+        task.isDelivered = true;
+        if (task.onDone != nullptr)
+            task.onDone();
+    }
+
+    if (!allDelivered || finished)
+        return;
+
+    stopTimer();
+    finished = true;
+    StartupProfiler::mark("Deferred initialisation done");
+
+    if (onFinished != nullptr)
+        onFinished();
+}
+
+void DeferredInitialiser::timerCallback()
+{
+    if (!started)
+        start(); // No editor has shown up to start things
+    else
+        deliverFinishedTasks();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <vector>
+
+// Startup work that doesn't have to happen before the plugin can be shown: opening files,
+// decoding instruments, filling caches. Tasks are registered while the processor is being
+// built and start once the editor has painted its first frame, or after fallbackStartMs if
+// no editor opens. A host scanning plugins creates and deletes an instance long before
+// that, so it never pays for any of it.
+//
+// Tasks run on background threads, taken in priority order (then in the order they were
+// added), each timed by the StartupProfiler. A task's onDone runs on the message thread
+// after it. Anything a task prepares has to cope with being used before the task has run,
+// usually by doing the work there and then.
+class DeferredInitialiser : private juce::Timer
+{
+public:
+    enum class Priority
+    {
+        high,       // Wanted as soon as the user does anything
+        normal,
+        low         // Only speeds things up later
+    };
+
+    static constexpr int fallbackStartMs = 1000;
+
+    DeferredInitialiser();
+    ~DeferredInitialiser() override; // Waits for a running task; the rest never run
+
+    // Message thread, before start(). name must be a string literal.
+    void addTask(const char* name, Priority priority, std::function<void()> work, std::function<void()> onDone = {});
+
+    // Message thread. Does nothing after the first call.
+    void start();
+
+    // Message thread. Runs every task that hasn't started right here and waits for the
+    // rest, for hosts without a running message loop.
+    void runAllNow();
+
+    bool isFinished() const noexcept { return finished; }
+
+    // Message thread, once every task's onDone has run
+    std::function<void()> onFinished;
+
+private:
+    class Runner;
+
+    struct Task
+    {
+        const char* name;
+        Priority priority;
+        std::function<void()> work, onDone;
+        bool hasRun = false;                 // Guarded by lock
+        bool isDelivered = false;            // Message thread
+    };
+
+    // Any thread. Runs the next task nobody has taken yet; false once there are none.
+    bool runNextTask();
+    void deliverFinishedTasks();
+    void timerCallback() override;
+
+    static constexpr int pollIntervalMs = 20;
+
+    std::vector<Task> tasks;
+    juce::CriticalSection lock;
+    size_t nextTask = 0;                     // Guarded by lock
+    bool started = false;
+    bool finished = false;
+
+    std::unique_ptr<juce::ThreadPool> pool;  // Made by start(), so an instance that never starts has no threads
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeferredInitialiser)
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <type_traits>
+#include "AppStateModel.h"
+#include "SlotMask.h"
+#include "Voicing.h"
+#include "VoiceLeading.h"
+#include "Arpeggiator.h"
+
+// Plain-old-data copy of everything the audio thread needs from appState.
+// Compiled on the message thread by EngineStateBridge and published through a
+// triple buffer, so the audio thread never touches a juce::ValueTree.
+struct EngineState
+{
+    juce::uint32 version = 0;     // Incremented on every publish
+
+    juce::int8 key = 0;           // 0..11
+    juce::int8 mode = 0;          // 0 = FREE
+    juce::int8 octave = 0;
+    juce::int8 inversion = 0;     // INVERSION_VALUE, -2..+3
+    juce::int8 sound = 0;
+    juce::int8 slotsPerKey = 1;
+    juce::int8 smoothVoicing = 0; // SMOOTH_VOICING: pick the inversion with the least movement
+    juce::int8 midiOutput = 0;    // MIDI_OUTPUT: send chords as MIDI instead of synthesising them
+    juce::int8 softClip = 0;      // SOFT_CLIP: soft-clip the master after the limiter
+
+    // Fader, flam, BPM, arp mode/rate/gate and the other automatable values come from PluginParameters instead
+
+    juce::int8 arpSteps[Arpeggiator::maxPatternLength] = {}; // ARP_PATTERN, 0-based note indices or Arpeggiator::rest
+    juce::int8 numArpSteps = 0;
+
+    SlotMask::Mask disabledSlotMask = 0;
+
+    juce::int8 chordTypeIndex[AppStateModel::numSlots] = {};
+    juce::int8 bassOffset[AppStateModel::numSlots] = {};
+
+    // Prebuilt notes for every slot, in AppStateModel::getFlatSlotIndex() order
+    Voicing voicings[AppStateModel::numSlots] = {};
+
+    // Every inversion/spread of each slot's chord, for smooth voicing
+    VoiceLeading::Candidates candidates[AppStateModel::numSlots] = {};
+
+    // Checked before any chord is built for a press
+    bool isSlotEnabled(int keyIndex, int slotIndex) const noexcept
+    {
+        return !SlotMask::isDisabled(disabledSlotMask, keyIndex, slotIndex);
+    }
+
+    const Voicing& getVoicing(int keyIndex, int slotIndex) const noexcept
+    {
+        return voicings[AppStateModel::getFlatSlotIndex(keyIndex, slotIndex)];
+    }
+};
+
+static_assert(std::is_trivially_copyable<EngineState>::value, "EngineState is copied across threads as raw data");
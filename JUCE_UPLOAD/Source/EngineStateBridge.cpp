@@ -0,0 +1,68 @@
+#include "EngineStateBridge.h"
+#include "VoicingEngine.h"
+#include "VoiceLeading.h"
+#include "MusicTheory.h"
+
+EngineStateBridge::EngineStateBridge(juce::ValueTree stateToWatch)
+    : state(stateToWatch)
+{
+    state.addListener(this);
+    publish(); // The audio thread always has something valid to read
+}
+
+EngineStateBridge::~EngineStateBridge()
+{
+    cancelPendingUpdate();
+    state.removeListener(this);
+}
+
+void EngineStateBridge::compile(const juce::ValueTree& source, EngineState& dest)
+{
+    dest.key         = (juce::int8) juce::jlimit(0, 11, (int) source.getProperty(IDs::SELECTED_KEY, 0));
+    dest.mode        = (juce::int8) juce::jlimit(0, MusicTheory::numModes - 1, (int) source.getProperty(IDs::SELECTED_MODE, 0));
+    dest.octave      = (juce::int8) (int) source.getProperty(IDs::SELECTED_OCTAVE, 0);
+    dest.inversion   = (juce::int8) juce::jlimit(-2, 3, (int) source.getProperty(IDs::INVERSION_VALUE, 0));
+    dest.sound       = (juce::int8) (int) source.getProperty(IDs::SELECTED_SOUND, 0);
+    dest.slotsPerKey = (juce::int8) juce::jlimit(1, AppStateModel::maxSlotsPerKey, (int) source.getProperty(IDs::KEY_SIZE, 1));
+    dest.disabledSlotMask = SlotMask::fromVar(source.getProperty(IDs::DISABLED_SLOT_MASK, (juce::int64) 0));
+
+    auto slots = source.getChildWithName(IDs::SLOTS);
+    for (int i = 0; i < AppStateModel::numSlots; ++i)
+    {
+        auto slot = slots.getChild(i); // Invalid trees return the defaults below
+        dest.chordTypeIndex[i] = (juce::int8) (int) slot.getProperty(IDs::CHORD_TYPE_INDEX, 0);
+        dest.bassOffset[i]     = (juce::int8) (int) slot.getProperty(IDs::BASS_OFFSET, 0);
+    }
+
+    dest.smoothVoicing = (bool) source.getProperty(IDs::SMOOTH_VOICING, false) ? 1 : 0;
+    dest.midiOutput = (bool) source.getProperty(IDs::MIDI_OUTPUT, false) ? 1 : 0;
+    dest.softClip = (bool) source.getProperty(IDs::SOFT_CLIP, false) ? 1 : 0;
+    dest.numArpSteps = (juce::int8) Arpeggiator::parsePattern(source.getProperty(IDs::ARP_PATTERN).toString(), dest.arpSteps);
+
+    VoicingEngine::buildVoicings(dest);
+    VoiceLeading::buildCandidates(dest);
+}
+
+void EngineStateBridge::valueTreePropertyChanged(juce::ValueTree&, const juce::Identifier& property)
+{
+    // Automatable values reach the audio thread through PluginParameters; moving the
+    // fader shouldn't rebuild every voicing
+    if (property == IDs::FADER_VALUE || property == IDs::FLAM_VALUE || property == IDs::BPM
+        || property == IDs::EQ_LOW || property == IDs::EQ_MID || property == IDs::EQ_HIGH
+        || property == IDs::SUSTAIN || property == IDs::SAMPLE_START
+        || property == IDs::ARP_MODE || property == IDs::ARP_RATE || property == IDs::ARP_GATE)
+        return;
+
+    triggerAsyncUpdate();
+}
+
+void EngineStateBridge::publish()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    auto& dest = buffer.getWriteBuffer();
+    compile(state, dest);
+    dest.version = nextVersion++;
+    compiledState = dest;
+    buffer.publish();
+}
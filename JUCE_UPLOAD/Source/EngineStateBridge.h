@@ -0,0 +1,53 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "EngineState.h"
+#include "TripleBuffer.h"
+
+// Compiles the engine-relevant appState properties into an EngineState and publishes
+// it through a triple buffer.
+//
+// Message thread: listens to appState; changes are batched through an AsyncUpdater so a
+// burst of property changes (e.g. a memory recall) produces one publish.
+// Audio thread: getLatestState() is wait-free and allocation-free, and always returns a
+// consistent snapshot.
+class EngineStateBridge : private juce::ValueTree::Listener,
+                          private juce::AsyncUpdater
+{
+public:
+    explicit EngineStateBridge(juce::ValueTree stateToWatch);
+    ~EngineStateBridge() override;
+
+    // Audio thread only (single reader)
+    const EngineState& getLatestState() noexcept { return buffer.read(); }
+
+    // Message thread only. The last state that was published, for UI code that needs
+    // the same prebuilt voicings the audio thread plays.
+    const EngineState& getCompiledState() const noexcept { return compiledState; }
+
+    // Message thread only. Publishes any change that's still waiting for the async update.
+    void flushPendingChanges() { handleUpdateNowIfNeeded(); }
+
+    // Fills an EngineState from the tree, including its voicing cache. Message thread only.
+    static void compile(const juce::ValueTree& state, EngineState& dest);
+
+private:
+    void publish();
+
+    // AsyncUpdater
+    void handleAsyncUpdate() override { publish(); }
+
+    // ValueTree::Listener methods
+    void valueTreePropertyChanged(juce::ValueTree&, const juce::Identifier& property) override;
+    void valueTreeChildAdded(juce::ValueTree&, juce::ValueTree&) override { triggerAsyncUpdate(); }
+    void valueTreeChildRemoved(juce::ValueTree&, juce::ValueTree&, int) override { triggerAsyncUpdate(); }
+    void valueTreeChildOrderChanged(juce::ValueTree&, int, int) override {}
+    void valueTreeParentChanged(juce::ValueTree&) override {}
+
+    juce::ValueTree state;
+    TripleBuffer<EngineState> buffer;
+    EngineState compiledState;
+    juce::uint32 nextVersion = 1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EngineStateBridge)
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Flam options in FLAM_VALUE order, and the stagger between chord notes they give.
+// From getFlamDelay in audio-utils.ts.
+namespace Flam
+{
+    constexpr int numOptions = 5;
+
+    inline const char* const optionNames[numOptions] = { "OFF", "1/16", "1/24", "1/32", "1/48" };
+
+    // Each option is played half-time: 1/16 staggers notes by an eighth note
+    inline double getDelaySeconds(int flamIndex, double bpm)
+    {
+        static constexpr double divisions[numOptions] = { 0.0, 16.0, 24.0, 32.0, 48.0 };
+
+        if (flamIndex <= 0 || flamIndex >= numOptions || bpm <= 0.0)
+            return 0.0;
+
+        const double wholeNoteSeconds = 4.0 * 60.0 / bpm;
+        return (wholeNoteSeconds / divisions[flamIndex]) * 2.0;
+    }
+}
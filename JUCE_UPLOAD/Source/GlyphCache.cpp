@@ -0,0 +1,61 @@
+#include "GlyphCache.h"
+#include <cstring>
+
+namespace
+{
+    // FNV-1a over the text and the font's identity; only what's already in the Font is read
+    juce::uint64 getKey(const char* utf8, const juce::Font& font) noexcept
+    {
+        juce::uint64 hash = 14695981039346656037ull;
+        auto mix = [&hash](juce::uint64 value) {
+            hash ^= value;
+            hash *= 1099511628211ull;
+        };
+
+        for (auto* c = utf8; *c != 0; ++c)
+            mix((juce::uint8) *c);
+
+        mix((juce::uint64) font.getTypefaceName().hashCode64());
+        mix((juce::uint64) font.getTypefaceStyle().hashCode64());
+
+        float height = font.getHeight();
+        juce::uint32 heightBits;
+        std::memcpy(&heightBits, &height, sizeof(heightBits));
+        mix(heightBits);
+        mix((juce::uint64) font.getStyleFlags());
+
+        return hash;
+    }
+}
+
+const GlyphCache::Entry& GlyphCache::getEntry(const char* utf8, const juce::Font& font)
+{
+    const auto key = getKey(utf8, font);
+
+    auto existing = entries.find(key);
+    if (existing != entries.end() && existing->second.font == font && existing->second.text == utf8)
+        return existing->second;
+
+    if (existing != entries.end())
+        entries.erase(existing); // Another text with the same key (very rarely); this one replaces it
+    else if (entries.size() >= maxEntries)
+        entries.clear();
+
+    auto& entry = entries.emplace(key, Entry { utf8, font, {}, 0.0f }).first->second;
+    entry.glyphs.addLineOfText(font, juce::String(juce::CharPointer_UTF8(utf8)), 0.0f, 0.0f);
+    entry.width = entry.glyphs.getBoundingBox(0, -1, true).getWidth();
+    return entry;
+}
+
+void GlyphCache::draw(juce::Graphics& g, const char* utf8, const juce::Font& font,
+                      juce::Rectangle<float> area, juce::Justification justification)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (*utf8 == 0)
+        return;
+
+    const auto& entry = getEntry(utf8, font);
+    const auto placed = justification.appliedToRectangle(juce::Rectangle<float>(entry.width, font.getHeight()), area);
+    entry.glyphs.draw(g, juce::AffineTransform::translation(placed.getX(), placed.getY() + font.getAscent()));
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <string>
+#include <unordered_map>
+
+// Shaped text for the short labels painted over and over (chord names on the keys and in
+// the chord display). Each distinct text and font is laid out into a GlyphArrangement the
+// first time it's drawn; after that, drawing it is a lookup and no allocation.
+// Message thread only; components share one through a SharedResourcePointer.
+class GlyphCache
+{
+public:
+    GlyphCache() = default;
+
+    // Draws one line of UTF-8 text inside area, placed by justification, as Graphics::drawText
+    // would without ellipses. Uses the Graphics' current colour.
+    void draw(juce::Graphics& g, const char* utf8, const juce::Font& font,
+              juce::Rectangle<float> area, juce::Justification justification);
+
+    int getNumEntries() const noexcept { return (int) entries.size(); }
+
+private:
+    struct Entry
+    {
+        std::string text;
+        juce::Font font;
+        juce::GlyphArrangement glyphs; // Baseline at y = 0
+        float width = 0.0f;
+    };
+
+    const Entry& getEntry(const char* utf8, const juce::Font& font);
+
+    // Enough for every name the keys can show; past it the cache starts again
+    static constexpr size_t maxEntries = 2048;
+
+    std::unordered_map<juce::uint64, Entry> entries;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GlyphCache)
+};
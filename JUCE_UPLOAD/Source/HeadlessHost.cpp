@@ -0,0 +1,1739 @@
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "StartupProfiler.h"
+#include "ChordRecognizer.h"
+#include "MainComponent.h"
+#include "InputTrace.h"
+#include "GlyphCache.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#if JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+// Offline host for CI: loads the processor without an editor or audio device, drives
+// MIDI and state automation through processBlock, and checks what comes out.
+//
+// Usage: PianoXLHeadlessHost [--sample-rate N] [--block-size N] [--seconds N] [--strict]
+//                            [--startup-trace FILE] [--replay TRACE]
+// Exits non-zero if any check fails. With --strict, a block that takes longer than its
+// real-time budget also counts as a failure. --startup-trace writes the StartupProfiler's
+// timeline of the processor's startup to FILE.
+//
+// --replay plays back an input trace (recorded in the app with I) instead of running the
+// checks, and reports frame times, press-to-sound latency, audio load and allocations.
+// Exits non-zero if the audio thread allocated; with --strict, also if a block overran or
+// a frame missed 60 Hz.
+
+//==============================================================================
+// Every allocation counts against the thread making it, so a replay can tell whether the
+// audio thread allocates and what handling each input event costs. operator new is counted
+// everywhere, including its aligned forms. With glibc (the CI build), malloc, calloc and
+// realloc are interposed as well, so HeapBlock, Array, MidiBuffer and AudioBuffer growth
+// count too; on other platforms those go uncounted.
+namespace
+{
+    thread_local juce::int64 allocationCount = 0;
+}
+
+#if JUCE_LINUX && defined(__GLIBC__)
+extern "C"
+{
+    void* __libc_malloc(std::size_t size);
+    void* __libc_calloc(std::size_t count, std::size_t size);
+    void* __libc_realloc(void* memory, std::size_t size);
+
+    void* malloc(std::size_t size) noexcept
+    {
+        ++allocationCount;
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t count, std::size_t size) noexcept
+    {
+        ++allocationCount;
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* memory, std::size_t size) noexcept
+    {
+        if (size > 0) // realloc(memory, 0) only frees
+            ++allocationCount;
+
+        return __libc_realloc(memory, size);
+    }
+}
+
+namespace
+{
+    void* uncountedMalloc(std::size_t size) { return __libc_malloc(size); }
+}
+#else
+namespace
+{
+    void* uncountedMalloc(std::size_t size) { return std::malloc(size); }
+}
+#endif
+
+namespace
+{
+    void* alignedMalloc(std::size_t size, std::align_val_t alignment) noexcept
+    {
+        ++allocationCount;
+       #if JUCE_WINDOWS
+        return _aligned_malloc(size == 0 ? 1 : size, (std::size_t) alignment);
+       #else
+        void* memory = nullptr;
+        return posix_memalign(&memory, (std::size_t) alignment, size == 0 ? 1 : size) == 0 ? memory : nullptr;
+       #endif
+    }
+
+    void alignedFree(void* memory) noexcept
+    {
+       #if JUCE_WINDOWS
+        _aligned_free(memory);
+       #else
+        std::free(memory);
+       #endif
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocationCount;
+    if (auto* memory = uncountedMalloc(size == 0 ? 1 : size))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++allocationCount;
+    return uncountedMalloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++allocationCount;
+    return uncountedMalloc(size == 0 ? 1 : size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (auto* memory = alignedMalloc(size, alignment))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept       { return alignedMalloc(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept     { return alignedMalloc(size, alignment); }
+
+void operator delete(void* memory) noexcept                 { std::free(memory); }
+void operator delete[](void* memory) noexcept               { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept    { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept  { std::free(memory); }
+
+void operator delete(void* memory, std::align_val_t) noexcept                   { alignedFree(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept                 { alignedFree(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept      { alignedFree(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept    { alignedFree(memory); }
+
+namespace
+{
+    struct Options
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        double throughputSeconds = 60.0;
+        bool strict = false;
+        juce::File startupTrace;
+        juce::File replay;
+    };
+
+    Options parseOptions(const juce::StringArray& args)
+    {
+        Options options;
+        for (int i = 0; i < args.size(); ++i)
+        {
+            const auto next = i + 1 < args.size() ? args[i + 1] : juce::String();
+
+            if (args[i] == "--sample-rate")  { options.sampleRate = juce::jmax(8000.0, next.getDoubleValue()); ++i; }
+            else if (args[i] == "--block-size") { options.blockSize = juce::jlimit(16, 8192, next.getIntValue()); ++i; }
+            else if (args[i] == "--seconds")    { options.throughputSeconds = juce::jmax(1.0, next.getDoubleValue()); ++i; }
+            else if (args[i] == "--strict")     { options.strict = true; }
+            else if (args[i] == "--startup-trace") { options.startupTrace = juce::File::getCurrentWorkingDirectory().getChildFile(next); ++i; }
+            else if (args[i] == "--replay")     { options.replay = juce::File::getCurrentWorkingDirectory().getChildFile(next); ++i; }
+        }
+        return options;
+    }
+
+    //==============================================================================
+    double getAverage(const std::vector<double>& values)
+    {
+        double total = 0.0;
+        for (auto value : values)
+            total += value;
+
+        return values.empty() ? 0.0 : total / (double) values.size();
+    }
+
+    double getPercentile(std::vector<double> values, double proportion)
+    {
+        if (values.empty())
+            return 0.0;
+
+        const auto index = (size_t) juce::jlimit(0.0, (double) values.size() - 1.0, std::ceil(proportion * (double) values.size()) - 1.0);
+        std::nth_element(values.begin(), values.begin() + (std::ptrdiff_t) index, values.end());
+        return values[index];
+    }
+
+    //==============================================================================
+    // Plays an input trace back against a fresh processor and main component, in real time:
+    // the processor runs on its own thread paced like an audio device, each event is handled
+    // at its recorded time, and a frame is rendered every 60th of a second. Everything runs
+    // inside the message loop, so the app's own timers and async work happen as they would.
+    class TraceReplay : private juce::Timer
+    {
+    public:
+        struct Report
+        {
+            int numEvents = 0;
+            double eventMsAverage = 0.0, eventMsWorst = 0.0;
+            juce::int64 eventAllocations = 0;       // On the message thread, handling events
+
+            int numFrames = 0, slowFrames = 0;
+            double frameMsAverage = 0.0, frameMs95 = 0.0, frameMsWorst = 0.0;
+
+            int numPresses = 0;
+            double latencyMsMin = 0.0, latencyMsAverage = 0.0, latencyMsMax = 0.0;
+
+            int numBlocks = 0, overruns = 0;
+            double loadAverage = 0.0, load99 = 0.0, loadWorst = 0.0; // Processing time over the block's duration
+            juce::int64 audioAllocations = 0;
+
+            void print() const
+            {
+                std::cout << "Events: " << numEvents << ", handled in avg " << juce::String(eventMsAverage, 3) << " ms, worst "
+                          << juce::String(eventMsWorst, 3) << " ms, " << eventAllocations << " allocation(s)" << std::endl
+                          << "Frames: " << numFrames << ", avg " << juce::String(frameMsAverage, 2) << " ms, p95 "
+                          << juce::String(frameMs95, 2) << " ms, worst " << juce::String(frameMsWorst, 2) << " ms, "
+                          << slowFrames << " over " << juce::String(frameIntervalMs, 1) << " ms" << std::endl
+                          << "Press-to-sound latency over " << numPresses << " press(es): min " << juce::String(latencyMsMin, 2)
+                          << " ms, avg " << juce::String(latencyMsAverage, 2) << " ms, max " << juce::String(latencyMsMax, 2) << " ms" << std::endl
+                          << "Audio: " << numBlocks << " blocks, load avg " << juce::String(loadAverage * 100.0, 1) << "%, p99 "
+                          << juce::String(load99 * 100.0, 1) << "%, worst " << juce::String(loadWorst * 100.0, 1) << "%, "
+                          << overruns << " overrun(s), " << audioAllocations << " allocation(s)" << std::endl;
+            }
+
+            bool passes(bool strict) const
+            {
+                return audioAllocations == 0 && (!strict || (overruns == 0 && slowFrames == 0));
+            }
+        };
+
+        TraceReplay(const Options& optionsToUse, const InputTrace& traceToReplay)
+            : options(optionsToUse),
+              trace(traceToReplay),
+              processor(false)
+        {
+            processor.setPlayConfigDetails(0, 2, options.sampleRate, options.blockSize);
+            processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+            const auto& state = trace.getInitialState();
+            if (state.getSize() > 0)
+                processor.setStateInformation(state.getData(), (int) state.getSize());
+
+            // Startup work would otherwise land in the first seconds of every replay
+            processor.getEngineStateBridge().flushPendingChanges();
+            processor.getDeferredInitialiser().runAllNow();
+            processor.getAttackCache().buildNow();
+
+            mainComponent = std::make_unique<MainComponent>(processor);
+            processor.getChordEngine().setMeasuringLatency(true);
+        }
+
+        ~TraceReplay() override
+        {
+            stopTimer();
+            if (audioThread != nullptr)
+                audioThread->stopThread(2000);
+
+            mainComponent = nullptr;
+            processor.releaseResources();
+        }
+
+        // Returns once the trace has played out. JUCE's message loop can only be run once
+        // per process, so only one replay can run in each.
+        Report run()
+        {
+            const double blockMs = 1000.0 * options.blockSize / options.sampleRate;
+            endTimeMs = trace.getLengthMs() + tailMs;
+
+            eventMs.reserve(trace.getEvents().size());
+            frameMs.reserve((size_t) (endTimeMs / frameIntervalMs) + 1);
+            audioThread = std::make_unique<AudioThread>(processor, options, (size_t) (endTimeMs / blockMs) + 256);
+            audioThread->startThread(juce::Thread::Priority::highest);
+
+            startTimeMs = juce::Time::getMillisecondCounterHiRes();
+            startTimer(1);
+            juce::MessageManager::getInstance()->runDispatchLoop();
+
+            return report;
+        }
+
+        PianoXLAudioProcessor& getProcessor() { return processor; }
+
+    private:
+        static constexpr double frameIntervalMs = 1000.0 / 60.0;
+        static constexpr double tailMs = 500.0; // Lets the last chords ring and their latency land
+
+        // Stands in for the audio device: calls processBlock once per block period
+        class AudioThread : public juce::Thread
+        {
+        public:
+            AudioThread(PianoXLAudioProcessor& processorToUse, const Options& options, size_t maxBlocks)
+                : juce::Thread("Replay audio"),
+                  processor(processorToUse),
+                  blockMs(1000.0 * options.blockSize / options.sampleRate)
+            {
+                buffer.setSize(2, options.blockSize);
+                midi.ensureSize(8192);
+                loads.reserve(maxBlocks); // So noting a block's load doesn't allocate on this thread
+            }
+
+            void run() override
+            {
+                auto nextBlockMs = juce::Time::getMillisecondCounterHiRes();
+
+                while (!threadShouldExit())
+                {
+                    const auto allocationsBefore = allocationCount;
+                    const auto startMs = juce::Time::getMillisecondCounterHiRes();
+
+                    buffer.clear();
+                    processor.processBlock(buffer, midi);
+                    midi.clear();
+
+                    const auto endMs = juce::Time::getMillisecondCounterHiRes();
+                    allocations += allocationCount - allocationsBefore;
+
+                    const double load = (endMs - startMs) / blockMs;
+                    overruns += load > 1.0 ? 1 : 0;
+                    if (loads.size() < loads.capacity())
+                        loads.push_back(load);
+
+                    // A late block is followed straight away by the next, as a device would
+                    nextBlockMs = juce::jmax(nextBlockMs + blockMs, endMs);
+                    for (auto now = endMs; now < nextBlockMs && !threadShouldExit(); now = juce::Time::getMillisecondCounterHiRes())
+                    {
+                        if (nextBlockMs - now > 1.5)
+                            juce::Thread::sleep(1);
+                        else
+                            juce::Thread::yield();
+                    }
+                }
+            }
+
+            std::vector<double> loads;
+            int overruns = 0;
+            juce::int64 allocations = 0;
+
+        private:
+            PianoXLAudioProcessor& processor;
+            const double blockMs;
+            juce::AudioBuffer<float> buffer;
+            juce::MidiBuffer midi;
+        };
+
+        void timerCallback() override
+        {
+            const double nowMs = juce::Time::getMillisecondCounterHiRes() - startTimeMs;
+            const auto& events = trace.getEvents();
+
+            for (; nextEvent < events.size() && events[nextEvent].time <= nowMs; ++nextEvent)
+            {
+                const auto allocationsBefore = allocationCount;
+                const auto startMs = juce::Time::getMillisecondCounterHiRes();
+
+                mainComponent->replayInput(events[nextEvent]);
+
+                eventMs.push_back(juce::Time::getMillisecondCounterHiRes() - startMs);
+                report.eventAllocations += allocationCount - allocationsBefore;
+            }
+
+            if (nowMs >= nextFrameMs)
+            {
+                const auto startMs = juce::Time::getMillisecondCounterHiRes();
+                mainComponent->createComponentSnapshot(mainComponent->getLocalBounds());
+                frameMs.push_back(juce::Time::getMillisecondCounterHiRes() - startMs);
+
+                // A late frame isn't followed by a burst to catch up
+                nextFrameMs = juce::jmax(nextFrameMs + frameIntervalMs, nowMs);
+                popLatencies();
+            }
+
+            if (nowMs >= endTimeMs && nextEvent >= events.size())
+                finish();
+        }
+
+        void popLatencies()
+        {
+            processor.getChordEngine().popLatencyMeasurements([this](double latencyMs) { latencyMeasurements.push_back(latencyMs); });
+        }
+
+        void finish()
+        {
+            stopTimer();
+            audioThread->stopThread(2000);
+            popLatencies();
+
+            report.numEvents = (int) eventMs.size();
+            report.eventMsAverage = getAverage(eventMs);
+            report.eventMsWorst = getPercentile(eventMs, 1.0);
+
+            report.numFrames = (int) frameMs.size();
+            report.slowFrames = (int) std::count_if(frameMs.begin(), frameMs.end(), [](double ms) { return ms > frameIntervalMs; });
+            report.frameMsAverage = getAverage(frameMs);
+            report.frameMs95 = getPercentile(frameMs, 0.95);
+            report.frameMsWorst = getPercentile(frameMs, 1.0);
+
+            report.numPresses = (int) latencyMeasurements.size();
+            report.latencyMsMin = latencyMeasurements.empty() ? 0.0 : *std::min_element(latencyMeasurements.begin(), latencyMeasurements.end());
+            report.latencyMsAverage = getAverage(latencyMeasurements);
+            report.latencyMsMax = getPercentile(latencyMeasurements, 1.0);
+
+            const auto& loads = audioThread->loads;
+            report.numBlocks = (int) loads.size();
+            report.overruns = audioThread->overruns;
+            report.loadAverage = getAverage(loads);
+            report.load99 = getPercentile(loads, 0.99);
+            report.loadWorst = getPercentile(loads, 1.0);
+            report.audioAllocations = audioThread->allocations;
+
+            juce::MessageManager::getInstance()->stopDispatchLoop();
+        }
+
+        const Options options;
+        const InputTrace& trace;
+        PianoXLAudioProcessor processor;
+        std::unique_ptr<MainComponent> mainComponent;
+        std::unique_ptr<AudioThread> audioThread;
+
+        double startTimeMs = 0.0, endTimeMs = 0.0, nextFrameMs = 0.0;
+        size_t nextEvent = 0;
+        std::vector<double> eventMs, frameMs, latencyMeasurements;
+        Report report;
+    };
+
+    //==============================================================================
+    class HeadlessHost
+    {
+    public:
+        explicit HeadlessHost(const Options& optionsToUse)
+            : options(optionsToUse),
+              processor(false) // Keep away from the user's autosave and memory bank files
+        {
+            processor.setPlayConfigDetails(0, 2, options.sampleRate, options.blockSize);
+            processor.prepareToPlay(options.sampleRate, options.blockSize);
+            buffer.setSize(2, options.blockSize);
+        }
+
+        ~HeadlessHost()
+        {
+            processor.releaseResources();
+        }
+
+        int run()
+        {
+            checkDeferredInitialisation();
+            checkSilenceWithoutInput();
+            checkNoteOnIsSampleAccurate();
+            checkFaderAutomation();
+            checkNoteOffReleases();
+            checkOversizedBlock();
+            checkMasterLimiter();
+            checkLevelMeter();
+            checkTouchesHoldChords();
+            checkAttackCache();
+            checkSharedAttackPool();
+            checkTuning();
+            checkEnvelopeLanes();
+            checkThreadedVoiceRendering();
+            checkMidiOutput();
+            checkArpeggiator();
+            checkRecorder();
+            checkSmoothProgression();
+            checkChordRecognizer();
+            checkChordNames();
+            checkInputTraceReplay();
+            measureThroughput();
+
+            std::cout << (failures == 0 ? "PASSED" : "FAILED") << " (" << failures << " failure(s))" << std::endl;
+            return failures == 0 ? 0 : 1;
+        }
+
+    private:
+        //==============================================================================
+        void checkDeferredInitialisation()
+        {
+            // Nothing runs until the editor's first frame (there's none here) or the fallback
+            // timer (no message loop either), so run it all now
+            auto& initialiser = processor.getDeferredInitialiser();
+            expect(!initialiser.isFinished(), "deferred startup work waits to be started");
+
+            // Using the banks first loads them there and then
+            auto& bank = processor.getMemoryBank();
+            PerformanceSetup setup;
+            expect(bank.store(0, MemoryBank::capture(processor.getAppState())) && bank.recall(0, setup),
+                   "memory banks usable before their deferred load");
+
+            // The banks are the user's, not the project's: restoring a project leaves them alone
+            juce::MemoryBlock projectState;
+            processor.getStateInformation(projectState);
+            bank.clear(0);
+            processor.setStateInformation(projectState.getData(), (int) projectState.getSize());
+            expect(!bank.isOccupied(0), "restoring a project doesn't overwrite the memory banks");
+
+            initialiser.runAllNow();
+            expect(initialiser.isFinished(), "deferred startup work finishes");
+
+            if (options.startupTrace != juce::File())
+            {
+                const auto trace = juce::JSON::parse(options.startupTrace);
+                const auto* events = trace["traceEvents"].getArray();
+
+                bool hasTask = false;
+                for (int i = 0; events != nullptr && i < events->size(); ++i)
+                    hasTask = hasTask || (*events)[i]["name"].toString() == "Map memory banks";
+
+                expect(hasTask, "startup trace written with the deferred tasks in it");
+            }
+        }
+
+        void checkSilenceWithoutInput()
+        {
+            for (int i = 0; i < 8; ++i)
+                processBlock();
+
+            expect(getPeak() == 0.0f, "silence without input");
+        }
+
+        void checkNoteOnIsSampleAccurate()
+        {
+            // Everything comes out the master limiter's lookahead later, as reported to the host
+            const int offset = options.blockSize / 4;
+            const int soundStart = offset + processor.getLatencySamples();
+            expect(processor.getLatencySamples() == juce::roundToInt(MasterLimiter::lookaheadSeconds * options.sampleRate),
+                   "limiter lookahead reported as latency");
+
+            juce::AudioBuffer<float> output(2, (soundStart / options.blockSize + 2) * options.blockSize);
+            midi.addEvent(juce::MidiMessage::noteOn(1, 60, (juce::uint8) 100), offset);
+            for (int start = 0; start < output.getNumSamples(); start += options.blockSize)
+            {
+                processBlock();
+                for (int channel = 0; channel < 2; ++channel)
+                    output.copyFrom(channel, start, buffer, channel, 0, options.blockSize);
+            }
+
+            expect(output.getMagnitude(0, soundStart) == 0.0f, "nothing before the note-on's sample position");
+            expect(output.getMagnitude(soundStart, output.getNumSamples() - soundStart) > 0.0f, "sound from the note-on's sample position");
+            expect(isFinite(), "finite output after note-on");
+        }
+
+        void checkFaderAutomation()
+        {
+            // Sweep the fader and EQ across their ranges while chords sound, one step per block,
+            // the way a host writes automation
+            const int steps = 32;
+            float peak = 0.0f, largestJump = 0.0f;
+            bool finite = true;
+            for (int i = 0; i <= steps; ++i)
+            {
+                const float position = (float) i / steps;
+                setParameter("fader", position);
+                setParameter("eqLow", position);
+                setParameter("eqHigh", 1.0f - position);
+                if (i % 8 == 0)
+                    midi.addEvent(juce::MidiMessage::noteOn(1, 60 + i / 8, (juce::uint8) 100), 0);
+
+                const float previousSample = buffer.getSample(0, buffer.getNumSamples() - 1);
+                processBlock();
+                peak = juce::jmax(peak, getPeak());
+                largestJump = juce::jmax(largestJump, std::abs(buffer.getSample(0, 0) - previousSample));
+                finite = finite && isFinite();
+            }
+
+            expect(finite, "finite output during automation");
+            expect(peak > 0.0f && peak < 1.0f, "level stays in range during automation");
+            expect(largestJump < 0.1f, "no steps at block boundaries during automation");
+
+            setParameter("fader", 0.25f);
+            setParameter("eqLow", 0.5f);
+            setParameter("eqHigh", 0.5f);
+        }
+
+        void checkNoteOffReleases()
+        {
+            midi.addEvent(juce::MidiMessage::noteOn(1, 64, (juce::uint8) 100), 0);
+            processBlock();
+            midi.addEvent(juce::MidiMessage::noteOff(1, 64), 0);
+
+            const int releaseBlocks = (int) std::ceil(0.2 * options.sampleRate / options.blockSize);
+            for (int i = 0; i < releaseBlocks; ++i)
+                processBlock();
+
+            expect(getPeak() == 0.0f, "note-off releases the chord");
+            expect(processor.getChordEngine().getNumActiveVoices() == 0, "no voices left after release");
+        }
+
+        void checkOversizedBlock()
+        {
+            // A host that sends a longer block than it prepared for gets all of it rendered,
+            // not silence past the prepared size
+            const int settleBlocks = (int) std::ceil(0.3 * options.sampleRate / options.blockSize);
+
+            midi.addEvent(juce::MidiMessage::noteOn(1, 60, (juce::uint8) 100), 0);
+            processBlock();
+
+            buffer.setSize(2, options.blockSize * 4, false, false, true);
+            processBlock();
+            const bool rendered = getPeak(options.blockSize * 3) > 0.0f && isFinite();
+            buffer.setSize(2, options.blockSize, false, false, true);
+
+            midi.addEvent(juce::MidiMessage::noteOff(1, 60), 0);
+            for (int i = 0; i < settleBlocks; ++i)
+                processBlock();
+
+            expect(rendered, "a block longer than prepared is rendered to its end");
+        }
+
+        void checkMasterLimiter()
+        {
+            // Every key held at once, with and without the soft clipper: far too loud summed,
+            // but nothing over the ceiling comes out
+            const int numBlocks = (int) std::ceil(0.5 * options.sampleRate / options.blockSize);
+            const int settleBlocks = (int) std::ceil(0.3 * options.sampleRate / options.blockSize);
+
+            for (const bool softClip : { false, true })
+            {
+                processor.getAppState().setProperty(IDs::SOFT_CLIP, softClip, nullptr);
+                processor.getEngineStateBridge().flushPendingChanges();
+
+                for (int note = 48; note < 60; ++note)
+                    midi.addEvent(juce::MidiMessage::noteOn(1, note, (juce::uint8) 127), 0);
+
+                float peak = 0.0f;
+                bool finite = true;
+                for (int i = 0; i < numBlocks; ++i)
+                {
+                    processBlock();
+                    peak = juce::jmax(peak, getPeak());
+                    finite = finite && isFinite();
+                }
+
+                for (int note = 48; note < 60; ++note)
+                    midi.addEvent(juce::MidiMessage::noteOff(1, note), 0);
+                for (int i = 0; i < settleBlocks; ++i)
+                    processBlock();
+
+                expect(finite && peak > 0.5f && peak <= MasterLimiter::ceiling + 1.0e-5f,
+                       softClip ? "soft clipper keeps a twelve-chord stack under the ceiling"
+                                : "limiter keeps a twelve-chord stack under the ceiling");
+            }
+
+            processor.getAppState().setProperty(IDs::SOFT_CLIP, false, nullptr);
+            processor.getEngineStateBridge().flushPendingChanges();
+            expect(getPeak() == 0.0f, "silence after the stack is released");
+        }
+
+        void checkLevelMeter()
+        {
+            // Levels for every block match what came out, and the spectrum only produces
+            // snapshots while it's enabled
+            auto& meter = processor.getLevelMeter();
+            meter.popLevels([](const LevelMeter::Levels&) {}); // Earlier checks filled the queue
+            LevelMeter::Snapshot snapshot;
+            meter.popLatestSnapshot(snapshot);
+
+            const int numBlocks = LevelMeter::hopSize / options.blockSize + 2;
+            midi.addEvent(juce::MidiMessage::noteOn(1, 60, (juce::uint8) 100), 0);
+
+            bool levelsMatch = true;
+            int numLevels = 0;
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                processBlock();
+                const float peak = juce::jmax(buffer.getMagnitude(0, 0, buffer.getNumSamples()),
+                                              buffer.getMagnitude(1, 0, buffer.getNumSamples()));
+                meter.popLevels([&](const LevelMeter::Levels& levels) {
+                    levelsMatch = levelsMatch && levels.numChannels == 2
+                                  && juce::jmax(levels.peak[0], levels.peak[1]) == peak
+                                  && levels.rms[0] <= levels.peak[0] && levels.rms[1] <= levels.peak[1];
+                    ++numLevels;
+                });
+            }
+
+            expect(levelsMatch && numLevels == numBlocks, "meter levels for every block match the output");
+            expect(!meter.popLatestSnapshot(snapshot), "no spectrum snapshots while it's off");
+
+            meter.setSpectrumEnabled(true);
+            for (int i = 0; i < numBlocks; ++i)
+                processBlock();
+
+            const bool gotSnapshot = meter.popLatestSnapshot(snapshot);
+            const float snapshotPeak = juce::FloatVectorOperations::findMaximum(snapshot.samples, LevelMeter::fftSize);
+            expect(gotSnapshot && snapshotPeak > 0.0f
+                       && snapshot.sampleRate == options.sampleRate / LevelMeter::decimation,
+                   "spectrum snapshots of the output while it's on");
+            meter.setSpectrumEnabled(false);
+
+            midi.addEvent(juce::MidiMessage::noteOff(1, 60), 0);
+            const int releaseBlocks = (int) std::ceil(0.2 * options.sampleRate / options.blockSize);
+            for (int i = 0; i < releaseBlocks; ++i)
+                processBlock();
+
+            meter.popLevels([](const LevelMeter::Levels&) {});
+        }
+
+        void checkTouchesHoldChords()
+        {
+            // Two fingers down on C and G: both chords sound until their own finger lifts
+            auto& engine = processor.getChordEngine();
+            const int settleBlocks = (int) std::ceil(0.2 * options.sampleRate / options.blockSize);
+            auto settle = [this, settleBlocks] {
+                for (int i = 0; i < settleBlocks; ++i)
+                    processBlock();
+            };
+
+            auto touch = [&engine](ChordCommand::Type type, int keyIndex, int touchIndex) {
+                ChordCommand command;
+                command.type = type;
+                command.keyIndex = (juce::int8) keyIndex;
+                command.touchIndex = (juce::int8) touchIndex;
+                command.timestamp = juce::Time::getMillisecondCounterHiRes();
+                engine.postCommand(command);
+            };
+
+            touch(ChordCommand::Type::playSlot, 0, 0);
+            settle();
+            const int firstChordVoices = engine.getNumActiveVoices();
+
+            touch(ChordCommand::Type::playSlot, 7, 1);
+            settle();
+            const int bothChordsVoices = engine.getNumActiveVoices();
+            expect(firstChordVoices > 0 && bothChordsVoices > firstChordVoices, "a second touch plays over the held chord");
+
+            touch(ChordCommand::Type::releaseTouch, 0, 0);
+            settle();
+            expect(engine.getNumActiveVoices() == bothChordsVoices - firstChordVoices, "lifting a touch releases only its chord");
+
+            touch(ChordCommand::Type::releaseTouch, 0, 1);
+            settle();
+            expect(engine.getNumActiveVoices() == 0 && getPeak() == 0.0f, "lifting the last touch leaves silence");
+        }
+
+        void checkAttackCache()
+        {
+            // A press played from the cache must sound the same as one rendered live, across
+            // the handover to live voices
+            auto& engine = processor.getChordEngine();
+            const int numBlocks = (int) std::ceil(0.1 * options.sampleRate / options.blockSize);
+            const int settleBlocks = (int) std::ceil(0.3 * options.sampleRate / options.blockSize);
+
+            auto playAndCapture = [&](juce::AudioBuffer<float>& dest) {
+                dest.setSize(1, numBlocks * options.blockSize);
+                midi.addEvent(juce::MidiMessage::noteOn(1, 67, (juce::uint8) 100), 0);
+                for (int i = 0; i < numBlocks; ++i)
+                {
+                    processBlock();
+                    dest.copyFrom(0, i * options.blockSize, buffer, 0, 0, options.blockSize);
+                }
+
+                midi.addEvent(juce::MidiMessage::noteOff(1, 67), 0);
+                for (int i = 0; i < settleBlocks; ++i)
+                    processBlock();
+            };
+
+            juce::AudioBuffer<float> live, cached;
+            const int cachedBefore = engine.getNumCachedPresses();
+            playAndCapture(live);
+            expect(engine.getNumCachedPresses() == cachedBefore, "presses render live before the cache is built");
+
+            processor.getAttackCache().buildNow();
+            playAndCapture(cached);
+            expect(engine.getNumCachedPresses() == cachedBefore + 1, "a press starts from the attack cache once it's built");
+            expect(processor.getAttackCache().getSizeInBytes() > 0, "attack cache holds rendered chords");
+
+            float largestDifference = 0.0f;
+            for (int i = 0; i < live.getNumSamples(); ++i)
+                largestDifference = juce::jmax(largestDifference, std::abs(live.getSample(0, i) - cached.getSample(0, i)));
+
+            expect(live.getMagnitude(0, 0, live.getNumSamples()) > 0.0f && largestDifference < 1.0e-4f,
+                   "cached attack matches live rendering through the handover");
+            expect(getPeak() == 0.0f && engine.getNumActiveVoices() == 0, "cached press releases cleanly");
+        }
+
+        void checkSharedAttackPool()
+        {
+            // More instances of the plugin add only the openings none of them has rendered
+            // yet, and an instance's own ones go when it does
+            juce::SharedResourcePointer<AttackCache::SharedPool> sharedPool;
+            processor.getAttackCache().buildNow();
+            const int entriesBefore = sharedPool->getNumEntries();
+
+            juce::MemoryBlock state;
+            processor.getStateInformation(state);
+
+            auto createInstance = [&](double sampleRate) {
+                auto instance = std::make_unique<PianoXLAudioProcessor>(false);
+                instance->setStateInformation(state.getData(), (int) state.getSize());
+                instance->getEngineStateBridge().flushPendingChanges();
+                instance->setPlayConfigDetails(0, 2, sampleRate, options.blockSize);
+                instance->prepareToPlay(sampleRate, options.blockSize);
+
+                // The cache follows what the engine has played with, so run it once
+                juce::AudioBuffer<float> instanceBuffer(2, options.blockSize);
+                juce::MidiBuffer instanceMidi;
+                instance->processBlock(instanceBuffer, instanceMidi);
+                instance->getAttackCache().buildNow();
+                return instance;
+            };
+
+            {
+                auto sameRate = createInstance(options.sampleRate);
+                expect(entriesBefore > 0 && sameRate->getAttackCache().getSizeInBytes() > 0
+                           && sharedPool->getNumEntries() == entriesBefore,
+                       "a second instance plays the first one's rendered attacks");
+
+                auto otherRate = createInstance(options.sampleRate * 2.0);
+                expect(sharedPool->getNumEntries() > entriesBefore,
+                       "an instance at another sample rate renders its own attacks");
+
+                otherRate->releaseResources();
+                otherRate.reset();
+                expect(sharedPool->getNumEntries() == entriesBefore, "its attacks are freed when it goes");
+
+                sameRate->releaseResources();
+            }
+
+            expect(sharedPool->getNumEntries() == entriesBefore, "shared attacks stay while an instance uses them");
+        }
+
+        void checkTuning()
+        {
+            auto equal = TuningTable::createEqualTemperament(TuningTable::defaultA4);
+            expect(std::abs(equal->getFrequency(69) - 440.0f) < 1.0e-3f && std::abs(equal->getFrequency(60) - 261.626f) < 1.0e-2f,
+                   "12-TET table puts A4 at 440 Hz");
+
+            // The same tuning written as a Scala scale
+            juce::String scale = "! 12tet.scl\n12-tone equal temperament\n 12\n!\n";
+            for (int i = 1; i <= 12; ++i)
+                scale << juce::String(i * 100.0, 1) << "\n";
+
+            juce::String error;
+            auto scala = TuningTable::createFromScala(scale, {}, TuningTable::defaultA4, error);
+            float largestDifference = scala != nullptr ? 0.0f : 1.0f;
+            for (int note = 0; scala != nullptr && note < TuningTable::numNotes; ++note)
+                largestDifference = juce::jmax(largestDifference, std::abs(scala->getFrequency(note) / equal->getFrequency(note) - 1.0f));
+
+            expect(largestDifference < 1.0e-5f, "a Scala scale of 100-cent steps matches 12-TET");
+
+            auto lowered = TuningTable::createFromScala(scale, {}, 432.0, error);
+            expect(lowered != nullptr && std::abs(lowered->getFrequency(69) - 432.0f) < 1.0e-3f, "A4 moves a Scala tuning");
+
+            // Seven-key map: the black keys are left unmapped
+            const juce::String keyboardMap = "12\n0\n127\n60\n69\n440.0\n12\n0\nx\n2\nx\n4\n5\nx\n7\nx\n9\nx\n11\n";
+            auto mapped = TuningTable::createFromScala(scale, keyboardMap, TuningTable::defaultA4, error);
+            expect(mapped != nullptr && mapped->getFrequency(61) == 0.0f && std::abs(mapped->getFrequency(62) - equal->getFrequency(62)) < 1.0e-2f,
+                   "keyboard map leaves 'x' keys unmapped");
+
+            expect(TuningTable::createFromScala("Broken\n3\n100.0\nfoo\n", {}, TuningTable::defaultA4, error) == nullptr
+                       && error.isNotEmpty(),
+                   "a malformed scale is rejected with a reason");
+
+            // The processor follows the state, and its voices play what the table says
+            auto& tuning = processor.getTuning();
+            auto& appState = processor.getAppState();
+            appState.setProperty(IDs::TUNING_A4, 432.0, nullptr);
+            tuning.buildNow();
+            expect(std::abs(tuning.getCurrentTable()->getFrequency(69) - 432.0f) < 1.0e-3f, "TUNING_A4 rebuilds the table");
+
+            // A chord played now sounds at the table's frequencies; 12-TET at 440 Hz would be a third of a semitone off
+            processor.getAttackCache().buildNow();
+            midi.addEvent(juce::MidiMessage::noteOn(1, 57, (juce::uint8) 100), 0);
+            processBlock();
+
+            const auto table = tuning.getCurrentTable();
+            int numVoicesChecked = 0;
+            bool voicesFollowTable = true;
+            for (const auto& voice : processor.getChordEngine().getVoices())
+            {
+                if (!voice.active)
+                    continue;
+
+                const float frequency = voice.phaseIncrement * (float) options.sampleRate / juce::MathConstants<float>::twoPi;
+                float nearest = 1.0f;
+                for (int note = 0; note < TuningTable::numNotes; ++note)
+                    nearest = juce::jmin(nearest, std::abs(frequency / table->getFrequency(note) - 1.0f));
+
+                voicesFollowTable = voicesFollowTable && nearest < 1.0e-4f;
+                ++numVoicesChecked;
+            }
+
+            expect(numVoicesChecked > 0 && voicesFollowTable, "voices play at the table's frequencies");
+
+            midi.addEvent(juce::MidiMessage::noteOff(1, 57), 0);
+            for (int i = 0; i < (int) std::ceil(0.3 * options.sampleRate / options.blockSize); ++i)
+                processBlock();
+
+            appState.setProperty(IDs::TUNING_SCALE, "Broken\n3\n", nullptr);
+            tuning.buildNow();
+            expect(tuning.getLastError().isNotEmpty() && std::abs(tuning.getCurrentTable()->getFrequency(69) - 432.0f) < 1.0e-3f,
+                   "a bad scale in the state keeps the previous tuning");
+
+            appState.setProperty(IDs::TUNING_SCALE, juce::String(), nullptr);
+            appState.setProperty(IDs::TUNING_A4, TuningTable::defaultA4, nullptr);
+            tuning.buildNow();
+            processBlock(); // The engine picks the table up at the start of a block
+            expect(std::abs(tuning.getCurrentTable()->getFrequency(69) - 440.0f) < 1.0e-3f && getPeak() == 0.0f,
+                   "tuning goes back to 12-TET at 440 Hz");
+        }
+
+        // One voice's envelope spelled out a sample at a time with plain branches, from the
+        // same settings SynthVoice::start takes, to check the SIMD lanes against
+        struct ReferenceVoice
+        {
+            ReferenceVoice(float frequency, float gain, bool isBassVoice, int startDelaySamples, int lengthSamples, const SynthVoice::Shape& shape)
+                : isBass(isBassVoice),
+                  delay(startDelaySamples),
+                  untilRelease(juce::jmax(1, lengthSamples)),
+                  phaseIncrement(juce::MathConstants<float>::twoPi * frequency / shape.sampleRate),
+                  level(gain),
+                  floorLevel(gain * shape.sustainProportion),
+                  decayMultiplier(shape.decayMultiplier),
+                  attackStep(shape.attackStep),
+                  endReleaseStep(shape.endReleaseStep)
+            {
+                // Sample start: the note begins that far into its decay
+                const int skipped = juce::jmin(shape.skippedSamples, untilRelease - 1);
+                for (int i = 0; i < skipped; ++i)
+                    decay();
+
+                untilRelease -= skipped;
+                phase = std::fmod(phaseIncrement * (float) skipped, juce::MathConstants<float>::twoPi);
+            }
+
+            void stop(float seconds, double sampleRate)
+            {
+                if (delay > 0 && !releasing)
+                {
+                    active = false;
+                    return;
+                }
+
+                const float step = 1.0f / juce::jmax(1.0f, seconds * (float) sampleRate);
+                releaseStep = releasing ? juce::jmax(releaseStep, step) : step;
+                releasing = true;
+            }
+
+            float next(float busGain)
+            {
+                if (!active || release <= 0.0f)
+                    return 0.0f;
+
+                if (delay > 0)
+                {
+                    --delay;
+                    return 0.0f;
+                }
+
+                const float sample = std::sin(phase) * level * attack * release * busGain;
+
+                phase += phaseIncrement;
+                if (phase >= juce::MathConstants<float>::twoPi)
+                    phase -= juce::MathConstants<float>::twoPi;
+
+                attack = juce::jmin(1.0f, attack + attackStep);
+                decay();
+
+                if (!releasing && --untilRelease <= 0)
+                {
+                    releasing = true;
+                    releaseStep = endReleaseStep;
+                }
+
+                if (releasing)
+                    release = juce::jmax(0.0f, release - releaseStep);
+
+                return sample;
+            }
+
+            bool isSounding() const { return active && release > 0.0f; }
+
+            const bool isBass;
+
+        private:
+            // Towards the floor, or up to it for sustain over 100%
+            void decay()
+            {
+                level = decayMultiplier < 1.0f ? juce::jmax(floorLevel, level * decayMultiplier)
+                                               : juce::jmin(floorLevel, level * decayMultiplier);
+            }
+
+            int delay, untilRelease;
+            float phase = 0.0f, phaseIncrement, level, floorLevel, decayMultiplier;
+            float attack = 0.0f, attackStep, release = 1.0f, releaseStep = 0.0f, endReleaseStep;
+            bool releasing = false, active = true;
+        };
+
+        void checkEnvelopeLanes()
+        {
+            // Voices whose envelopes share SIMD registers must each follow the envelope worked
+            // out sample by sample: flammed, swelling past 100% sustain, cut short by their
+            // length or by a stop partway through a block
+            const int numVoices = SynthVoice::envelopeLanes;
+            const int stopPosition = options.blockSize / 3;
+            const int numBlocks = 2 + (int) std::ceil((numVoices * 138 + SynthVoice::releaseSeconds * options.sampleRate) / options.blockSize);
+            std::vector<SynthVoice> grouped((size_t) numVoices);
+            std::vector<SynthVoice*> groupedPointers;
+            std::vector<ReferenceVoice> reference;
+            const auto tuning = TuningTable::createEqualTemperament(TuningTable::defaultA4);
+            for (int i = 0; i < numVoices; ++i)
+            {
+                const SynthVoice::Shape shape { options.sampleRate, 40.0f + 20.0f * (float) i, i % 2 == 0 ? 0.0f : 3.0f };
+                const float frequency = tuning->getFrequency(48 + i * 3);
+                const int startDelay = i * 37, length = options.blockSize / 2 + i * 101;
+
+                grouped[(size_t) i].start(frequency, 0.1f, i == 0, -1, startDelay, length, shape);
+                groupedPointers.push_back(&grouped[(size_t) i]);
+                reference.emplace_back(frequency, 0.1f, i == 0, startDelay, length, shape);
+            }
+
+            const float chordGain = 0.75f, bassGain = 0.25f;
+            juce::HeapBlock<float> chordGains((size_t) options.blockSize), bassGains((size_t) options.blockSize);
+            juce::FloatVectorOperations::fill(chordGains.get(), chordGain, options.blockSize);
+            juce::FloatVectorOperations::fill(bassGains.get(), bassGain, options.blockSize);
+
+            juce::AudioBuffer<float> groupedOut(1, options.blockSize), referenceOut(1, options.blockSize);
+            float largestDifference = 0.0f;
+
+            auto renderBoth = [&](int start, int numSamples) {
+                SynthVoice::renderVoices(groupedPointers.data(), numVoices, groupedOut.getWritePointer(0, start), nullptr,
+                                         chordGains.get(), bassGains.get(), numSamples);
+
+                for (int i = start; i < start + numSamples; ++i)
+                {
+                    float sum = 0.0f;
+                    for (auto& voice : reference)
+                        sum += voice.next(voice.isBass ? bassGain : chordGain);
+
+                    referenceOut.setSample(0, i, sum);
+                }
+            };
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                groupedOut.clear();
+
+                if (block == 1)
+                {
+                    renderBoth(0, stopPosition);
+                    grouped[5].stop(SynthVoice::releaseSeconds, options.sampleRate);
+                    reference[5].stop(SynthVoice::releaseSeconds, options.sampleRate);
+                    renderBoth(stopPosition, options.blockSize - stopPosition);
+                }
+                else
+                {
+                    renderBoth(0, options.blockSize);
+                }
+
+                for (int i = 0; i < options.blockSize; ++i)
+                    largestDifference = juce::jmax(largestDifference, std::abs(groupedOut.getSample(0, i) - referenceOut.getSample(0, i)));
+            }
+
+            expect(largestDifference < 1.0e-5f, "voices rendered together follow the sample-by-sample envelope");
+            expect(std::none_of(grouped.begin(), grouped.end(), [](const SynthVoice& voice) { return voice.active; })
+                       && std::none_of(reference.begin(), reference.end(), [](const ReferenceVoice& voice) { return voice.isSounding(); }),
+                   "every voice finishes its release");
+        }
+
+        void checkThreadedVoiceRendering()
+        {
+            // A full house of voices rendered on the audio thread alone and split across
+            // workers should come out the same, give or take the order of the sums
+            const int numVoices = ChordEngine::maxVoices;
+            std::vector<SynthVoice> singleVoices((size_t) numVoices), threadedVoices;
+            const auto tuning = TuningTable::createEqualTemperament(TuningTable::defaultA4);
+            const SynthVoice::Shape shape(options.sampleRate, 80.0f, 0.0f);
+            for (int i = 0; i < numVoices; ++i)
+                singleVoices[(size_t) i].start(tuning->getFrequency(36 + i % 60), 0.01f, i % 5 == 0, -1, i * 7, options.blockSize * 8, shape);
+            threadedVoices = singleVoices;
+
+            juce::HeapBlock<float> chordGains((size_t) options.blockSize), bassGains((size_t) options.blockSize);
+            juce::FloatVectorOperations::fill(chordGains.get(), 0.75f, options.blockSize);
+            juce::FloatVectorOperations::fill(bassGains.get(), 0.25f, options.blockSize);
+
+            VoiceRenderPool single(0), threaded(VoiceRenderPool::maxWorkers), otherInstance(VoiceRenderPool::maxWorkers);
+            single.prepare(options.blockSize, numVoices);
+            threaded.prepare(options.blockSize, numVoices);
+            otherInstance.prepare(options.blockSize, numVoices);
+
+            std::vector<SynthVoice> otherVoices = singleVoices;
+            juce::AudioBuffer<float> singleOut(2, options.blockSize), threadedOut(2, options.blockSize), otherOut(2, options.blockSize);
+            float largestDifference = 0.0f;
+            bool allThreaded = true, workersShared = true;
+
+            // Each block in two pieces, as a MIDI event partway through would split it
+            const int split = options.blockSize / 3;
+            auto renderPieces = [&](VoiceRenderPool& pool, std::vector<SynthVoice>& voices, juce::AudioBuffer<float>& out, bool& threadedThroughout) {
+                for (const auto piece : { std::make_pair(0, split), std::make_pair(split, options.blockSize - split) })
+                {
+                    pool.render(voices.data(), numVoices, out.getWritePointer(0, piece.first), out.getWritePointer(1, piece.first),
+                                chordGains.get(), bassGains.get(), piece.second);
+                    threadedThroughout = threadedThroughout && pool.wasLastBlockThreaded();
+                }
+            };
+
+            for (int block = 0; block < 16; ++block)
+            {
+                singleOut.clear();
+                threadedOut.clear();
+
+                bool ignored = true;
+                single.beginBlock(singleVoices.data(), numVoices);
+                renderPieces(single, singleVoices, singleOut, ignored);
+                single.endBlock();
+
+                threaded.beginBlock(threadedVoices.data(), numVoices);
+                renderPieces(threaded, threadedVoices, threadedOut, allThreaded);
+
+                // Another instance's block, every other time while this one still has the shared workers
+                const bool whileTaken = block % 2 == 0;
+                if (!whileTaken)
+                    threaded.endBlock();
+
+                otherInstance.beginBlock(otherVoices.data(), numVoices);
+                otherInstance.render(otherVoices.data(), numVoices, otherOut.getWritePointer(0), otherOut.getWritePointer(1),
+                                     chordGains.get(), bassGains.get(), options.blockSize);
+                workersShared = workersShared && otherInstance.wasLastBlockThreaded() == !whileTaken;
+                otherInstance.endBlock();
+                threaded.endBlock();
+
+                for (int channel = 0; channel < 2; ++channel)
+                    for (int i = 0; i < options.blockSize; ++i)
+                        largestDifference = juce::jmax(largestDifference, std::abs(singleOut.getSample(channel, i) - threadedOut.getSample(channel, i)));
+            }
+
+            expect(allThreaded && !single.wasLastBlockThreaded(), "128 voices split across workers, none without them");
+            expect(workersShared, "instances share the workers, one block at a time");
+            expect(largestDifference < 1.0e-4f, "threaded voice rendering matches single-threaded");
+        }
+
+        void checkMidiOutput()
+        {
+            // MIDI_OUTPUT mode with a 1/16 flam: the chord should come out as evenly staggered
+            // note-ons on channel 1, the bass on channel 2 with the first of them, and no audio
+            processor.getAppState().setProperty(IDs::MIDI_OUTPUT, true, nullptr);
+            processor.getEngineStateBridge().flushPendingChanges();
+            setParameter("flam", 0.25f);
+            setParameter("fader", 0.5f);
+
+            const int offset = options.blockSize / 3;
+            midi.addEvent(juce::MidiMessage::noteOn(1, 60, (juce::uint8) 100), offset);
+
+            juce::Array<juce::int64> chordNoteOns, bassNoteOns;
+            const float peak = collectNoteOns(1.0, chordNoteOns, bassNoteOns); // Longer than any flam
+
+            bool evenlySpaced = chordNoteOns.size() >= 3;
+            for (int i = 2; i < chordNoteOns.size(); ++i)
+            {
+                const auto spacing = chordNoteOns[i] - chordNoteOns[i - 1];
+                evenlySpaced = evenlySpaced && spacing > 0 && std::abs(spacing - (chordNoteOns[1] - chordNoteOns[0])) <= 1;
+            }
+
+            expect(peak == 0.0f, "no audio in MIDI output mode");
+            expect(!chordNoteOns.isEmpty() && chordNoteOns[0] == offset, "first chord note-on at the input's sample position");
+            expect(evenlySpaced, "flammed chord note-ons evenly staggered");
+            expect(bassNoteOns.size() == 1 && bassNoteOns[0] == offset, "bass note-on on channel 2 with the chord");
+
+            // Releasing the key ends every note it started
+            midi.addEvent(juce::MidiMessage::noteOff(1, 60), 0);
+            processBlock(false);
+            int noteOffs = 0;
+            for (const auto metadata : midi)
+                noteOffs += metadata.getMessage().isNoteOff() ? 1 : 0;
+
+            midi.clear();
+            expect(noteOffs == chordNoteOns.size() + bassNoteOns.size(), "note-off in ends every generated note");
+
+            processor.getAppState().setProperty(IDs::MIDI_OUTPUT, false, nullptr);
+            processor.getEngineStateBridge().flushPendingChanges();
+            setParameter("flam", 0.0f);
+            setParameter("fader", 0.25f);
+        }
+
+        void checkArpeggiator()
+        {
+            // UP at 1/16 with no host transport: one note per sixteenth at the BPM parameter's
+            // tempo, from the press until the note-off
+            processor.getAppState().setProperty(IDs::MIDI_OUTPUT, true, nullptr);
+            processor.getEngineStateBridge().flushPendingChanges();
+            setParameter("fader", 0.5f);
+            setParameter("arpMode", 1.0f / (Arpeggiator::numPatterns - 1));
+            setParameter("arpRate", 4.0f / (Arpeggiator::numRates - 1));
+
+            const int offset = options.blockSize / 5;
+            midi.addEvent(juce::MidiMessage::noteOn(1, 60, (juce::uint8) 100), offset);
+
+            juce::Array<juce::int64> stepNoteOns, bassNoteOns;
+            collectNoteOns(1.0, stepNoteOns, bassNoteOns);
+
+            const double bpm = (double) processor.getAppState().getProperty(IDs::BPM, 120.0);
+            const double stepSamples = Arpeggiator::getStepBeats(4) * 60.0 / bpm * options.sampleRate;
+
+            bool onGrid = stepNoteOns.size() >= 4;
+            for (int i = 0; i < stepNoteOns.size(); ++i)
+                onGrid = onGrid && std::abs((double) (stepNoteOns[i] - offset) - i * stepSamples) <= 1.0;
+
+            expect(onGrid, "arp steps every sixteenth from the press");
+            expect(bassNoteOns.size() == 1, "bass plays once under the arp");
+
+            midi.addEvent(juce::MidiMessage::noteOff(1, 60), 0);
+            processBlock();
+            collectNoteOns(0.5, stepNoteOns, bassNoteOns);
+            expect(stepNoteOns.isEmpty(), "arp stops on note-off");
+
+            processor.getAppState().setProperty(IDs::MIDI_OUTPUT, false, nullptr);
+            processor.getEngineStateBridge().flushPendingChanges();
+            setParameter("arpMode", 0.0f);
+            setParameter("fader", 0.25f);
+        }
+
+        void checkRecorder()
+        {
+            // Three presses at known sample times are captured, drained into the progression,
+            // and come back at the same offsets when the progression is played
+            auto& recorder = processor.getRecorder();
+            recorder.startRecording(MemoryBank::capture(processor.getAppState()));
+
+            const juce::int64 pressTimes[] = { 100, 100 + 3 * (juce::int64) options.blockSize + 17, 100 + 7 * (juce::int64) options.blockSize };
+            juce::int64 blockStart = 0;
+            for (int i = 0; i < 10; ++i)
+            {
+                for (int n = 0; n < 3; ++n)
+                    if (pressTimes[n] >= blockStart && pressTimes[n] < blockStart + options.blockSize)
+                        midi.addEvent(juce::MidiMessage::noteOn(1, 60 + 2 * n, (juce::uint8) 100), (int) (pressTimes[n] - blockStart));
+
+                processBlock();
+                blockStart += options.blockSize;
+            }
+
+            recorder.stopRecording();
+            auto progression = recorder.getProgression();
+
+            bool timesMatch = progression->chords.size() == 3;
+            for (size_t n = 0; timesMatch && n < 3; ++n)
+                timesMatch = progression->chords[n].time == pressTimes[n] - pressTimes[0] && progression->chords[n].voicing.isPlayable();
+
+            expect(timesMatch, "recorded presses keep their sample offsets");
+            expect(recorder.getNumDropped() == 0, "no presses dropped while recording");
+            expect(PerformanceRecorder::createMidiFile(*progression, 120.0).getNumTracks() == 1, "progression exports as a MIDI file");
+
+            // Saved and read back field by field; a cut-short copy is refused and changes nothing
+            juce::MemoryOutputStream saved;
+            recorder.writeChunk(saved);
+
+            PerformanceRecorder reloaded;
+            reloaded.setSampleRate(options.sampleRate);
+            reloaded.readChunk(saved.getData(), saved.getDataSize());
+            reloaded.readChunk(saved.getData(), saved.getDataSize() - 1);
+            auto reloadedProgression = reloaded.getProgression();
+
+            bool savedIntact = reloadedProgression->chords.size() == progression->chords.size();
+            for (size_t n = 0; savedIntact && n < progression->chords.size(); ++n)
+            {
+                const auto& original = progression->chords[n];
+                const auto& copy = reloadedProgression->chords[n];
+                savedIntact = copy.time == original.time && copy.keyIndex == original.keyIndex && copy.slotIndex == original.slotIndex
+                              && copy.voicing.numNotes == original.voicing.numNotes && copy.voicing.bassNote == original.voicing.bassNote
+                              && std::equal(copy.voicing.notes, copy.voicing.notes + copy.voicing.numNotes, original.voicing.notes);
+            }
+
+            expect(savedIntact, "a saved progression reads back unchanged, and a truncated one is refused");
+
+            processor.getAppState().setProperty(IDs::MIDI_OUTPUT, true, nullptr);
+            processor.getEngineStateBridge().flushPendingChanges();
+            processor.getChordEngine().setPlayback(progression);
+
+            juce::Array<juce::int64> chordNoteOns, bassNoteOns;
+            collectNoteOns(0.5, chordNoteOns, bassNoteOns);
+
+            bool playedBack = bassNoteOns.size() == 3;
+            for (int n = 0; playedBack && n < 3; ++n)
+                playedBack = bassNoteOns[n] == pressTimes[n] - pressTimes[0];
+
+            expect(playedBack, "playback lands on the recorded offsets");
+
+            processor.getChordEngine().setPlayback(nullptr);
+            processBlock();
+            processor.getAppState().setProperty(IDs::MIDI_OUTPUT, false, nullptr);
+            processor.getEngineStateBridge().flushPendingChanges();
+        }
+
+        void checkSmoothProgression()
+        {
+            // Played back with smooth voicing, a whole progression is voiced for the least total
+            // movement, which is never more than choosing press by press
+            processor.getAppState().setProperty(IDs::SMOOTH_VOICING, true, nullptr);
+            processor.getEngineStateBridge().flushPendingChanges();
+            const auto& state = processor.getEngineStateBridge().getCompiledState();
+
+            bool defaultsMatch = true;
+            for (int index = 0; index < AppStateModel::numSlots; ++index)
+            {
+                const auto& candidates = state.candidates[index];
+                if (candidates.numCandidates > 0)
+                    defaultsMatch = defaultsMatch && VoiceLeading::findCandidate(candidates, state.voicings[index]) == candidates.defaultCandidate;
+            }
+
+            expect(defaultsMatch, "each slot's default candidate is its INVERSION_VALUE voicing");
+
+            const int keys[] = { 0, 9, 5, 7, 0 };
+            RecordedProgression progression;
+            for (int key : keys)
+            {
+                RecordedChord chord;
+                chord.keyIndex = (juce::int8) key;
+                chord.voicing = state.voicings[AppStateModel::getFlatSlotIndex(key, 0)];
+                progression.chords.push_back(chord);
+            }
+
+            // One chord recorded with a setup the current one doesn't voice
+            RecordedChord foreign;
+            foreign.keyIndex = 2;
+            foreign.voicing.numNotes = 1;
+            foreign.voicing.notes[0] = 1;
+            progression.chords.push_back(foreign);
+
+            int pressByPressCost = 0;
+            const Voicing* previous = nullptr;
+            for (int key : keys)
+            {
+                const auto& voicing = VoiceLeading::chooseVoicing(state.candidates[AppStateModel::getFlatSlotIndex(key, 0)], previous);
+                if (previous != nullptr)
+                    pressByPressCost += VoiceLeading::getMovementCost(*previous, voicing);
+
+                previous = &voicing;
+            }
+
+            PerformanceRecorder::applySmoothVoicing(progression, state);
+
+            int smoothCost = 0;
+            bool allCandidates = true;
+            for (int n = 0; n < juce::numElementsInArray(keys); ++n)
+            {
+                const auto& voicing = progression.chords[(size_t) n].voicing;
+                allCandidates = allCandidates && VoiceLeading::findCandidate(state.candidates[AppStateModel::getFlatSlotIndex(keys[n], 0)], voicing) >= 0;
+                if (n > 0)
+                    smoothCost += VoiceLeading::getMovementCost(progression.chords[(size_t) n - 1].voicing, voicing);
+            }
+
+            expect(allCandidates && smoothCost <= pressByPressCost, "a smoothed progression moves no more than press-by-press voicing");
+            expect(progression.chords.back().voicing.numNotes == 1 && progression.chords.back().voicing.notes[0] == 1,
+                   "chords the current setup doesn't voice keep their notes");
+
+            processor.getAppState().setProperty(IDs::SMOOTH_VOICING, false, nullptr);
+            processor.getEngineStateBridge().flushPendingChanges();
+        }
+
+        void checkChordRecognizer()
+        {
+            // Every chord type is named back as itself on every root
+            auto getMask = [](int root, int chordType) {
+                const auto& type = MusicTheory::getChordType(chordType);
+                juce::uint16 mask = 0;
+                for (int i = 0; i < type.numIntervals; ++i)
+                    mask |= (juce::uint16) (1 << MusicTheory::wrapPitchClass(root + type.intervals[i]));
+                return mask;
+            };
+
+            int numMisnamed = 0;
+            for (int type = 0; type < MusicTheory::getNumChordTypes(); ++type)
+            {
+                for (int root = 0; root < MusicTheory::numPitchClasses; ++root)
+                {
+                    const auto chord = ChordRecognizer::recognise(getMask(root, type), root);
+                    if (!chord.isValid() || chord.root != root || getMask(chord.root, chord.chordType) != getMask(root, type))
+                        ++numMisnamed;
+                }
+            }
+
+            expect(numMisnamed == 0, "every chord type is recognised from its notes");
+
+            const auto firstInversion = ChordRecognizer::recognise(getMask(0, 0), 4);
+            expect(firstInversion.root == 0 && firstInversion.bassOffset == 4 && firstInversion.inversion == 1,
+                   "C over E is C major in first inversion");
+
+            // C - Am/C - F - G7 rolled on one track, with the bass on another, as juce::MidiFile
+            // writes them (running status included)
+            const int ticksPerQuarterNote = 480;
+            const int chordNotes[4][4] = { { 60, 64, 67, -1 }, { 60, 64, 69, -1 }, { 60, 65, 69, -1 }, { 59, 62, 65, 67 } };
+            const int bassNotes[4] = { 48, 48, 41, 43 };
+
+            juce::MidiMessageSequence chordTrack, bassTrack;
+            for (int i = 0; i < 4; ++i)
+            {
+                const double start = i * 4.0 * ticksPerQuarterNote;
+                for (int n = 0; n < 4 && chordNotes[i][n] >= 0; ++n)
+                {
+                    chordTrack.addEvent(juce::MidiMessage::noteOn(1, chordNotes[i][n], (juce::uint8) 100), start + n * 5);
+                    chordTrack.addEvent(juce::MidiMessage::noteOff(1, chordNotes[i][n]), start + 1900.0);
+                }
+
+                bassTrack.addEvent(juce::MidiMessage::noteOn(2, bassNotes[i], (juce::uint8) 90), start);
+                bassTrack.addEvent(juce::MidiMessage::noteOn(2, bassNotes[i], (juce::uint8) 0), start + 1920.0);
+            }
+
+            chordTrack.sort();
+            bassTrack.sort();
+
+            juce::MidiFile midiFile;
+            midiFile.setTicksPerQuarterNote(ticksPerQuarterNote);
+            midiFile.addTrack(chordTrack);
+            midiFile.addTrack(bassTrack);
+
+            juce::MemoryOutputStream stream;
+            midiFile.writeTo(stream);
+
+            SmfReader::Header header;
+            std::vector<SmfReader::Note> notes;
+            juce::String error;
+            const bool read = SmfReader::readNotes(stream.getData(), stream.getDataSize(), header, notes, error);
+            expect(read && header.numTracks == 2 && header.ticksPerQuarterNote == ticksPerQuarterNote && notes.size() == 17
+                       && notes.front().start == 0 && notes.back().start == 3 * 4 * ticksPerQuarterNote + 15,
+                   "SMF reader finds every note at its tick");
+
+            ChordRecognizer::Analysis analysis;
+            ChordRecognizer::analyse(notes, ticksPerQuarterNote / 16, analysis);
+
+            juce::StringArray names;
+            for (const auto& segment : analysis.chords)
+                names.add(MusicTheory::getChordName(segment.chord.root, segment.chord.chordType, segment.chord.bassOffset, false, 0));
+
+            expect(names.joinIntoString(" ") == "C Am/C F G7" && analysis.key == 0 && analysis.modeIndex == (int) MusicTheory::Mode::major,
+                   "a progression is labelled chord by chord, in C major");
+
+            expect(!SmfReader::readNotes(stream.getData(), 10, header, notes, error) && error.isNotEmpty(),
+                   "a cut-off header is rejected");
+            expect(SmfReader::readNotes(stream.getData(), stream.getDataSize() / 2, header, notes, error) && !notes.empty(),
+                   "a truncated file keeps the notes before the cut");
+
+            // The same tracks as format 2 patterns: the bass one comes after the chords
+            juce::MemoryBlock format2(stream.getData(), stream.getDataSize());
+            static_cast<char*>(format2.getData())[9] = 2;
+
+            bool sequential = SmfReader::readNotes(format2.getData(), format2.getSize(), header, notes, error)
+                              && header.format == 2 && notes.size() == 17;
+            juce::int64 chordsEnd = 0;
+            for (const auto& note : notes)
+                if (note.channel == 0)
+                    chordsEnd = juce::jmax(chordsEnd, note.end);
+            for (const auto& note : notes)
+                sequential = sequential && (note.channel == 0 || note.start >= chordsEnd);
+
+            expect(sequential, "format 2 tracks are read one after the other, not on top of each other");
+        }
+
+        void checkChordNames()
+        {
+            int halfDiminished = -1;
+            for (int type = 0; type < MusicTheory::getNumChordTypes(); ++type)
+                if (juce::String(MusicTheory::getChordType(type).id) == "m7b5")
+                    halfDiminished = type;
+
+            const int freeMode = (int) MusicTheory::Mode::free, majorMode = (int) MusicTheory::Mode::major;
+            expect(juce::String(MusicTheory::formatChordName(1, halfDiminished, 6, false, freeMode).getText()) == "C#m7b5/G"
+                       && juce::String(MusicTheory::formatChordName(1, halfDiminished, 6, true, freeMode).getText()) == "Dbm7b5/G"
+                       && juce::String(MusicTheory::formatChordName(1, halfDiminished, 6, true, majorMode).getText()) == "C#m7b5/G",
+                   "chord names use flats only in FREE mode");
+
+            // Every root, type and bass fits the inline buffer whole
+            bool allFit = true;
+            for (int root = 0; root < MusicTheory::numPitchClasses; ++root)
+            {
+                for (int type = 0; type < MusicTheory::getNumChordTypes(); ++type)
+                {
+                    for (int bass = 0; bass < MusicTheory::numPitchClasses; ++bass)
+                    {
+                        juce::String expected(MusicTheory::getNoteName(root, true));
+                        expected << juce::CharPointer_UTF8(MusicTheory::getChordType(type).suffix);
+                        if (bass != 0)
+                            expected << "/" << MusicTheory::getNoteName(root + bass, true);
+
+                        const auto name = MusicTheory::formatChordName(root, type, bass, true, freeMode);
+                        allFit = allFit && juce::String(juce::CharPointer_UTF8(name.getText())) == expected;
+                    }
+                }
+            }
+            expect(allFit, "every chord name is formatted whole");
+
+            // What a mode change does to the key labels: 12 keys x 3 slots, in every mode
+            const auto allocationsBefore = allocationCount;
+            int numNamed = 0;
+            for (int mode = 0; mode < MusicTheory::numModes; ++mode)
+            {
+                for (int pitchClass = 0; pitchClass < MusicTheory::numPitchClasses; ++pitchClass)
+                {
+                    for (int slot = 0; slot < 3; ++slot)
+                    {
+                        const int chordType = MusicTheory::resolveChordType(pitchClass, 0, mode, slot);
+                        if (chordType >= 0)
+                            numNamed += MusicTheory::formatChordName(pitchClass, chordType, slot == 0 ? 4 : 0, false, mode).isEmpty() ? 0 : 1;
+                    }
+                }
+            }
+            expect(numNamed > 0 && allocationCount == allocationsBefore, "naming the key labels allocates nothing");
+
+            // Each distinct text and font is shaped once, however often it's drawn
+            GlyphCache cache;
+            juce::Image image(juce::Image::ARGB, 160, 48, true);
+            juce::Graphics g(image);
+            const juce::Font font { juce::FontOptions(17.6f) };
+            const juce::Font bigFont { juce::FontOptions(32.0f) };
+            const auto area = image.getBounds().toFloat();
+
+            for (int i = 0; i < 3; ++i)
+                cache.draw(g, "C#m7b5/G", font, area, juce::Justification::centredBottom);
+            cache.draw(g, "C#m7b5/G", bigFont, area, juce::Justification::centred);
+            cache.draw(g, "Dbm7b5/G", font, area, juce::Justification::centredBottom);
+
+            expect(cache.getNumEntries() == 3, "glyphs are shaped once per name and font");
+        }
+
+        void checkInputTraceReplay()
+        {
+           #if JUCE_LINUX && defined(__GLIBC__)
+            // JUCE's own containers allocate with malloc and realloc, not operator new
+            {
+                const auto allocationsBefore = allocationCount;
+                juce::MidiBuffer events;
+                events.addEvent(juce::MidiMessage::noteOn(1, 60, (juce::uint8) 100), 0);
+                expect(events.getNumEvents() == 1 && allocationCount > allocationsBefore, "malloc-based allocations are counted");
+            }
+           #endif
+
+            // A press, a fader move and the release, from the state the host's processor is in
+            InputTrace trace;
+            {
+                juce::MemoryBlock state;
+                processor.getStateInformation(state);
+                trace.setInitialState(state);
+            }
+
+            InputEvent press { 20.0, InputEvent::Type::keyDown, 0, 0, 0 };
+            InputEvent fader { 60.0, InputEvent::Type::fader };
+            fader.value = 0.75f;
+            InputEvent release { 300.0, InputEvent::Type::keyUp };
+            release.touchIndex = 0;
+
+            for (const auto& event : { press, fader, release })
+                trace.addEvent(event);
+
+            juce::MemoryOutputStream out;
+            trace.writeTo(out);
+            InputTrace loaded;
+            juce::MemoryInputStream in(out.getData(), out.getDataSize(), false);
+            expect(loaded.readFrom(in) && loaded.getEvents().size() == 3 && loaded.getEvents()[1].value == 0.75f
+                       && loaded.getInitialState() == trace.getInitialState(),
+                   "input trace round-trips");
+
+            TraceReplay replay(options, loaded);
+            const auto report = replay.run();
+            report.print();
+
+            expect(report.numEvents == 3 && report.numFrames > 0, "replay handles every event and renders frames");
+            expect(report.numPresses == 1, "replayed press sounds and its latency is measured");
+            expect(report.audioAllocations == 0, "audio thread doesn't allocate during the replay");
+            expect((double) replay.getProcessor().getAppState().getProperty(IDs::FADER_VALUE) == 0.75, "replayed fader move reaches the state");
+        }
+
+        void measureThroughput()
+        {
+            const int numBlocks = (int) (options.throughputSeconds * options.sampleRate / options.blockSize);
+            const double budgetMs = 1000.0 * options.blockSize / options.sampleRate;
+            const int blocksPerChord = juce::jmax(1, (int) (0.25 * options.sampleRate / options.blockSize));
+
+            double totalMs = 0.0, worstMs = 0.0;
+            int overruns = 0;
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                if (i % blocksPerChord == 0)
+                {
+                    const int note = 48 + (i / blocksPerChord * 7) % 36; // Circle of fifths across the slots
+                    midi.addEvent(juce::MidiMessage::noteOn(1, note, (juce::uint8) 100), (i * 37) % options.blockSize);
+                }
+
+                const auto start = juce::Time::getHighResolutionTicks();
+                processBlock();
+                const double ms = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1000.0;
+
+                totalMs += ms;
+                worstMs = juce::jmax(worstMs, ms);
+                overruns += ms > budgetMs ? 1 : 0;
+
+                if (!isFinite())
+                {
+                    expect(false, "finite output during throughput run");
+                    break;
+                }
+            }
+
+            const double realtimeFactor = totalMs > 0.0 ? (options.throughputSeconds * 1000.0) / totalMs : 0.0;
+            std::cout << "Throughput: " << numBlocks << " blocks of " << options.blockSize << " @ " << options.sampleRate
+                      << " Hz, " << juce::String(realtimeFactor, 1) << "x real time, average "
+                      << juce::String(totalMs / juce::jmax(1, numBlocks), 4) << " ms, worst "
+                      << juce::String(worstMs, 4) << " ms (budget " << juce::String(budgetMs, 4) << " ms), "
+                      << overruns << " overrun(s)" << std::endl;
+
+            if (options.strict)
+                expect(overruns == 0, "every block within its real-time budget");
+        }
+
+        //==============================================================================
+        // Runs for the given time with no input, noting the sample time of every note-on the
+        // processor sends (chord channel and bass channel separately). Returns the audio peak.
+        float collectNoteOns(double seconds, juce::Array<juce::int64>& chordNoteOns, juce::Array<juce::int64>& bassNoteOns)
+        {
+            chordNoteOns.clearQuick();
+            bassNoteOns.clearQuick();
+
+            juce::int64 blockStart = 0;
+            float peak = 0.0f;
+            const int numBlocks = (int) std::ceil(seconds * options.sampleRate / options.blockSize);
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                processBlock(false);
+                peak = juce::jmax(peak, getPeak());
+
+                for (const auto metadata : midi)
+                {
+                    const auto message = metadata.getMessage();
+                    if (message.isNoteOn())
+                        (message.getChannel() == 1 ? chordNoteOns : bassNoteOns).add(blockStart + metadata.samplePosition);
+                }
+
+                midi.clear();
+                blockStart += options.blockSize;
+            }
+
+            return peak;
+        }
+
+        // clearMidi = false keeps the processor's MIDI output in midi for inspection
+        void processBlock(bool clearMidi = true)
+        {
+            buffer.clear();
+            processor.processBlock(buffer, midi);
+            if (clearMidi)
+                midi.clear();
+        }
+
+        // Host automation: normalised value, as a host would send it
+        void setParameter(const juce::String& id, float normalisedValue)
+        {
+            for (auto* parameter : processor.getParameters())
+            {
+                if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter); ranged != nullptr && ranged->getParameterID() == id)
+                {
+                    ranged->setValueNotifyingHost(normalisedValue);
+                    return;
+                }
+            }
+
+            expect(false, "parameter exists");
+        }
+
+        float getPeak(int start = 0, int numSamples = -1) const
+        {
+            if (numSamples < 0)
+                numSamples = buffer.getNumSamples() - start;
+
+            float peak = 0.0f;
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                peak = juce::jmax(peak, buffer.getMagnitude(channel, start, numSamples));
+
+            return peak;
+        }
+
+        bool isFinite() const
+        {
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                    if (!std::isfinite(buffer.getSample(channel, i)))
+                        return false;
+
+            return true;
+        }
+
+        void expect(bool condition, const char* description)
+        {
+            std::cout << (condition ? "  ok   " : "  FAIL ") << description << std::endl;
+            failures += condition ? 0 : 1;
+        }
+
+        const Options options;
+        PianoXLAudioProcessor processor;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+        int failures = 0;
+    };
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser; // Message manager for the state listeners
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    const auto options = parseOptions(args);
+    if (options.startupTrace != juce::File())
+        StartupProfiler::enable(options.startupTrace); // Before the processor is made
+
+    if (options.replay != juce::File())
+    {
+        InputTrace trace;
+        if (!trace.loadFromFile(options.replay))
+        {
+            std::cout << "Couldn't read input trace " << options.replay.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        TraceReplay replay(options, trace);
+        const auto report = replay.run();
+        report.print();
+        return report.passes(options.strict) ? 0 : 1;
+    }
+
+    HeadlessHost host(options);
+    return host.run();
+}
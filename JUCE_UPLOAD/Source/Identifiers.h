@@ -10,9 +10,38 @@ namespace IDs
     const juce::Identifier INVERSION_SELECTED ("inversionSelected");
     const juce::Identifier INVERSION_VALUE ("inversionValue");
 
-    // We can add more identifiers here later for other settings
-    // const juce::Identifier SELECTED_KEY ("selectedKey");
-    // const juce::Identifier SELECTED_MODE ("selectedMode");
-    // const juce::Identifier SELECTED_OCTAVE ("selectedOctave");
-    // const juce::Identifier SELECTED_SOUND ("selectedSound");
+    // Performance settings
+    const juce::Identifier SELECTED_KEY ("selectedKey");         // 0..11, C = 0
+    const juce::Identifier SELECTED_MODE ("selectedMode");       // index into the mode list, 0 = FREE
+    const juce::Identifier SELECTED_OCTAVE ("selectedOctave");
+    const juce::Identifier SELECTED_SOUND ("selectedSound");     // index into the instrument list
+    const juce::Identifier USE_FLATS ("useFlats");
+    const juce::Identifier KEY_SIZE ("keySize");                 // slots per key: 1 = XL, 2 = XXL, 3 = XXXL
+    const juce::Identifier FADER_VALUE ("faderValue");           // chord/bass balance, 0..1
+    const juce::Identifier FLAM_VALUE ("flamValue");             // index into the flam options, 0 = OFF
+    const juce::Identifier BPM ("bpm");
+    const juce::Identifier EQ_LOW ("eqLow");                     // dB, -12..+12, low shelf at 320 Hz
+    const juce::Identifier EQ_MID ("eqMid");                     // dB, -12..+12, peak at 1 kHz
+    const juce::Identifier EQ_HIGH ("eqHigh");                   // dB, -12..+12, high shelf at 3.2 kHz
+    const juce::Identifier SUSTAIN ("sustain");                  // %, 10..200
+    const juce::Identifier SAMPLE_START ("sampleStart");         // ms, 0..500
+    const juce::Identifier SMOOTH_VOICING ("smoothVoicing");     // inversion chosen per press for least movement
+    const juce::Identifier MIDI_OUTPUT ("midiOutput");           // chords go out as MIDI instead of audio
+    const juce::Identifier SOFT_CLIP ("softClip");               // master soft clipper after the limiter
+    const juce::Identifier ARP_MODE ("arpMode");                 // index into Arpeggiator::patternNames, 0 = OFF
+    const juce::Identifier ARP_RATE ("arpRate");                 // index into Arpeggiator::rateNames, 0 = STRUM
+    const juce::Identifier ARP_GATE ("arpGate");                 // %, 10..100 of each step
+    const juce::Identifier ARP_PATTERN ("arpPattern");           // custom pattern, e.g. "1 3 2 -", see Arpeggiator::parsePattern
+    const juce::Identifier DISABLED_SLOT_MASK ("disabledSlotMask"); // 36-bit key/slot mask, see SlotMask.h
+    const juce::Identifier TUNING_A4 ("tuningA4");               // Hz, 392..494
+    const juce::Identifier TUNING_SCALE ("tuningScale");         // text of a Scala .scl file, empty = 12-TET
+    const juce::Identifier TUNING_KEYBOARD_MAP ("tuningKeyboardMap"); // text of a Scala .kbm file, empty = linear
+
+    // Slot grid (12 keys x 3 slots)
+    const juce::Identifier SLOTS ("Slots");
+    const juce::Identifier SLOT ("Slot");
+    const juce::Identifier KEY_INDEX ("keyIndex");
+    const juce::Identifier SLOT_INDEX ("slotIndex");
+    const juce::Identifier CHORD_TYPE_INDEX ("chordTypeIndex");
+    const juce::Identifier BASS_OFFSET ("bassOffset");           // semitones from the root, 0 = root
 }
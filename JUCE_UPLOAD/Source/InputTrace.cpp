@@ -0,0 +1,111 @@
+#include "InputTrace.h"
+#include "StateSerializer.h"
+
+namespace
+{
+    constexpr juce::uint32 fileMagic = StateSerializer::makeChunkId('P', 'X', 'I', 'T');
+    constexpr int fileVersion = 1;
+
+    // Enough for a few minutes of playing before the vector has to grow mid-recording
+    constexpr size_t initialCapacity = 16384;
+}
+
+int InputTrace::getControlIndex(const juce::String& controlName)
+{
+    for (int i = 0; i < numControls; ++i)
+        if (controlName == controlNames[i])
+            return i;
+
+    return -1;
+}
+
+void InputTrace::startRecording(const juce::MemoryBlock& stateAtStart)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    initialState = stateAtStart;
+    events.clear();
+    events.reserve(initialCapacity);
+    startTime = juce::Time::getMillisecondCounterHiRes();
+    recording = true;
+}
+
+void InputTrace::stopRecording()
+{
+    recording = false;
+}
+
+void InputTrace::record(InputEvent event)
+{
+    if (!recording)
+        return;
+
+    event.time = juce::Time::getMillisecondCounterHiRes() - startTime;
+    events.push_back(event);
+}
+
+void InputTrace::writeTo(juce::OutputStream& out) const
+{
+    out.writeInt((int) fileMagic);
+    out.writeInt(fileVersion);
+    out.writeInt((int) sizeof(InputEvent));
+    out.writeInt((int) initialState.getSize());
+    out.write(initialState.getData(), initialState.getSize());
+    out.writeInt((int) events.size());
+    out.write(events.data(), sizeof(InputEvent) * events.size());
+}
+
+bool InputTrace::readFrom(juce::InputStream& in)
+{
+    if ((juce::uint32) in.readInt() != fileMagic || in.readInt() != fileVersion || in.readInt() != (int) sizeof(InputEvent))
+        return false;
+
+    const int stateSize = in.readInt();
+    if (stateSize < 0 || in.getNumBytesRemaining() < stateSize)
+        return false;
+
+    juce::MemoryBlock state;
+    in.readIntoMemoryBlock(state, stateSize);
+
+    const int numEvents = in.readInt();
+    if (numEvents < 0 || in.getNumBytesRemaining() < (juce::int64) sizeof(InputEvent) * numEvents)
+        return false;
+
+    std::vector<InputEvent> loaded((size_t) numEvents);
+    in.read(loaded.data(), (int) (sizeof(InputEvent) * loaded.size()));
+
+    recording = false;
+    initialState = std::move(state);
+    events = std::move(loaded);
+    return true;
+}
+
+bool InputTrace::saveToFile(const juce::File& file) const
+{
+    if (!file.getParentDirectory().createDirectory())
+        return false;
+
+    juce::TemporaryFile temp(file);
+    if (auto out = temp.getFile().createOutputStream())
+    {
+        writeTo(*out);
+        const bool written = out->getStatus().wasOk();
+        out.reset();
+        return written && temp.overwriteTargetFileWithTemporary();
+    }
+
+    return false;
+}
+
+bool InputTrace::loadFromFile(const juce::File& file)
+{
+    juce::FileInputStream in(file);
+    return in.openedOk() && readFrom(in);
+}
+
+juce::File InputTrace::getDefaultFolder()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("PianoXL")
+               .getChildFile("InputTraces");
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <type_traits>
+#include <vector>
+
+// One user input, as the UI handled it: which key and slot, where the fader went,
+// which control was selected. Recorded at that level rather than as mouse positions,
+// so a trace replays the same way whatever the window size.
+struct InputEvent
+{
+    enum class Type : juce::uint8
+    {
+        keyDown,          // keyIndex, slotIndex, touchIndex
+        keyUp,            // touchIndex
+        fader,            // value
+        plus,
+        minus,
+        keySize,          // The XL button
+        selectControl,    // code = index into InputTrace::controlNames
+        selectMode,       // code = SELECTED_MODE
+        shortcut          // code = key code, modifiers = raw ModifierKeys flags, character
+    };
+
+    double time = 0.0;                // Milliseconds since the recording started
+    Type type = Type::keyDown;
+    juce::int8 keyIndex = 0;
+    juce::int8 slotIndex = 0;
+    juce::int8 touchIndex = -1;
+    int code = 0;
+    int modifiers = 0;
+    juce::uint32 character = 0;
+    float value = 0.0f;
+};
+
+static_assert(std::is_trivially_copyable<InputEvent>::value, "InputEvents are saved as raw data");
+
+//==============================================================================
+// A recording of everything the user did, with the state it started from, so a session
+// can be replayed exactly - PianoXLHeadlessHost --replay turns one into a benchmark.
+// Message thread only.
+class InputTrace
+{
+public:
+    // The settings panel's selectable controls, as selectControl events store them
+    static constexpr const char* controlNames[] = { "key", "octave", "inversion", "disable" };
+    static constexpr int numControls = (int) (sizeof(controlNames) / sizeof(controlNames[0]));
+    static int getControlIndex(const juce::String& controlName);
+
+    InputTrace() = default;
+
+    // stateAtStart is the processor's state (getStateInformation) when recording begins
+    void startRecording(const juce::MemoryBlock& stateAtStart);
+    void stopRecording();
+    bool isRecording() const noexcept { return recording; }
+
+    // Stamps the event with the time since recording started; ignored when not recording
+    void record(InputEvent event);
+
+    // For building a trace by hand. Events must be added in time order.
+    void setInitialState(const juce::MemoryBlock& state) { initialState = state; }
+    void addEvent(const InputEvent& event) { events.push_back(event); }
+
+    const juce::MemoryBlock& getInitialState() const noexcept { return initialState; }
+    const std::vector<InputEvent>& getEvents() const noexcept { return events; }
+    double getLengthMs() const noexcept { return events.empty() ? 0.0 : events.back().time; }
+
+    void writeTo(juce::OutputStream& out) const;
+    bool readFrom(juce::InputStream& in);
+
+    bool saveToFile(const juce::File& file) const;
+    bool loadFromFile(const juce::File& file);
+
+    // InputTraces in the app data folder
+    static juce::File getDefaultFolder();
+
+private:
+    juce::MemoryBlock initialState;
+    std::vector<InputEvent> events;
+    double startTime = 0.0;
+    bool recording = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(InputTrace)
+};
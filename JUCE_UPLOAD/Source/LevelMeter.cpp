@@ -0,0 +1,86 @@
+#include "LevelMeter.h"
+
+void LevelMeter::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    reset();
+}
+
+void LevelMeter::reset()
+{
+    ring.fill(0.0f);
+    ringPosition = 0;
+    decimationSum = 0.0f;
+    decimationCount = 0;
+    samplesUntilSnapshot = hopSize;
+}
+
+void LevelMeter::process(const juce::AudioBuffer<float>& buffer) noexcept
+{
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = juce::jmin(maxChannels, buffer.getNumChannels());
+
+    if (numSamples <= 0 || numChannels <= 0)
+        return;
+
+    Levels blockLevels;
+    blockLevels.numChannels = numChannels;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        blockLevels.peak[channel] = buffer.getMagnitude(channel, 0, numSamples);
+        blockLevels.rms[channel] = buffer.getRMSLevel(channel, 0, numSamples);
+    }
+
+    levels.push(blockLevels); // A reader that has fallen behind just misses blocks
+
+    if (spectrumEnabled.load(std::memory_order_relaxed))
+        addToSpectrum(buffer, numChannels);
+}
+
+void LevelMeter::addToSpectrum(const juce::AudioBuffer<float>& buffer, int numChannels) noexcept
+{
+    const int numSamples = buffer.getNumSamples();
+    const float* left = buffer.getReadPointer(0);
+    const float* right = buffer.getReadPointer(numChannels - 1);
+
+    // Averaging each group of samples is a crude low-pass, but plenty for a display
+    const float scale = 0.5f / (float) decimation;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        decimationSum += left[i] + right[i];
+
+        if (++decimationCount == decimation)
+        {
+            ring[(size_t) ringPosition] = decimationSum * scale;
+            ringPosition = (ringPosition + 1) & (fftSize - 1);
+            decimationSum = 0.0f;
+            decimationCount = 0;
+        }
+    }
+
+    samplesUntilSnapshot -= numSamples;
+    if (samplesUntilSnapshot > 0)
+        return;
+
+    samplesUntilSnapshot = juce::jmax(1, samplesUntilSnapshot + hopSize);
+
+    // Unroll the ring, oldest sample first
+    const int tail = fftSize - ringPosition;
+    std::copy(ring.begin() + ringPosition, ring.end(), outgoing.samples);
+    std::copy(ring.begin(), ring.begin() + ringPosition, outgoing.samples + tail);
+    outgoing.sampleRate = sampleRate / decimation;
+
+    snapshots.push(outgoing);
+}
+
+bool LevelMeter::popLatestSnapshot(Snapshot& dest)
+{
+    bool found = false;
+    snapshots.popAll([&dest, &found](const Snapshot& snapshot) {
+        dest = snapshot;
+        found = true;
+    });
+    return found;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include "CommandQueue.h"
+
+// Feeds the UI's meters from the audio thread without locks.
+//
+// Every block queues its peak and RMS per channel. With the spectrum on, the output is
+// also mixed to mono, decimated and kept in a ring; every hopSize input samples the
+// latest fftSize decimated samples are queued as a snapshot. The FFT itself runs on
+// the reader's side, so the audio thread only ever sums and copies.
+//
+// Each queue has one reader: LevelMeterComponent takes the levels and SpectrumComponent
+// the snapshots, both on the message thread.
+class LevelMeter
+{
+public:
+    static constexpr int maxChannels = 2;
+    static constexpr int fftOrder = 10;
+    static constexpr int fftSize = 1 << fftOrder;     // Decimated samples per snapshot
+    static constexpr int decimation = 4;              // Covers up to sampleRate / 8, where the chords are
+    static constexpr int hopSize = 1024;              // Input samples between snapshots, about 47 a second at 48 kHz
+
+    struct Levels
+    {
+        float peak[maxChannels] = {};
+        float rms[maxChannels] = {};
+        int numChannels = 0;
+    };
+
+    struct Snapshot
+    {
+        float samples[fftSize] = {};                  // Oldest first
+        double sampleRate = 0.0;                      // Of the decimated samples
+    };
+
+    LevelMeter() = default;
+
+    void prepare(double newSampleRate);
+    void reset();
+
+    // Audio thread
+    void process(const juce::AudioBuffer<float>& buffer) noexcept;
+
+    // Any thread. Snapshots cost nothing while nobody is looking at a spectrum.
+    void setSpectrumEnabled(bool shouldBeEnabled) noexcept { spectrumEnabled = shouldBeEnabled; }
+    bool isSpectrumEnabled() const noexcept { return spectrumEnabled.load(); }
+
+    // Level reader. Calls handler for every block's Levels since the last call.
+    template <typename Handler>
+    void popLevels(Handler&& handler) { levels.popAll(handler); }
+
+    // Snapshot reader. Copies the newest snapshot into dest; false if none arrived.
+    bool popLatestSnapshot(Snapshot& dest);
+
+private:
+    void addToSpectrum(const juce::AudioBuffer<float>& buffer, int numChannels) noexcept;
+
+    static constexpr int levelQueueCapacity = 128;
+    static constexpr int snapshotQueueCapacity = 4;
+
+    CommandQueue<Levels, levelQueueCapacity> levels;
+    CommandQueue<Snapshot, snapshotQueueCapacity> snapshots;
+    std::atomic<bool> spectrumEnabled { false };
+
+    double sampleRate = 44100.0;
+    std::array<float, fftSize> ring {};              // Decimated mono, written at ringPosition
+    int ringPosition = 0;
+    float decimationSum = 0.0f;
+    int decimationCount = 0;
+    int samplesUntilSnapshot = hopSize;
+    Snapshot outgoing;                                // Assembled here, then copied into the queue
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelMeter)
+};
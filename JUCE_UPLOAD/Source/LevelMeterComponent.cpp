@@ -0,0 +1,88 @@
+#include "LevelMeterComponent.h"
+
+LevelMeterComponent::LevelMeterComponent(LevelMeter& meterToRead)
+    : meter(meterToRead)
+{
+    setInterceptsMouseClicks(false, false);
+
+    for (int channel = 0; channel < LevelMeter::maxChannels; ++channel)
+    {
+        peakDecibels[channel] = floorDecibels;
+        rmsDecibels[channel] = floorDecibels;
+    }
+
+    startTimerHz(refreshRateHz);
+}
+
+LevelMeterComponent::~LevelMeterComponent()
+{
+    stopTimer();
+}
+
+float LevelMeterComponent::toProportion(float decibels) noexcept
+{
+    return juce::jlimit(0.0f, 1.0f, 1.0f - decibels / floorDecibels);
+}
+
+void LevelMeterComponent::timerCallback()
+{
+    // Combine every block since the last frame: the loudest peak, and the RMS of all of them
+    float peak[LevelMeter::maxChannels] = {};
+    float sumOfSquares[LevelMeter::maxChannels] = {};
+    int numBlocks = 0;
+
+    meter.popLevels([&](const LevelMeter::Levels& levels) {
+        for (int channel = 0; channel < levels.numChannels; ++channel)
+        {
+            peak[channel] = juce::jmax(peak[channel], levels.peak[channel]);
+            sumOfSquares[channel] += levels.rms[channel] * levels.rms[channel];
+        }
+
+        numChannels = levels.numChannels;
+        ++numBlocks;
+    });
+
+    const float fall = fallDecibelsPerSecond / (float) refreshRateHz;
+    bool changed = false;
+
+    for (int channel = 0; channel < LevelMeter::maxChannels; ++channel)
+    {
+        const float rms = numBlocks > 0 ? std::sqrt(sumOfSquares[channel] / (float) numBlocks) : 0.0f;
+        const float newPeak = juce::jmax(juce::Decibels::gainToDecibels(peak[channel], floorDecibels), peakDecibels[channel] - fall);
+        const float newRms = juce::jmax(juce::Decibels::gainToDecibels(rms, floorDecibels), rmsDecibels[channel] - fall);
+
+        changed = changed || newPeak != peakDecibels[channel] || newRms != rmsDecibels[channel];
+        peakDecibels[channel] = juce::jmax(newPeak, floorDecibels);
+        rmsDecibels[channel] = juce::jmax(newRms, floorDecibels);
+    }
+
+    if (changed)
+        repaint();
+}
+
+void LevelMeterComponent::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+    const float gap = 1.0f;
+    const float barWidth = (bounds.getWidth() - gap * (float) (numChannels - 1)) / (float) numChannels;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto bar = bounds.removeFromLeft(barWidth);
+        bounds.removeFromLeft(gap);
+
+        g.setColour(trackColour);
+        g.fillRoundedRectangle(bar, barWidth * 0.5f);
+
+        const float rmsHeight = bar.getHeight() * toProportion(rmsDecibels[channel]);
+        g.setColour(rmsColour);
+        g.fillRoundedRectangle(bar.withTop(bar.getBottom() - rmsHeight), barWidth * 0.5f);
+
+        if (peakDecibels[channel] > floorDecibels)
+        {
+            const float peakY = bar.getBottom() - bar.getHeight() * toProportion(peakDecibels[channel]);
+            g.setColour(peakDecibels[channel] >= -0.5f ? hotColour : peakColour);
+            g.fillRect(bar.getX(), juce::jmax(bar.getY(), peakY - 1.0f), bar.getWidth(), 1.5f);
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "LevelMeter.h"
+
+// Thin stereo output meter that sits beside the fader. Reads the processor's
+// LevelMeter at frame rate: RMS as the bar, peak as a line above it. Levels rise at
+// once and fall at fallDecibelsPerSecond, so short peaks stay readable.
+class LevelMeterComponent : public juce::Component,
+                            private juce::Timer
+{
+public:
+    explicit LevelMeterComponent(LevelMeter& meterToRead);
+    ~LevelMeterComponent() override;
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    void timerCallback() override;
+
+    static constexpr int refreshRateHz = 60;
+    static constexpr float floorDecibels = -60.0f;
+    static constexpr float fallDecibelsPerSecond = 24.0f;
+
+    // 0 at the floor, 1 at full scale
+    static float toProportion(float decibels) noexcept;
+
+    LevelMeter& meter;
+
+    float peakDecibels[LevelMeter::maxChannels];
+    float rmsDecibels[LevelMeter::maxChannels];
+    int numChannels = LevelMeter::maxChannels;
+
+    const juce::Colour trackColour = juce::Colour::fromString("#FF2A2A2A");
+    const juce::Colour rmsColour = juce::Colour::fromString("#FF6A6A6A");
+    const juce::Colour peakColour = juce::Colour::fromString("#FFD0D0D0");
+    const juce::Colour hotColour = juce::Colour::fromString("#FFE05A4A");
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelMeterComponent)
+};
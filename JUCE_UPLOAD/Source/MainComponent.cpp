@@ -1,34 +1,40 @@
 #include "MainComponent.h"
+#include "AppStateModel.h"
+#include "MusicTheory.h"
+#include "Arpeggiator.h"
+#include "StartupProfiler.h"
 #include <iostream> // For std::cout
 
-MainComponent::MainComponent()
-    : appState(IDs::APP_STATE), // Initialize ValueTree with a type
-      settingsPanel(appState) // Pass appState to SettingsPanelXLComponent constructor
+MainComponent::MainComponent(PianoXLAudioProcessor& processorToUse)
+    : processor(processorToUse),
+      undoManager(processorToUse.getUndoManager()),
+      appState(processorToUse.getAppState()),
+      memoryBank(processorToUse.getMemoryBank()),
+      engineStateBridge(processorToUse.getEngineStateBridge()),
+      settingsPanel(appState, &undoManager) // Pass appState to SettingsPanelXLComponent constructor
 {
-    // Initialize application state with default values
-    // Check if properties already exist (e.g. loaded from saved state)
-    // For now, we'll set them if they don't, or ensure they are there.
-    // Proper load/save will be handled by AudioProcessor.
-    if (!appState.hasProperty(IDs::INVERSION_SELECTED))
-        appState.setProperty(IDs::INVERSION_SELECTED, false, nullptr);
-    if (!appState.hasProperty(IDs::INVERSION_VALUE))
-        appState.setProperty(IDs::INVERSION_VALUE, 0, nullptr);
-    // More properties will be added here later...
+    const StartupProfiler::Scope scope("Main component");
+
+    appState.addListener(this);
+    setWantsKeyboardFocus(true); // For undo/redo shortcuts
+
 
     // Set background color to black
     setOpaque(true);
     getLookAndFeel().setColour(juce::ResizableWindow::backgroundColourId, juce::Colours::black);
 
+    // Every child goes in the content container; clicks go straight through it to them
+    content.setInterceptsMouseClicks(false, true);
+    addAndMakeVisible(content);
+
     // Set an initial size for the component itself.
     setSize (static_cast<int>(baseWidth), static_cast<int>(baseHeight));
 
-    // Initialize White Keys
+    // Initialize White Keys (labels and in-scale borders are set from appState by updateKeyLabels)
     for (int i = 0; i < 7; ++i)
     {
-        // Default to "C" key in scale for now for visual testing, others not in scale
-        bool isInScale = (whiteKeyNotes[i] == "C" || whiteKeyNotes[i] == "E" || whiteKeyNotes[i] == "G"); 
-        whiteKeys.push_back(std::make_unique<PianoKeyComponent>(whiteKeyNotes[i], false, isInScale));
-        addAndMakeVisible(*whiteKeys.back());
+        whiteKeys.push_back(std::make_unique<PianoKeyComponent>(whiteKeyNotes[i], false, false));
+        content.addAndMakeVisible(*whiteKeys.back());
     }
 
     // Initialize Black Keys
@@ -37,18 +43,21 @@ MainComponent::MainComponent()
     {
         if (!blackKeyNotes[i].isEmpty()) // Skip placeholders
         {
-            // Default to "F#" key in scale for now
-            bool isInScale = (blackKeyNotes[i] == "F#");
-            blackKeys.push_back(std::make_unique<PianoKeyComponent>(blackKeyNotes[i], true, isInScale));
-            addAndMakeVisible(*blackKeys.back());
+            blackKeys.push_back(std::make_unique<PianoKeyComponent>(blackKeyNotes[i], true, false));
+            content.addAndMakeVisible(*blackKeys.back());
         }
     }
     
     // Initialize and make visible the title component, fader, and settings panel
-    addAndMakeVisible(titleComponent);
-    addAndMakeVisible(verticalFader);
-    addAndMakeVisible(settingsPanel);
+    content.addAndMakeVisible(titleComponent);
+    content.addAndMakeVisible(verticalFader);
+    content.addAndMakeVisible(levelMeter);
+    content.addAndMakeVisible(settingsPanel);
     settingsPanel.addListener(this); // Add this component as a listener
+    settingsPanel.setInputTrace(&inputTrace);
+
+    // Added after the keys so it draws over them; it ignores the mouse
+    content.addChildComponent(spectrum);
 
     // Plus/Minus Buttons
     plusButton.setButtonText("+");
@@ -69,6 +78,7 @@ MainComponent::MainComponent()
     buttonStyle(minusButton);
 
     plusButton.onClick = [this] {
+        inputTrace.record({ 0.0, InputEvent::Type::plus });
         if (isInvSelected) {
             int newValue = currentInvValue + 1;
             if (newValue > 3) newValue = 3; // Limit to +3
@@ -78,6 +88,7 @@ MainComponent::MainComponent()
         std::cout << "Plus button clicked" << std::endl;
     };
     minusButton.onClick = [this] {
+        inputTrace.record({ 0.0, InputEvent::Type::minus });
         if (isInvSelected) {
             int newValue = currentInvValue - 1;
             if (newValue < -2) newValue = -2; // Limit to -2
@@ -87,38 +98,45 @@ MainComponent::MainComponent()
         std::cout << "Minus button clicked" << std::endl;
     };
 
-    addAndMakeVisible(plusButton);
-    addAndMakeVisible(minusButton);
-
-    // Add basic interactions (lambdas for simplicity)
-    for (auto& key : whiteKeys)
-    {
-        key->onClick = [name = key->getButtonText()] {
-            std::cout << "White key " << name << " clicked." << std::endl;
-        };
-    }
+    content.addAndMakeVisible(plusButton);
+    content.addAndMakeVisible(minusButton);
 
-    for (auto& key : blackKeys)
+    // Key presses sound on the way down and stop on the way up; the slot comes from where
+    // on the key the touch landed, and each finger holds its own chord
+    for (auto* keys : { &whiteKeys, &blackKeys })
     {
-        key->onClick = [name = key->getButtonText()] {
-            std::cout << "Black key " << name << " clicked." << std::endl;
-        };
+        for (auto& key : *keys)
+        {
+            key->onPress = [this, keyPtr = key.get()](int slotIndex, int touchIndex) {
+                handleKeyDown(*keyPtr, slotIndex, touchIndex);
+            };
+            key->onRelease = [this](int touchIndex) { handleKeyUp(touchIndex); };
+        }
     }
 
+    verticalFader.setValue(appState.getProperty(IDs::FADER_VALUE, 0.25), juce::dontSendNotification);
     verticalFader.onValueChange = [this] {
+        InputEvent event { 0.0, InputEvent::Type::fader };
+        event.value = (float) verticalFader.getValue();
+        inputTrace.record(event);
+
+        setStateProperty(IDs::FADER_VALUE, verticalFader.getValue());
         std::cout << "Fader value: " << verticalFader.getValue() << std::endl;
     };
 
+    // XL / XXL / XXXL = 1, 2 or 3 chord slots per key
+    valueTreePropertyChanged(appState, IDs::KEY_SIZE);
+    valueTreePropertyChanged(appState, IDs::DISABLED_SLOT_MASK);
+    updateKeyLabels();
     titleComponent.getXlButton().onClick = [this] {
-        juce::String currentText = titleComponent.getXlButton().getButtonText();
-        if (currentText == "XL") titleComponent.getXlButton().setButtonText("XXL");
-        else if (currentText == "XXL") titleComponent.getXlButton().setButtonText("XXXL");
-        else titleComponent.getXlButton().setButtonText("XL");
+        inputTrace.record({ 0.0, InputEvent::Type::keySize });
+        int newSize = ((int) appState.getProperty(IDs::KEY_SIZE, 1) % 3) + 1;
+        setStateProperty(IDs::KEY_SIZE, newSize); // Button text follows via valueTreePropertyChanged
         std::cout << "XL Button clicked. New mode: " << titleComponent.getXlButton().getButtonText() << std::endl;
     };
 
     // Force an initial layout
-    resized();
+    layOutContent();
 }
 
 void MainComponent::inversionSelectionChanged(bool isSelected, int value)
@@ -134,8 +152,557 @@ void MainComponent::inversionSelectionChanged(bool isSelected, int value)
               << ", Value: " << currentInvValue << std::endl;
 }
 
+void MainComponent::memoryButtonClicked(juce::Component& button)
+{
+    constexpr int recallItemBase = 1;
+    constexpr int storeItemBase = 1001;
+    constexpr int storeProgressionItemBase = 2001;
+    constexpr int recordItem = 3001;
+    constexpr int playItem = 3002;
+    constexpr int stopItem = 3003;
+    constexpr int exportItem = 3004;
+
+    auto& recorder = processor.getRecorder();
+    const bool hasProgression = recorder.getNumRecordedChords() > 0;
+
+    juce::PopupMenu recallMenu, storeMenu, storeProgressionMenu;
+    for (int i = 0; i < memoryBank.getNumBanks(); ++i)
+    {
+        const bool occupied = memoryBank.isOccupied(i);
+        const juce::String bankName = "Bank " + juce::String(i + 1);
+        recallMenu.addItem(recallItemBase + i, bankName, occupied);
+        storeMenu.addItem(storeItemBase + i, occupied ? bankName + " (replace)" : bankName);
+        storeProgressionMenu.addItem(storeProgressionItemBase + i, occupied ? bankName + " (replace)" : bankName);
+    }
+
+    juce::PopupMenu menu;
+    menu.addSubMenu("Recall", recallMenu);
+    menu.addSubMenu("Store", storeMenu);
+    menu.addSeparator();
+    menu.addItem(recordItem, recorder.isRecording() ? "Stop recording" : "Record progression");
+    menu.addItem(playItem, "Play progression", hasProgression);
+    menu.addItem(stopItem, "Stop progression");
+    menu.addItem(exportItem, "Export progression to MIDI...", hasProgression);
+    menu.addSubMenu("Store progression", storeProgressionMenu, hasProgression);
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&button),
+                       [safeThis = juce::Component::SafePointer<MainComponent>(this)](int result) {
+                           if (safeThis == nullptr || result == 0)
+                               return;
+
+                           if (result == recordItem)                      safeThis->toggleRecording();
+                           else if (result == playItem)                   safeThis->playProgression();
+                           else if (result == stopItem)                   safeThis->stopProgression();
+                           else if (result == exportItem)                 safeThis->exportProgression();
+                           else if (result >= storeProgressionItemBase)   safeThis->storeProgression(result - storeProgressionItemBase);
+                           else if (result >= storeItemBase)              safeThis->storeMemoryBank(result - storeItemBase);
+                           else                                           safeThis->recallMemoryBank(result - recallItemBase);
+                       });
+}
+
+bool MainComponent::storeMemoryBank(int bankIndex)
+{
+    // A progression stored with the bank's old setup doesn't belong to the new one
+    memoryBank.getProgressionFile(bankIndex).deleteFile();
+
+    const bool stored = memoryBank.store(bankIndex, MemoryBank::capture(appState));
+    std::cout << "Memory bank " << bankIndex + 1 << (stored ? " stored" : " store failed") << std::endl;
+    return stored;
+}
+
+bool MainComponent::recallMemoryBank(int bankIndex)
+{
+    PerformanceSetup setup;
+    if (!memoryBank.recall(bankIndex, setup))
+        return false;
+
+    undoManager.beginDistinctTransaction("Recall bank " + juce::String(bankIndex + 1));
+    MemoryBank::apply(setup, appState, &undoManager);
+
+    // A progression stored with the bank comes back with it
+    const bool hasProgression = processor.getRecorder().loadFromMemoryBank(memoryBank, bankIndex);
+    std::cout << "Memory bank " << bankIndex + 1 << " recalled" << (hasProgression ? " with its progression" : "") << std::endl;
+    return true;
+}
+
+void MainComponent::toggleRecording()
+{
+    auto& recorder = processor.getRecorder();
+    if (recorder.isRecording())
+        recorder.stopRecording();
+    else
+        recorder.startRecording(MemoryBank::capture(appState));
+}
+
+void MainComponent::playProgression()
+{
+    auto& recorder = processor.getRecorder();
+    if (recorder.isRecording())
+        recorder.stopRecording();
+
+    auto progression = recorder.getProgression();
+    PerformanceRecorder::applySmoothVoicing(*progression, engineStateBridge.getCompiledState());
+    processor.getChordEngine().setPlayback(progression);
+}
+
+void MainComponent::stopProgression()
+{
+    processor.getChordEngine().setPlayback(nullptr);
+}
+
+void MainComponent::exportProgression()
+{
+    fileChooser = std::make_unique<juce::FileChooser>("Export progression",
+                                                      juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                                                          .getChildFile("PianoXL Progression.mid"),
+                                                      "*.mid");
+
+    fileChooser->launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles
+                                 | juce::FileBrowserComponent::warnAboutOverwriting,
+                             [safeThis = juce::Component::SafePointer<MainComponent>(this)](const juce::FileChooser& chooser) {
+                                 const auto file = chooser.getResult();
+                                 if (safeThis == nullptr || file == juce::File())
+                                     return;
+
+                                 const double bpm = safeThis->appState.getProperty(IDs::BPM, 120.0);
+                                 const auto& engineState = safeThis->engineStateBridge.getCompiledState();
+                                 const bool exported = safeThis->processor.getRecorder().exportToMidiFile(file.withFileExtension("mid"), bpm, engineState);
+                                 std::cout << "Progression " << (exported ? "exported to " : "export failed: ") << file.getFullPathName() << std::endl;
+                             });
+}
+
+bool MainComponent::storeProgression(int bankIndex)
+{
+    // The bank gets the setup the progression was played with, so recalling it plays back the same chords
+    const bool stored = processor.getRecorder().saveToMemoryBank(memoryBank, bankIndex);
+    std::cout << "Progression " << (stored ? "stored in" : "store failed for") << " memory bank " << bankIndex + 1 << std::endl;
+    return stored;
+}
+
+void MainComponent::loadTuning()
+{
+    fileChooser = std::make_unique<juce::FileChooser>("Load Scala tuning (.scl, optionally with a .kbm)",
+                                                      juce::File::getSpecialLocation(juce::File::userDocumentsDirectory),
+                                                      "*.scl;*.kbm");
+
+    fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles
+                                 | juce::FileBrowserComponent::canSelectMultipleItems,
+                             [safeThis = juce::Component::SafePointer<MainComponent>(this)](const juce::FileChooser& chooser) {
+                                 if (safeThis == nullptr || chooser.getResults().isEmpty())
+                                     return;
+
+                                 // A .kbm on its own remaps the scale already loaded
+                                 auto& state = safeThis->appState;
+                                 juce::String scale = state.getProperty(IDs::TUNING_SCALE).toString();
+                                 juce::String keyboardMap;
+
+                                 for (const auto& file : chooser.getResults())
+                                 {
+                                     if (file.hasFileExtension("kbm"))
+                                         keyboardMap = file.loadFileAsString();
+                                     else
+                                         scale = file.loadFileAsString();
+                                 }
+
+                                 safeThis->undoManager.beginDistinctTransaction("Tuning");
+                                 state.setProperty(IDs::TUNING_SCALE, scale, &safeThis->undoManager);
+                                 state.setProperty(IDs::TUNING_KEYBOARD_MAP, keyboardMap, &safeThis->undoManager);
+                             });
+}
+
+void MainComponent::resetTuning()
+{
+    undoManager.beginDistinctTransaction("Tuning");
+    appState.setProperty(IDs::TUNING_SCALE, juce::String(), &undoManager);
+    appState.setProperty(IDs::TUNING_KEYBOARD_MAP, juce::String(), &undoManager);
+}
+
+void MainComponent::toggleInputTrace()
+{
+    if (!inputTrace.isRecording())
+    {
+        juce::MemoryBlock state;
+        processor.getStateInformation(state);
+        inputTrace.startRecording(state);
+        std::cout << "Input trace recording" << std::endl;
+        return;
+    }
+
+    inputTrace.stopRecording();
+
+    const auto file = InputTrace::getDefaultFolder()
+                          .getNonexistentChildFile("Trace " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S"), ".pxtrace");
+    const bool saved = inputTrace.saveToFile(file);
+    std::cout << "Input trace of " << inputTrace.getEvents().size() << " event(s) "
+              << (saved ? "saved to " : "save failed: ") << file.getFullPathName() << std::endl;
+}
+
+void MainComponent::replayInput(const InputEvent& event)
+{
+    switch (event.type)
+    {
+        case InputEvent::Type::keyDown:
+            for (auto* keys : { &whiteKeys, &blackKeys })
+                for (auto& key : *keys)
+                    if (key->getPitchClass() == event.keyIndex)
+                        handleKeyDown(*key, event.slotIndex, event.touchIndex);
+            break;
+
+        case InputEvent::Type::keyUp:
+            handleKeyUp(event.touchIndex);
+            break;
+
+        case InputEvent::Type::fader:
+            verticalFader.setValue(event.value, juce::sendNotificationSync);
+            break;
+
+        case InputEvent::Type::plus:
+            if (plusButton.isEnabled())
+                plusButton.onClick();
+            break;
+
+        case InputEvent::Type::minus:
+            if (minusButton.isEnabled())
+                minusButton.onClick();
+            break;
+
+        case InputEvent::Type::keySize:
+            titleComponent.getXlButton().onClick();
+            break;
+
+        case InputEvent::Type::selectControl:
+        case InputEvent::Type::selectMode:
+            settingsPanel.replayInput(event);
+            break;
+
+        case InputEvent::Type::shortcut:
+            keyPressed(juce::KeyPress(event.code, juce::ModifierKeys(event.modifiers), (juce::juce_wchar) event.character));
+            break;
+    }
+}
+
+void MainComponent::setStateProperty(const juce::Identifier& property, const juce::var& newValue)
+{
+    undoManager.beginGesture(property);
+    appState.setProperty(property, newValue, &undoManager);
+}
+
+void MainComponent::valueTreePropertyChanged(juce::ValueTree& treeWhosePropertyHasChanged, const juce::Identifier& property)
+{
+    if (treeWhosePropertyHasChanged.hasType(IDs::SLOT))
+    {
+        if (property == IDs::CHORD_TYPE_INDEX || property == IDs::BASS_OFFSET)
+            triggerAsyncUpdate();
+        return;
+    }
+
+    if (treeWhosePropertyHasChanged != appState)
+        return;
+
+    if (property == IDs::FADER_VALUE)
+    {
+        verticalFader.setValue(appState.getProperty(IDs::FADER_VALUE, 0.25), juce::dontSendNotification);
+    }
+    else if (property == IDs::KEY_SIZE)
+    {
+        const int slotsPerKey = juce::jlimit(1, 3, (int) appState.getProperty(IDs::KEY_SIZE, 1));
+        titleComponent.getXlButton().setButtonText(juce::String::repeatedString("X", slotsPerKey) + "L");
+        updateKeySlots();
+    }
+    else if (property == IDs::SELECTED_KEY || property == IDs::SELECTED_MODE || property == IDs::USE_FLATS)
+    {
+        triggerAsyncUpdate();
+    }
+    else if (property == IDs::DISABLED_SLOT_MASK)
+    {
+        disabledSlotMask = SlotMask::fromVar(appState.getProperty(IDs::DISABLED_SLOT_MASK, (juce::int64) 0));
+        updateKeySlots();
+    }
+}
+
+void MainComponent::updateKeySlots()
+{
+    const int slotsPerKey = juce::jlimit(1, AppStateModel::maxSlotsPerKey, (int) appState.getProperty(IDs::KEY_SIZE, 1));
+
+    for (auto* keys : { &whiteKeys, &blackKeys })
+        for (auto& key : *keys)
+            key->setSlots(slotsPerKey, SlotMask::getKeyBits(disabledSlotMask, key->getPitchClass()));
+}
+
+void MainComponent::updateKeyLabels()
+{
+    const int selectedKey = appState.getProperty(IDs::SELECTED_KEY, 0);
+    const int mode = appState.getProperty(IDs::SELECTED_MODE, 0);
+    const bool useFlats = appState.getProperty(IDs::USE_FLATS, false);
+
+    for (auto* keys : { &whiteKeys, &blackKeys })
+    {
+        for (auto& key : *keys)
+        {
+            const int pitchClass = key->getPitchClass();
+            key->setIsInScale(mode != 0 && MusicTheory::isInScale(pitchClass, selectedKey, mode));
+
+            for (int slot = 0; slot < AppStateModel::maxSlotsPerKey; ++slot)
+            {
+                auto slotTree = AppStateModel::getSlot(appState, pitchClass, slot);
+                const int chordType = MusicTheory::resolveChordType(pitchClass, selectedKey, mode, slotTree.getProperty(IDs::CHORD_TYPE_INDEX, 0));
+
+                // Lower slots never show a slash bass, as in the reference
+                const int bassOffset = slot == 0 ? (int) slotTree.getProperty(IDs::BASS_OFFSET, 0) : 0;
+                key->setSlotLabel(slot, chordType < 0 ? MusicTheory::ChordName()
+                                                      : MusicTheory::formatChordName(pitchClass, chordType, bassOffset, useFlats, mode));
+            }
+        }
+    }
+}
+
+void MainComponent::disableEditChanged(bool isActive)
+{
+    disableEditActive = isActive;
+    std::cout << "Disable edit " << (isActive ? "on" : "off") << std::endl;
+}
+
+void MainComponent::handleKeyDown(PianoKeyComponent& key, int slotIndex, int touchIndex)
+{
+    // Taken first, so the engine can place the chord relative to the input event itself
+    const double timestamp = juce::Time::getMillisecondCounterHiRes();
+    const int keyIndex = key.getPitchClass();
+
+    InputEvent event { 0.0, InputEvent::Type::keyDown, (juce::int8) keyIndex, (juce::int8) slotIndex, (juce::int8) touchIndex };
+    inputTrace.record(event);
+
+    if (disableEditActive)
+    {
+        toggleDisabled(keyIndex, slotIndex);
+        return;
+    }
+
+    // Rejected presses stop here, before any chord is looked up
+    if (SlotMask::isDisabled(disabledSlotMask, keyIndex, slotIndex))
+        return;
+
+    // Everything was worked out when the state changed; the audio thread only copies the prebuilt notes.
+    // Usually nothing is pending and this returns at once. It only compiles when a press lands
+    // in the same message loop turn as an edit (a replayed trace, a shortcut then a tap), which
+    // would otherwise sound and show the chord from before the edit.
+    engineStateBridge.flushPendingChanges();
+    const auto& engineState = engineStateBridge.getCompiledState();
+    const int flatIndex = AppStateModel::getFlatSlotIndex(keyIndex, slotIndex);
+    const Voicing& voicing = engineState.voicings[flatIndex];
+    if (!voicing.isPlayable())
+        return; // Out of scale in the current mode
+
+    // Fingers past the last one tracked play one-shot chords that ring for the sustain time
+    if (!juce::isPositiveAndBelow(touchIndex, ChordCommand::maxTouches))
+        touchIndex = -1;
+
+    if (processor.getChordEngine().postCommand({ ChordCommand::Type::playSlot, (juce::int8) keyIndex, (juce::int8) slotIndex,
+                                                 (juce::int8) touchIndex, timestamp })
+        && touchIndex >= 0)
+    {
+        pressedTouches |= (juce::uint32) 1 << touchIndex;
+    }
+
+    const int mode = appState.getProperty(IDs::SELECTED_MODE, 0);
+    const bool useFlats = appState.getProperty(IDs::USE_FLATS, false);
+    const int bassOffset = slotIndex == 0 ? engineState.bassOffset[flatIndex] : 0;
+    settingsPanel.setChordDisplayName(MusicTheory::formatChordName(voicing.root, voicing.chordType, bassOffset, useFlats, mode));
+}
+
+void MainComponent::handleKeyUp(int touchIndex)
+{
+    const double timestamp = juce::Time::getMillisecondCounterHiRes();
+
+    InputEvent event { 0.0, InputEvent::Type::keyUp };
+    event.touchIndex = (juce::int8) touchIndex;
+    inputTrace.record(event);
+
+    if (!juce::isPositiveAndBelow(touchIndex, ChordCommand::maxTouches) || (pressedTouches & ((juce::uint32) 1 << touchIndex)) == 0)
+        return;
+
+    ChordCommand command;
+    command.type = ChordCommand::Type::releaseTouch;
+    command.touchIndex = (juce::int8) touchIndex;
+    command.timestamp = timestamp;
+
+    if (processor.getChordEngine().postCommand(command))
+        pressedTouches &= ~((juce::uint32) 1 << touchIndex);
+}
+
+void MainComponent::setMeasuringLatency(bool shouldMeasure)
+{
+    processor.getChordEngine().setMeasuringLatency(shouldMeasure);
+    latencyStats = {};
+
+    if (shouldMeasure)
+        startTimer(latencyTimerId, 1000);
+    else
+        stopTimer(latencyTimerId);
+
+    std::cout << "Latency measurement " << (shouldMeasure ? "on" : "off")
+              << " (input event to first sample in the output buffer; device latency not included)" << std::endl;
+}
+
+void MainComponent::timerCallback(int timerId)
+{
+    if (timerId == latencyTimerId)
+    {
+        reportLatency();
+    }
+    else if (timerId == resizeSettleTimerId)
+    {
+        stopTimer(resizeSettleTimerId);
+        layOutContent();
+    }
+}
+
+void MainComponent::reportLatency()
+{
+    const int previousCount = latencyStats.count;
+
+    processor.getChordEngine().popLatencyMeasurements([this](double latencyMs) {
+        auto& stats = latencyStats;
+        stats.minimum = stats.count == 0 ? latencyMs : juce::jmin(stats.minimum, latencyMs);
+        stats.maximum = stats.count == 0 ? latencyMs : juce::jmax(stats.maximum, latencyMs);
+        stats.total += latencyMs;
+        ++stats.count;
+    });
+
+    if (latencyStats.count > previousCount)
+        std::cout << "Press-to-sound latency over " << latencyStats.count << " press(es): min " << latencyStats.minimum
+                  << " ms, avg " << latencyStats.total / latencyStats.count << " ms, max " << latencyStats.maximum << " ms" << std::endl;
+}
+
+void MainComponent::toggleDisabled(int keyIndex, int slotIndex)
+{
+    // In XL there's one slot per key, so the whole key is toggled (as PianoXL.tsx's onDisableKey)
+    const bool wholeKey = (int) appState.getProperty(IDs::KEY_SIZE, 1) <= 1;
+    const auto bits = wholeKey ? SlotMask::bitsForKey(keyIndex) : SlotMask::bitFor(keyIndex, slotIndex);
+    const auto newMask = (disabledSlotMask & bits) == bits ? (disabledSlotMask & ~bits) : (disabledSlotMask | bits);
+
+    setStateProperty(IDs::DISABLED_SLOT_MASK, SlotMask::toVar(newMask));
+}
+
+bool MainComponent::keyPressed(const juce::KeyPress& key)
+{
+    const auto command = juce::ModifierKeys::commandModifier;
+    const auto shift = juce::ModifierKeys::shiftModifier;
+
+    // I starts and stops an input trace. T's file dialog and L's measurement aren't part
+    // of one: a replay can't answer the dialog, and measures latency itself.
+    if (key == juce::KeyPress('i'))
+    {
+        toggleInputTrace();
+        return true;
+    }
+
+    if (!(key == juce::KeyPress('t') || key == juce::KeyPress('l')))
+    {
+        InputEvent event { 0.0, InputEvent::Type::shortcut };
+        event.code = key.getKeyCode();
+        event.modifiers = key.getModifiers().getRawFlags();
+        event.character = (juce::uint32) key.getTextCharacter();
+        inputTrace.record(event);
+    }
+
+    if (key == juce::KeyPress('z', command, 0))
+        return undoManager.undoGesture();
+
+    if (key == juce::KeyPress('z', command | shift, 0) || key == juce::KeyPress('y', command, 0))
+        return undoManager.redoGesture();
+
+    // V toggles smooth voicing; the next chord is then led from the last one played
+    if (key == juce::KeyPress('v'))
+    {
+        undoManager.beginDistinctTransaction("Smooth voicing");
+        appState.setProperty(IDs::SMOOTH_VOICING, !(bool) appState.getProperty(IDs::SMOOTH_VOICING, false), &undoManager);
+        return true;
+    }
+
+    // A cycles the arp pattern: OFF, UP, DOWN, ALT, RANDOM, CUSTOM
+    if (key == juce::KeyPress('a'))
+    {
+        const int nextMode = ((int) appState.getProperty(IDs::ARP_MODE, 0) + 1) % Arpeggiator::numPatterns;
+        undoManager.beginDistinctTransaction("Arp mode");
+        appState.setProperty(IDs::ARP_MODE, nextMode, &undoManager);
+        return true;
+    }
+
+    // R starts and stops recording the chords played; P plays the last progression back
+    if (key == juce::KeyPress('r'))
+    {
+        toggleRecording();
+        return true;
+    }
+
+    if (key == juce::KeyPress('p'))
+    {
+        playProgression();
+        return true;
+    }
+
+    // M switches between the built-in sound and MIDI output to the next plugin in the chain
+    if (key == juce::KeyPress('m'))
+    {
+        undoManager.beginDistinctTransaction("MIDI output");
+        appState.setProperty(IDs::MIDI_OUTPUT, !(bool) appState.getProperty(IDs::MIDI_OUTPUT, false), &undoManager);
+        return true;
+    }
+
+    // C turns the master soft clipper on and off; the limiter stays on either way
+    if (key == juce::KeyPress('c'))
+    {
+        undoManager.beginDistinctTransaction("Soft clip");
+        appState.setProperty(IDs::SOFT_CLIP, !(bool) appState.getProperty(IDs::SOFT_CLIP, false), &undoManager);
+        return true;
+    }
+
+    // S shows and hides the output spectrum over the keys
+    if (key == juce::KeyPress('s'))
+    {
+        spectrum.setVisible(!spectrum.isVisible());
+        return true;
+    }
+
+    // T loads a Scala tuning, shift+T goes back to 12-TET; [ and ] move A4 down and up a hertz
+    if (key == juce::KeyPress('t'))
+    {
+        loadTuning();
+        return true;
+    }
+
+    if (key == juce::KeyPress('t', shift, 0))
+    {
+        resetTuning();
+        return true;
+    }
+
+    if (key == juce::KeyPress('[') || key == juce::KeyPress(']'))
+    {
+        const double a4 = appState.getProperty(IDs::TUNING_A4, TuningTable::defaultA4);
+        const double step = key == juce::KeyPress(']') ? 1.0 : -1.0;
+        undoManager.beginGesture(IDs::TUNING_A4); // Repeated presses undo as one
+        appState.setProperty(IDs::TUNING_A4, juce::jlimit(TuningTable::minA4, TuningTable::maxA4, a4 + step), &undoManager);
+        return true;
+    }
+
+    // L toggles press-to-sound latency measurement, reported on the console
+    if (key == juce::KeyPress('l'))
+    {
+        setMeasuringLatency(!processor.getChordEngine().isMeasuringLatency());
+        return true;
+    }
+
+    return false;
+}
+
 MainComponent::~MainComponent()
 {
+    stopTimer(latencyTimerId);
+    stopTimer(resizeSettleTimerId);
+    cancelPendingUpdate();
+    processor.getChordEngine().setMeasuringLatency(false);
+    appState.removeListener(this);
     settingsPanel.removeListener(this);
     plusButton.setLookAndFeel(nullptr);
     minusButton.setLookAndFeel(nullptr);
@@ -145,15 +712,50 @@ void MainComponent::paint(juce::Graphics& g)
 {
     // Fill background with solid black
     g.fillAll(juce::Colours::black);
+
+    // The plugin is on screen: now the deferred startup work can go, outside the paint
+    if (!hasPaintedFirstFrame)
+    {
+        hasPaintedFirstFrame = true;
+        StartupProfiler::mark("First frame");
+
+        juce::MessageManager::callAsync([safeThis = juce::Component::SafePointer<MainComponent>(this)] {
+            if (safeThis != nullptr)
+                safeThis->processor.getDeferredInitialiser().start();
+        });
+    }
 }
 
 void MainComponent::resized()
 {
-    // This is called when the MainComponent is resized.
-    // We need to calculate the bounds for our content area, respecting aspect ratio and constraints.
+    // A size arriving soon after the last one is part of a window drag: move the last
+    // layout into place rather than laying every child out again
+    const auto now = juce::Time::getMillisecondCounter();
+    const bool isLiveResize = !laidOutArea.isEmpty() && now - lastResizeTime < (juce::uint32) liveResizeSettleMs;
+    lastResizeTime = now;
+
+    if (!isLiveResize)
+    {
+        stopTimer(resizeSettleTimerId);
+        layOutContent();
+        return;
+    }
+
+    // minWidth == maxWidth, so the content area never changes size, only where it's
+    // centred: the fast path is just a translation
+    const auto from = getContentArea(laidOutArea);
+    const auto to = getContentArea(getLocalBounds());
+    content.setTransform(juce::AffineTransform::translation(to.getX() - from.getX(), to.getY() - from.getY()));
 
-    float currentWidthPx = static_cast<float>(getWidth());
-    float currentHeightPx = static_cast<float>(getHeight());
+    startTimer(resizeSettleTimerId, liveResizeSettleMs);
+}
+
+juce::Rectangle<float> MainComponent::getContentArea(juce::Rectangle<int> area) const
+{
+    // The content area keeps the base aspect ratio inside the given bounds, within the
+    // min/max constraints, and is centred in them
+    float currentWidthPx = static_cast<float>(area.getWidth());
+    float currentHeightPx = static_cast<float>(area.getHeight());
 
     float newContentWidth = 0;
     float newContentHeight = 0;
@@ -195,11 +797,26 @@ void MainComponent::resized()
         newContentHeight = newContentWidth / aspectRatio;
     }
 
-    // Position settings panel at the top
+    return { (currentWidthPx - newContentWidth) / 2.0f, (currentHeightPx - newContentHeight) / 2.0f, newContentWidth, newContentHeight };
+}
+
+void MainComponent::layOutContent()
+{
+    // We need to calculate the bounds for our content area, respecting aspect ratio and constraints.
+    laidOutArea = getLocalBounds();
+    content.setTransform({});
+    content.setBounds(laidOutArea);
+
+    const auto contentArea = getContentArea(laidOutArea);
+    float newContentWidth = contentArea.getWidth();
+    float newContentHeight = contentArea.getHeight();
+
+    // Position settings panel at the top of the content area, so it moves with everything
+    // else during a live resize
     float settingsPanelY = 20.0f;
     settingsPanel.setBounds(
-        static_cast<int>((currentWidthPx - settingsPanel.getWidth()) / 2.0f),
-        static_cast<int>(settingsPanelY),
+        static_cast<int>(contentArea.getCentreX() - settingsPanel.getWidth() / 2.0f),
+        static_cast<int>(contentArea.getY() + settingsPanelY),
         settingsPanel.getWidth(),
         settingsPanel.getHeight()
     );
@@ -208,8 +825,8 @@ void MainComponent::resized()
     float xOffset = 170.0f;  // Previous 200 - 30
     float yOffset = 145.0f;  // Previous 125 + 20
 
-    int contentX = static_cast<int>((currentWidthPx - newContentWidth) / 2.0f + xOffset);
-    int contentY = static_cast<int>((currentHeightPx - newContentHeight) / 2.0f + yOffset);
+    int contentX = static_cast<int>(contentArea.getX() + xOffset);
+    int contentY = static_cast<int>(contentArea.getY() + yOffset);
     contentBounds.setBounds(contentX, contentY, static_cast<int>(newContentWidth), static_cast<int>(newContentHeight));
     
     float scaleFactor = contentBounds.getWidth() / baseWidth;
@@ -343,6 +960,20 @@ void MainComponent::resized()
                            static_cast<int>(faderActualTop),
                            static_cast<int>(faderScaledWidth),
                            static_cast<int>(faderScaledHeight));
+
+    // Output meter just right of the fader, the same height
+    float meterGap = 6.0f * scaleFactor;
+    float meterWidth = 6.0f * scaleFactor;
+
+    levelMeter.setBounds(static_cast<int>(faderActualLeft + faderScaledWidth + meterGap),
+                         static_cast<int>(faderActualTop),
+                         juce::jmax(2, static_cast<int>(meterWidth)),
+                         static_cast<int>(faderScaledHeight));
+
+    // Spectrum overlay spans the white keys
+    if (!whiteKeys.empty())
+        spectrum.setBounds(whiteKeys.front()->getBounds().getUnion(whiteKeys.back()->getBounds()));
+
     float buttonsStartY = contentBounds.getCentreY() - (buttonHeight + buttonSpacing/2.0f) - (114.0f * scaleFactor); // Moved down by another 11px
 
     plusButton.setBounds(static_cast<int>(buttonsX),
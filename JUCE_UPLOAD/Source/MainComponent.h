@@ -4,33 +4,107 @@
 #include "PianoKeyComponent.h" 
 #include "TitleComponent.h"
 #include "VerticalFaderComponent.h"
+#include "LevelMeterComponent.h"
+#include "SpectrumComponent.h"
 #include "Identifiers.h" // Include the new identifiers
 #include "SettingsPanelXLComponent.h"
+#include "PluginProcessor.h"
+#include "SlotMask.h"
+#include "InputTrace.h"
 
 //==============================================================================
 /*
-    This component lives inside our window, and this is where you should put all
-    your controls and content.
+    This component lives inside the plugin editor, and this is where you should put all
+    your controls and content. The state it edits is owned by the processor.
 */
 class MainComponent  : public juce::Component,
-                      public SettingsPanelXLComponent::Listener
+                      public SettingsPanelXLComponent::Listener,
+                      private juce::ValueTree::Listener,
+                      private juce::MultiTimer,
+                      private juce::AsyncUpdater
 {
 public:
     //==============================================================================
-    MainComponent();
+    explicit MainComponent(PianoXLAudioProcessor& processorToUse);
     ~MainComponent() override;
 
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
+    bool keyPressed(const juce::KeyPress& key) override;
     void inversionSelectionChanged(bool isSelected, int value) override;
+    void memoryButtonClicked(juce::Component& button) override;
+    void disableEditChanged(bool isActive) override;
+
+    // Memory banks: store captures the current setup, recall swaps it in as one batch
+    bool storeMemoryBank(int bankIndex);
+    bool recallMemoryBank(int bankIndex);
+
+    // Progression recording: presses are captured by the audio thread while recording
+    void toggleRecording();
+    void playProgression();
+    void stopProgression();
+    void exportProgression();
+    bool storeProgression(int bankIndex);
+
+    // Tuning: the chosen Scala files' text goes into the state, so it travels with sessions
+    void loadTuning();
+    void resetTuning();
+
+    // Input traces: I starts and stops recording what the user does, saved to
+    // InputTrace::getDefaultFolder() for PianoXLHeadlessHost --replay
+    void toggleInputTrace();
+    void replayInput(const InputEvent& event);
 
-    // Method to get the ValueTree (e.g., for AudioProcessor)
     juce::ValueTree& getAppState() { return appState; }
 
 private:
     //==============================================================================
-    // Your private member variables go here...
+    // Sets a property on appState as part of an undoable gesture
+    void setStateProperty(const juce::Identifier& property, const juce::var& newValue);
+
+    // Key presses: play the slot on the way down and release it on the way up, or toggle
+    // its disable bit while disable editing is active
+    void handleKeyDown(PianoKeyComponent& key, int slotIndex, int touchIndex);
+    void handleKeyUp(int touchIndex);
+    void toggleDisabled(int keyIndex, int slotIndex);
+
+    // Pushes key size and disable mask into every key's slot rendering
+    void updateKeySlots();
+
+    // Chord names and in-scale borders for the current key, mode and slot chord types.
+    // State changes go through the AsyncUpdater, so a memory recall's burst of slot
+    // changes relabels the keys once.
+    void updateKeyLabels();
+    void handleAsyncUpdate() override { updateKeyLabels(); }
+
+    // Press-to-sound latency measurement, reported once a second while it's on
+    void setMeasuringLatency(bool shouldMeasure);
+    void reportLatency();
+
+    // Live resize: while sizes keep arriving (a window drag), the last layout is moved
+    // to the new content area with one transform on the container; the exact layout
+    // runs once they've stopped for liveResizeSettleMs
+    void layOutContent();
+    juce::Rectangle<float> getContentArea(juce::Rectangle<int> area) const;
+
+    enum TimerIds { latencyTimerId, resizeSettleTimerId };
+    void timerCallback(int timerId) override;
+
+    // ValueTree::Listener methods - keeps fader, XL button and key labels in sync with undo/redo and recalls
+    void valueTreePropertyChanged(juce::ValueTree& treeWhosePropertyHasChanged, const juce::Identifier& property) override;
+    void valueTreeChildAdded (juce::ValueTree&, juce::ValueTree&) override {}
+    void valueTreeChildRemoved (juce::ValueTree&, juce::ValueTree&, int) override {}
+    void valueTreeChildOrderChanged (juce::ValueTree&, int, int) override {}
+    void valueTreeParentChanged (juce::ValueTree&) override {}
+
+    // State lives in the processor; these are declared first so they're set before the components that use them
+    PianoXLAudioProcessor& processor;
+    StateUndoManager& undoManager;
+    juce::ValueTree appState; // Shares the processor's tree
+    MemoryBank& memoryBank;
+    EngineStateBridge& engineStateBridge;
+
     
     // Define base dimensions and aspect ratio
     const float baseWidth = 844.0f;
@@ -45,12 +119,20 @@ private:
 
     juce::Rectangle<int> contentBounds;
 
+    // Holds every child, so a live resize moves them all with a single transform
+    juce::Component content;
+    juce::Rectangle<int> laidOutArea;           // Local bounds the children were last laid out for
+    juce::uint32 lastResizeTime = 0;
+    static constexpr int liveResizeSettleMs = 150;
+
     // Test Piano Key
     // PianoKeyComponent testKey; // Will be replaced by arrays of keys
 
     // Other UI Elements
     TitleComponent titleComponent;
     VerticalFaderComponent verticalFader;
+    LevelMeterComponent levelMeter { processor.getLevelMeter() };
+    SpectrumComponent spectrum { processor.getLevelMeter() }; // Over the keys, hidden until toggled
     SettingsPanelXLComponent settingsPanel;
 
     // Custom LookAndFeel for plus/minus buttons
@@ -84,7 +166,23 @@ private:
     juce::TextButton plusButton;
     juce::TextButton minusButton;
 
-    juce::ValueTree appState; // The application state ValueTree
+    std::unique_ptr<juce::FileChooser> fileChooser; // Kept alive while the async chooser is open
+
+    InputTrace inputTrace;
+
+    bool hasPaintedFirstFrame = false;
+    bool disableEditActive = false;
+    SlotMask::Mask disabledSlotMask = 0; // Cached from appState so a press is a single bit test
+
+    juce::uint32 pressedTouches = 0;     // Touches that posted a press still waiting for its release
+
+    struct LatencyStats
+    {
+        int count = 0;
+        double total = 0.0, minimum = 0.0, maximum = 0.0;
+    };
+
+    LatencyStats latencyStats;
 
     bool isInvSelected = false;
     int currentInvValue = 0; // To track the value from settingsPanel for plus/minus actions
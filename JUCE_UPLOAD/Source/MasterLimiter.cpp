@@ -0,0 +1,191 @@
+#include "MasterLimiter.h"
+
+void MasterLimiter::prepare(double newSampleRate, int maximumBlockSize, int numChannels)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    channels = juce::jlimit(1, maxChannels, numChannels);
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    lookahead = juce::jmax(1, juce::roundToInt(lookaheadSeconds * sampleRate));
+
+    // A whole block is written before it's read back lookahead samples later
+    const int delaySize = juce::nextPowerOfTwo(lookahead + maxBlockSize);
+    delayMask = delaySize - 1;
+    for (auto& line : delayLines)
+        line.allocate((size_t) delaySize, true);
+
+    holdLength = lookahead + 1;
+    holdSegment.allocate((size_t) holdLength, true);
+    holdSuffix.allocate((size_t) holdLength + 1, true);
+
+    const int averageSize = juce::nextPowerOfTwo(lookahead + 1);
+    averageMask = averageSize - 1;
+    averageLine.allocate((size_t) averageSize, true);
+
+    releaseCoefficient = (float) (1.0 - std::exp(-1.0 / (releaseSeconds * sampleRate)));
+
+    peaks.allocate((size_t) maxBlockSize, true);
+    gains.allocate((size_t) maxBlockSize, true);
+
+    reset();
+}
+
+void MasterLimiter::reset()
+{
+    for (auto& line : delayLines)
+        if (line != nullptr)
+            juce::FloatVectorOperations::clear(line.get(), delayMask + 1);
+
+    delayPosition = 0;
+
+    if (holdSegment != nullptr)
+    {
+        juce::FloatVectorOperations::fill(holdSegment.get(), 1.0f, holdLength);
+        juce::FloatVectorOperations::fill(holdSuffix.get(), 1.0f, holdLength + 1);
+    }
+
+    holdPosition = 0;
+    holdPrefix = 1.0f;
+    releasedGain = 1.0f;
+
+    if (averageLine != nullptr)
+        juce::FloatVectorOperations::fill(averageLine.get(), 1.0f, averageMask + 1);
+
+    averagePosition = 0;
+    averageSum = (double) lookahead;
+}
+
+void MasterLimiter::process(juce::AudioBuffer<float>& buffer, bool softClip) noexcept
+{
+    if (lookahead == 0)
+        return; // Not prepared
+
+    const float targetClipAmount = softClip ? 1.0f : 0.0f;
+
+    for (int start = 0; start < buffer.getNumSamples(); start += maxBlockSize)
+        processChunk(buffer, start, juce::jmin(maxBlockSize, buffer.getNumSamples() - start), targetClipAmount);
+}
+
+void MasterLimiter::processChunk(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, float targetClipAmount) noexcept
+{
+    const int numChannels = juce::jmin(channels, buffer.getNumChannels());
+
+    // Linked peak of all channels, so the stereo image doesn't shift under limiting
+    juce::FloatVectorOperations::abs(peaks.get(), buffer.getReadPointer(0, startSample), numSamples);
+    for (int channel = 1; channel < numChannels; ++channel)
+    {
+        juce::FloatVectorOperations::abs(gains.get(), buffer.getReadPointer(channel, startSample), numSamples);
+        juce::FloatVectorOperations::max(peaks.get(), peaks.get(), gains.get(), numSamples);
+    }
+
+    // The clipper crossfades in or out over clipFadeSeconds. Only a fully engaged clipper
+    // keeps peaks up to clipDrive under the ceiling, so the limiter lets them through only
+    // if it's fully on for every sample of this block, through to when it leaves the delay.
+    const float clipStepPerSample = (float) (1.0 / (clipFadeSeconds * sampleRate));
+    const float startClipAmount = clipAmount;
+    clipAmount += juce::jlimit(-clipStepPerSample * (float) numSamples, clipStepPerSample * (float) numSamples,
+                               targetClipAmount - clipAmount);
+
+    const float lookaheadStep = clipStepPerSample * (float) lookahead;
+    const float clipAmountAtOutput = clipAmount + juce::jlimit(-lookaheadStep, lookaheadStep, targetClipAmount - clipAmount);
+    const bool fullyClipping = juce::jmin(startClipAmount, clipAmountAtOutput) >= 1.0f;
+
+    computeGains(numSamples, fullyClipping ? clipDrive : ceiling);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* samples = buffer.getWritePointer(channel, startSample);
+        delay(channel, samples, numSamples);
+        juce::FloatVectorOperations::multiply(samples, gains.get(), numSamples);
+
+        if (startClipAmount > 0.0f || clipAmount > 0.0f)
+            applySoftClip(samples, numSamples, startClipAmount, clipAmount);
+    }
+
+    delayPosition = (delayPosition + numSamples) & delayMask;
+}
+
+void MasterLimiter::computeGains(int numSamples, float threshold) noexcept
+{
+    // Gain each sample needs to stay under the threshold (1 when it already does)
+    auto* required = peaks.get();
+    for (int i = 0; i < numSamples; ++i)
+        required[i] = threshold / juce::jmax(required[i], threshold);
+
+    for (int i = 0; i < numSamples;)
+    {
+        // Up to the end of the current hold segment, without a test per sample
+        const int run = juce::jmin(numSamples - i, holdLength - holdPosition);
+
+        for (int end = i + run; i < end; ++i)
+        {
+            holdSegment[holdPosition] = required[i];
+            holdPrefix = juce::jmin(holdPrefix, required[i]);
+            const float held = juce::jmin(holdPrefix, holdSuffix[holdPosition + 1]);
+            ++holdPosition;
+
+            // Drops at once, recovers over releaseSeconds
+            releasedGain = juce::jmin(held, releasedGain + (held - releasedGain) * releaseCoefficient);
+
+            averageSum += releasedGain - averageLine[(averagePosition - lookahead) & averageMask];
+            averageLine[averagePosition] = releasedGain;
+            averagePosition = (averagePosition + 1) & averageMask;
+
+            gains[i] = (float) (averageSum / lookahead);
+        }
+
+        if (holdPosition == holdLength)
+        {
+            holdSuffix[holdLength] = 1.0f;
+            for (int j = holdLength; --j >= 0;)
+                holdSuffix[j] = juce::jmin(holdSegment[j], holdSuffix[j + 1]);
+
+            holdPosition = 0;
+            holdPrefix = 1.0f;
+
+            // Re-add the average from scratch now and then, so rounding can't build up
+            // and an idle limiter stays at exactly unity
+            averageSum = 0.0;
+            for (int j = 1; j <= lookahead; ++j)
+                averageSum += averageLine[(averagePosition - j) & averageMask];
+        }
+    }
+}
+
+void MasterLimiter::delay(int channel, float* samples, int numSamples) noexcept
+{
+    auto* line = delayLines[channel].get();
+    const int size = delayMask + 1;
+
+    // Write the block in, then read back the stretch lookahead samples behind it
+    auto copyIn = [&](int position, const float* source, int count) {
+        const int first = juce::jmin(count, size - position);
+        juce::FloatVectorOperations::copy(line + position, source, first);
+        juce::FloatVectorOperations::copy(line, source + first, count - first);
+    };
+
+    auto copyOut = [&](int position, float* dest, int count) {
+        const int first = juce::jmin(count, size - position);
+        juce::FloatVectorOperations::copy(dest, line + position, first);
+        juce::FloatVectorOperations::copy(dest + first, line, count - first);
+    };
+
+    copyIn(delayPosition, samples, numSamples);
+    copyOut((delayPosition - lookahead) & delayMask, samples, numSamples);
+}
+
+void MasterLimiter::applySoftClip(float* samples, int numSamples, float startAmount, float endAmount) noexcept
+{
+    // Quadratic knee from clipKnee (slope 1) to clipDrive (slope 0, at the ceiling):
+    // y = a - (a - knee)^2 / (4 (ceiling - knee)), applied as a gain on each sample
+    constexpr float curve = 1.0f / (4.0f * (ceiling - clipKnee));
+    const float amountStep = (endAmount - startAmount) / (float) numSamples;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float level = juce::jmax(std::abs(samples[i]), clipKnee);
+        const float bent = juce::jmin(level, clipDrive) - clipKnee;
+        const float shaped = clipKnee + bent - bent * bent * curve;
+        const float amount = startAmount + amountStep * (float) (i + 1);
+        samples[i] *= 1.0f + (shaped / level - 1.0f) * amount;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Lookahead peak limiter and optional soft clipper on the master bus, so stacks of
+// flammed, long-sustained chords stay clean at any polyphony without riding the fader.
+//
+// The limiter delays the audio by a fixed lookahead (reported to the host as latency)
+// and works out, for every sample, the gain that keeps the peak of both channels under
+// the threshold. That gain is held for the lookahead, released exponentially and then
+// averaged over the lookahead, so it has already ramped down by the time the peak comes
+// out of the delay, and never overshoots it.
+//
+// With the soft clipper on, the limiter lets peaks up to clipDrive through and the
+// clipper bends everything above clipKnee smoothly into the ceiling instead. Switching
+// it is crossfaded.
+//
+// Per-sample work runs over whole blocks with vector operations; the only serial part
+// is the gain's hold/release/average, which uses min/max rather than branches.
+// Nothing allocates after prepare().
+class MasterLimiter
+{
+public:
+    static constexpr double lookaheadSeconds = 0.002;
+    static constexpr double releaseSeconds = 0.1;
+    static constexpr double clipFadeSeconds = 0.01;
+    static constexpr float ceiling = 0.966f;                // -0.3 dBFS
+    static constexpr float clipKnee = 0.5f;                 // The clipper is linear below this
+    static constexpr float clipDrive = 2.0f * ceiling - clipKnee; // ...and reaches the ceiling here
+
+    MasterLimiter() = default;
+
+    void prepare(double newSampleRate, int maximumBlockSize, int numChannels);
+    void reset();
+
+    // Fixed for a given sample rate
+    int getLatencySamples() const noexcept { return lookahead; }
+
+    // Audio thread
+    void process(juce::AudioBuffer<float>& buffer, bool softClip) noexcept;
+
+private:
+    static constexpr int maxChannels = 2;
+
+    void processChunk(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, float targetClipAmount) noexcept;
+    void computeGains(int numSamples, float threshold) noexcept;
+    void delay(int channel, float* samples, int numSamples) noexcept;
+    void applySoftClip(float* samples, int numSamples, float startAmount, float endAmount) noexcept;
+
+    double sampleRate = 44100.0;
+    int channels = 2;
+    int maxBlockSize = 0;
+    int lookahead = 0;
+
+    // Lookahead delay, a power of two long so positions wrap with a mask
+    juce::HeapBlock<float> delayLines[maxChannels];
+    int delayMask = 0;
+    int delayPosition = 0;
+
+    // Running minimum over the last lookahead + 1 samples of required gain, kept as the
+    // minimum of the current segment so far and the suffix minima of the previous one
+    juce::HeapBlock<float> holdSegment, holdSuffix;
+    int holdLength = 0;
+    int holdPosition = 0;
+    float holdPrefix = 1.0f;
+
+    float releaseCoefficient = 0.0f;
+    float releasedGain = 1.0f;
+
+    // Moving average of the released gain over the lookahead
+    juce::HeapBlock<float> averageLine;
+    int averageMask = 0;
+    int averagePosition = 0;
+    double averageSum = 0.0;
+
+    float clipAmount = 0.0f;
+    juce::HeapBlock<float> peaks, gains;   // Per-sample scratch, sized in prepare()
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MasterLimiter)
+};
@@ -0,0 +1,197 @@
+#include "MemoryBank.h"
+#include <iostream>
+
+MemoryBank::MemoryBank(const juce::File& bankFile, int numberOfBanks)
+    : file(bankFile),
+      numBanks(juce::jmax(1, numberOfBanks))
+{
+}
+
+MemoryBank::~MemoryBank() = default;
+
+juce::File MemoryBank::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("PianoXL")
+               .getChildFile("MemoryBanks.pxlb");
+}
+
+juce::File MemoryBank::getProgressionFile(int bankIndex) const
+{
+    if (file == juce::File() || !juce::isPositiveAndBelow(bankIndex, numBanks))
+        return {};
+
+    return file.getSiblingFile("Progressions").getChildFile("Bank " + juce::String(bankIndex + 1) + ".pxlp");
+}
+
+bool MemoryBank::createEmptyFile() const
+{
+    if (!file.getParentDirectory().createDirectory())
+        return false;
+
+    juce::TemporaryFile temp(file);
+
+    if (auto out = temp.getFile().createOutputStream())
+    {
+        FileHeader header { fileMagic, fileVersion, (juce::uint16) sizeof(PerformanceSetup), (juce::uint32) numBanks, 0 };
+        out->write(&header, sizeof(header));
+
+        const PerformanceSetup emptySetup;
+        for (int i = 0; i < numBanks; ++i)
+            out->write(&emptySetup, sizeof(emptySetup));
+
+        out->flush();
+        out.reset();
+        return temp.overwriteTargetFileWithTemporary();
+    }
+
+    return false;
+}
+
+void MemoryBank::load() const
+{
+    const juce::ScopedLock sl(loadLock);
+    if (loaded)
+        return;
+
+    if (!openMappedFile())
+    {
+        // Still usable for this session, just not persistent
+        std::cout << "MemoryBank: couldn't map " << file.getFullPathName() << ", using memory only" << std::endl;
+        fallbackRecords.calloc((size_t) numBanks);
+    }
+
+    loaded.store(true, std::memory_order_release);
+}
+
+bool MemoryBank::openMappedFile() const
+{
+    const auto expectedSize = (juce::int64) (sizeof(FileHeader) + sizeof(PerformanceSetup) * (size_t) numBanks);
+
+    auto headerMatches = [this] {
+        FileHeader header {};
+        juce::FileInputStream in(file);
+        return in.openedOk()
+            && in.read(&header, sizeof(header)) == (int) sizeof(header)
+            && header.magic == fileMagic
+            && header.version == fileVersion
+            && header.recordSize == sizeof(PerformanceSetup)
+            && header.numRecords == (juce::uint32) numBanks;
+    };
+
+    // Files from a different layout are replaced rather than misread
+    if (file.getSize() != expectedSize || !headerMatches())
+        if (!createEmptyFile())
+            return false;
+
+    mappedFile = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readWrite);
+
+    if (mappedFile->getData() == nullptr || (juce::int64) mappedFile->getSize() < expectedSize)
+    {
+        mappedFile.reset();
+        return false;
+    }
+
+    return true;
+}
+
+PerformanceSetup* MemoryBank::getRecords() const
+{
+    if (!loaded.load(std::memory_order_acquire))
+        load();
+
+    if (mappedFile != nullptr)
+        return reinterpret_cast<PerformanceSetup*>(static_cast<char*>(mappedFile->getData()) + sizeof(FileHeader));
+
+    return fallbackRecords.get();
+}
+
+bool MemoryBank::isOccupied(int bankIndex) const
+{
+    return juce::isPositiveAndBelow(bankIndex, numBanks) && getRecords()[bankIndex].isOccupied();
+}
+
+bool MemoryBank::store(int bankIndex, const PerformanceSetup& setup)
+{
+    if (!juce::isPositiveAndBelow(bankIndex, numBanks))
+        return false;
+
+    auto record = setup;
+    record.flags |= PerformanceSetup::occupiedFlag;
+    std::memcpy(getRecords() + bankIndex, &record, sizeof(record));
+
+    if (onBankChanged != nullptr)
+        onBankChanged();
+
+    return true;
+}
+
+bool MemoryBank::recall(int bankIndex, PerformanceSetup& destSetup) const
+{
+    if (!isOccupied(bankIndex))
+        return false;
+
+    std::memcpy(&destSetup, getRecords() + bankIndex, sizeof(destSetup));
+    return true;
+}
+
+void MemoryBank::clear(int bankIndex)
+{
+    if (!juce::isPositiveAndBelow(bankIndex, numBanks))
+        return;
+
+    const PerformanceSetup emptySetup;
+    std::memcpy(getRecords() + bankIndex, &emptySetup, sizeof(emptySetup));
+    getProgressionFile(bankIndex).deleteFile();
+
+    if (onBankChanged != nullptr)
+        onBankChanged();
+}
+
+//==============================================================================
+PerformanceSetup MemoryBank::capture(const juce::ValueTree& state)
+{
+    PerformanceSetup setup;
+    setup.key       = (juce::int8) (int) state.getProperty(IDs::SELECTED_KEY, 0);
+    setup.mode      = (juce::int8) (int) state.getProperty(IDs::SELECTED_MODE, 0);
+    setup.octave    = (juce::int8) (int) state.getProperty(IDs::SELECTED_OCTAVE, 0);
+    setup.inversion = (juce::int8) (int) state.getProperty(IDs::INVERSION_VALUE, 0);
+    setup.sound     = (juce::int8) (int) state.getProperty(IDs::SELECTED_SOUND, 0);
+    setup.keySize   = (juce::int8) (int) state.getProperty(IDs::KEY_SIZE, 1);
+    setup.useFlats  = (bool) state.getProperty(IDs::USE_FLATS, false) ? 1 : 0;
+    setup.fader     = (float) (double) state.getProperty(IDs::FADER_VALUE, 0.25);
+    setup.disabledSlotMask = SlotMask::fromVar(state.getProperty(IDs::DISABLED_SLOT_MASK, (juce::int64) 0));
+
+    auto slots = state.getChildWithName(IDs::SLOTS);
+    for (int i = 0; i < AppStateModel::numSlots && i < slots.getNumChildren(); ++i)
+    {
+        auto slot = slots.getChild(i);
+        setup.chordTypeIndex[i] = (juce::int8) (int) slot.getProperty(IDs::CHORD_TYPE_INDEX, 0);
+        setup.bassOffset[i]     = (juce::int8) (int) slot.getProperty(IDs::BASS_OFFSET, 0);
+    }
+
+    return setup;
+}
+
+void MemoryBank::apply(const PerformanceSetup& setup, juce::ValueTree& state, juce::UndoManager* undoManager)
+{
+    // ValueTree skips notifications for unchanged values, so only what differs is broadcast.
+    // Listeners that feed the engine batch their updates, so the whole recall lands at once.
+    state.setProperty(IDs::SELECTED_KEY, (int) setup.key, undoManager);
+    state.setProperty(IDs::SELECTED_MODE, (int) setup.mode, undoManager);
+    state.setProperty(IDs::SELECTED_OCTAVE, (int) setup.octave, undoManager);
+    state.setProperty(IDs::INVERSION_VALUE, (int) setup.inversion, undoManager);
+    state.setProperty(IDs::SELECTED_SOUND, (int) setup.sound, undoManager);
+    state.setProperty(IDs::KEY_SIZE, (int) setup.keySize, undoManager);
+    state.setProperty(IDs::USE_FLATS, setup.useFlats != 0, undoManager);
+    state.setProperty(IDs::FADER_VALUE, (double) setup.fader, undoManager);
+    state.setProperty(IDs::DISABLED_SLOT_MASK, SlotMask::toVar(setup.disabledSlotMask), undoManager);
+
+    auto slots = state.getChildWithName(IDs::SLOTS);
+    for (int i = 0; i < AppStateModel::numSlots && i < slots.getNumChildren(); ++i)
+    {
+        auto slot = slots.getChild(i);
+        slot.setProperty(IDs::CHORD_TYPE_INDEX, (int) setup.chordTypeIndex[i], undoManager);
+        slot.setProperty(IDs::BASS_OFFSET, (int) setup.bassOffset[i], undoManager);
+    }
+}
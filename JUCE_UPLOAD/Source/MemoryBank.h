@@ -0,0 +1,105 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <type_traits>
+#include "AppStateModel.h"
+#include "StateSerializer.h"
+#include "SlotMask.h"
+
+// One complete performance setup, stored as a fixed-size record so any bank can be
+// located with a single multiply and copied out with a single memcpy.
+struct PerformanceSetup
+{
+    static constexpr juce::uint32 occupiedFlag = 1u << 0;
+
+    juce::uint32 flags = 0;
+    juce::int8 key = 0;
+    juce::int8 mode = 0;
+    juce::int8 octave = 0;
+    juce::int8 inversion = 0;
+    juce::int8 sound = 0;
+    juce::int8 keySize = 1;
+    juce::int8 useFlats = 0;
+    juce::int8 reserved0 = 0;
+    float fader = 0.25f;
+    juce::int8 chordTypeIndex[AppStateModel::numSlots] = {};
+    juce::int8 bassOffset[AppStateModel::numSlots] = {};
+    juce::uint64 disabledSlotMask = 0; // Was reserved (zero) in older bank files
+
+    bool isOccupied() const noexcept { return (flags & occupiedFlag) != 0; }
+};
+
+static_assert(std::is_trivially_copyable<PerformanceSetup>::value, "Records are copied as raw bytes");
+static_assert(sizeof(PerformanceSetup) == 96, "Changing the record size breaks existing bank files");
+
+//==============================================================================
+// Bank of performance setups kept in a memory-mapped file, so storing a bank is a
+// write into mapped memory and the OS takes care of flushing it to disk.
+// Recall is O(1) and the result is applied to the app state as one batch; the audio
+// side only ever sees the state through its own published snapshot, never the bank.
+//
+// The file is mapped on first use, or earlier by load() as deferred startup work, so
+// creating a bank never touches the disk.
+//
+// The banks belong to the user, not to a project: they're shared by every instance and
+// deliberately kept out of the plugin state, so loading a project never replaces them.
+class MemoryBank
+{
+public:
+    static constexpr int defaultNumBanks = 64;
+
+    explicit MemoryBank(const juce::File& bankFile, int numBanks = defaultNumBanks);
+    ~MemoryBank();
+
+    // Maps the file, if that hasn't happened yet. Any thread.
+    void load() const;
+
+    int getNumBanks() const noexcept { return numBanks; }
+    bool isOccupied(int bankIndex) const;
+
+    bool store(int bankIndex, const PerformanceSetup& setup);
+    bool recall(int bankIndex, PerformanceSetup& destSetup) const;
+    void clear(int bankIndex); // Its progression file goes too
+
+    // Conversions between the app state and a record
+    static PerformanceSetup capture(const juce::ValueTree& state);
+    static void apply(const PerformanceSetup& setup, juce::ValueTree& state, juce::UndoManager* undoManager);
+
+    // Called on the message thread after a bank has been stored or cleared
+    std::function<void()> onBankChanged;
+
+    static juce::File getDefaultFile();
+
+    // Where a progression recorded with a bank's setup is kept, next to the bank file.
+    // Returns File() for a bank that isn't backed by a file.
+    juce::File getProgressionFile(int bankIndex) const;
+
+private:
+    struct FileHeader
+    {
+        juce::uint32 magic;
+        juce::uint16 version;
+        juce::uint16 recordSize;
+        juce::uint32 numRecords;
+        juce::uint32 reserved;
+    };
+
+    static constexpr juce::uint32 fileMagic = StateSerializer::makeChunkId('P', 'X', 'L', 'B');
+    static constexpr juce::uint16 fileVersion = 1;
+
+    bool openMappedFile() const;
+    bool createEmptyFile() const;
+    PerformanceSetup* getRecords() const; // Loads first if need be
+
+    const juce::File file;
+    const int numBanks;
+
+    // Filled in by load(), which can run on any thread
+    juce::CriticalSection loadLock;
+    mutable std::atomic<bool> loaded { false };
+    mutable std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    mutable juce::HeapBlock<PerformanceSetup> fallbackRecords; // Used if the file can't be mapped
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MemoryBank)
+};
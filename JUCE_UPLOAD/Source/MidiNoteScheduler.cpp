@@ -0,0 +1,76 @@
+#include "MidiNoteScheduler.h"
+
+void MidiNoteScheduler::reset()
+{
+    numEvents = 0;
+    for (auto& channel : sounding)
+        channel.fill({});
+}
+
+bool MidiNoteScheduler::scheduleNoteOn(juce::int64 time, int channel, int note, int velocity, int sourceNote)
+{
+    return add({ time, (juce::int8) sourceNote, (juce::uint8) juce::jlimit(1, 16, channel),
+                 (juce::uint8) juce::jlimit(0, 127, note), (juce::uint8) juce::jlimit(1, 127, velocity) });
+}
+
+bool MidiNoteScheduler::scheduleNoteOff(juce::int64 time, int channel, int note, int sourceNote)
+{
+    return add({ time, (juce::int8) sourceNote, (juce::uint8) juce::jlimit(1, 16, channel), (juce::uint8) juce::jlimit(0, 127, note), 0 });
+}
+
+void MidiNoteScheduler::renderUntil(juce::MidiBuffer& dest, juce::int64 blockStart, juce::int64 endTime)
+{
+    // Emit in time order; at equal times note-offs go first so a retriggered note restarts cleanly
+    for (;;)
+    {
+        int next = -1;
+        for (int i = 0; i < numEvents; ++i)
+        {
+            const auto& event = events[(size_t) i];
+            if (event.time >= endTime)
+                continue;
+
+            if (next < 0 || event.time < events[(size_t) next].time
+                || (event.time == events[(size_t) next].time && event.velocity == 0 && events[(size_t) next].velocity > 0))
+                next = i;
+        }
+
+        if (next < 0)
+            break;
+
+        const auto event = events[(size_t) next];
+        removeAt(next);
+
+        const int offset = (int) juce::jmax((juce::int64) 0, event.time - blockStart);
+        auto& state = sounding[event.channel - 1u][event.note];
+
+        if (event.velocity > 0)
+        {
+            if (state.isOn) // Same note still sounding: end it first so note-ons and offs stay paired
+                dest.addEvent(juce::MidiMessage::noteOff(event.channel, event.note), offset);
+
+            dest.addEvent(juce::MidiMessage::noteOn(event.channel, event.note, event.velocity), offset);
+            state = { true, event.sourceNote };
+        }
+        else if (state.isOn)
+        {
+            dest.addEvent(juce::MidiMessage::noteOff(event.channel, event.note), offset);
+            state = {};
+        }
+    }
+}
+
+bool MidiNoteScheduler::add(const Event& event)
+{
+    if (numEvents >= capacity)
+        return false;
+
+    events[(size_t) numEvents++] = event;
+    return true;
+}
+
+void MidiNoteScheduler::removeAt(int index) noexcept
+{
+    // Order doesn't matter, renderUntil picks events by time
+    events[(size_t) index] = events[(size_t) --numEvents];
+}
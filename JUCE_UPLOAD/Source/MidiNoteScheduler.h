@@ -0,0 +1,90 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// Fixed-capacity schedule of outgoing note-ons and note-offs, in absolute sample time.
+// Events that fall beyond the current block (flam stagger, note lengths) stay queued
+// for later blocks. Nothing allocates after construction, so this is safe to use on
+// the audio thread.
+class MidiNoteScheduler
+{
+public:
+    static constexpr int capacity = 512;
+
+    MidiNoteScheduler() = default;
+
+    void reset();
+
+    // Returns false if the queue is full and the event was dropped
+    bool scheduleNoteOn(juce::int64 time, int channel, int note, int velocity, int sourceNote);
+    bool scheduleNoteOff(juce::int64 time, int channel, int note, int sourceNote = -1);
+
+    // Ends everything at `time`: pending note-ons are cancelled, sounding notes get a
+    // note-off and pending note-offs are dropped, so a stale one can't cut a later note short
+    void stopAll(juce::int64 time) { stopWhere(time, [](int) { return true; }); }
+
+    // As stopAll, but only for notes started by sourceNote
+    void stopSource(juce::int64 time, int sourceNote) { stopWhere(time, [sourceNote](int source) { return source == sourceNote; }); }
+
+    // As stopAll, for the notes whose source shouldStop(sourceNote) picks
+    template <typename Predicate>
+    void stopWhere(juce::int64 time, Predicate&& shouldStop)
+    {
+        // Pending note-ons that haven't started yet are simply cancelled, and so are the
+        // matching note-offs: the sounding notes get fresh ones below
+        for (int i = numEvents; --i >= 0;)
+        {
+            const auto& event = events[(size_t) i];
+
+            if (event.velocity > 0)
+            {
+                if (event.time >= time && shouldStop((int) event.sourceNote))
+                    removeAt(i);
+            }
+            else
+            {
+                const auto& note = sounding[event.channel - 1u][event.note];
+                if (shouldStop((int) event.sourceNote) || (note.isOn && shouldStop((int) note.sourceNote)))
+                    removeAt(i);
+            }
+        }
+
+        for (int channel = 0; channel < 16; ++channel)
+            for (int note = 0; note < 128; ++note)
+                if (const auto& state = sounding[(size_t) channel][(size_t) note]; state.isOn && shouldStop((int) state.sourceNote))
+                    scheduleNoteOff(time, channel + 1, note, state.sourceNote);
+    }
+
+    // Writes every event due before endTime into dest, in time order, at its offset from
+    // blockStart. Call it up to each incoming event's position before stopping notes, so
+    // everything due before the stop has already gone out.
+    void renderUntil(juce::MidiBuffer& dest, juce::int64 blockStart, juce::int64 endTime);
+
+    int getNumPending() const noexcept { return numEvents; }
+
+private:
+    struct Event
+    {
+        juce::int64 time = 0;
+        juce::int8 sourceNote = -1;
+        juce::uint8 channel = 1;
+        juce::uint8 note = 0;
+        juce::uint8 velocity = 0;     // 0 = note-off
+    };
+
+    struct SoundingNote
+    {
+        bool isOn = false;
+        juce::int8 sourceNote = -1;
+    };
+
+    bool add(const Event& event);
+    void removeAt(int index) noexcept;
+
+    std::array<Event, capacity> events;
+    int numEvents = 0;
+    std::array<std::array<SoundingNote, 128>, 16> sounding; // [channel - 1][note]
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiNoteScheduler)
+};
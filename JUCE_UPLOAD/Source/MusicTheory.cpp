@@ -0,0 +1,258 @@
+#include "MusicTheory.h"
+#include <cstring>
+
+namespace MusicTheory
+{
+    namespace
+    {
+        const char* const modeNames[numModes] = { "FREE", "MAJOR", "MINOR", "DORIAN", "PHRYGIAN", "LYDIAN", "MIXOLYDIAN", "LOCRIAN" };
+
+        // Intervals for each mode (semitones from the key), from chord-utils.ts
+        const juce::int8 modeIntervals[numModes][7] = {
+            { 0, 0, 0, 0, 0, 0, 0 },   // FREE (unused, every note is in scale)
+            { 0, 2, 4, 5, 7, 9, 11 },  // major
+            { 0, 2, 3, 5, 7, 8, 10 },  // minor
+            { 0, 2, 3, 5, 7, 9, 10 },  // dorian
+            { 0, 1, 3, 5, 7, 8, 10 },  // phrygian
+            { 0, 2, 4, 6, 7, 9, 11 },  // lydian
+            { 0, 2, 4, 5, 7, 9, 10 },  // mixolydian
+            { 0, 1, 3, 5, 6, 8, 10 },  // locrian
+        };
+
+        const ChordType chordTypes[] = {
+            // Basic triads
+            { "major",           "",        3, { 0, 4, 7 } },
+            { "minor",           "m",       3, { 0, 3, 7 } },
+            { "dim",             "dim",     3, { 0, 3, 6 } },
+            { "augmented",       "aug",     3, { 0, 4, 8 } },
+            { "5",               "5",       2, { 0, 7 } },
+            // 7th chords
+            { "major7",          "maj7",    4, { 0, 4, 7, 11 } },
+            { "M7",              "M7",      4, { 0, 4, 7, 11 } },
+            { "minor7",          "m7",      4, { 0, 3, 7, 10 } },
+            { "7",               "7",       4, { 0, 4, 7, 10 } },
+            { "dim7",            "dim7",    4, { 0, 3, 6, 9 } },
+            { "m7b5",            "m7b5",    4, { 0, 3, 6, 10 } },
+            { "φ7",              "φ7",      4, { 0, 3, 6, 10 } },
+            { "minorMajor7",     "mMaj7",   4, { 0, 3, 7, 11 } },
+            // 9th chords
+            { "major9",          "maj9",    5, { 0, 4, 7, 11, 14 } },
+            { "minor9",          "m9",      5, { 0, 3, 7, 10, 14 } },
+            { "9",               "9",       5, { 0, 4, 7, 10, 14 } },
+            { "add9",            "add9",    4, { 0, 4, 7, 14 } },
+            { "7b9",             "7b9",     5, { 0, 4, 7, 10, 13 } },
+            { "7#9",             "7#9",     5, { 0, 4, 7, 10, 15 } },
+            { "dim9",            "dim9",    5, { 0, 3, 6, 9, 14 } },
+            { "aug9",            "aug9",    5, { 0, 4, 8, 10, 14 } },
+            // 11th & 13th chords
+            { "11",              "11",      6, { 0, 4, 7, 10, 14, 17 } },
+            { "m11",             "m11",     6, { 0, 3, 7, 10, 14, 17 } },
+            { "major11",         "maj11",   6, { 0, 4, 7, 11, 14, 17 } },
+            { "13",              "13",      6, { 0, 4, 7, 10, 14, 21 } },
+            { "13sus",           "13sus",   6, { 0, 5, 7, 10, 14, 21 } },
+            { "13b9",            "13b9",    6, { 0, 4, 7, 10, 13, 21 } },
+            { "m11b5",           "m11b5",   6, { 0, 3, 6, 10, 14, 17 } },
+            // Sus chords
+            { "sus2",            "sus2",    3, { 0, 2, 7 } },
+            { "sus4",            "sus4",    3, { 0, 5, 7 } },
+            { "7sus",            "7sus",    4, { 0, 5, 7, 10 } },
+            { "7sus4",           "7sus4",   4, { 0, 5, 7, 10 } },
+            { "9sus",            "9sus",    5, { 0, 5, 7, 10, 14 } },
+            { "7sus2b9",         "7sus2b9", 5, { 0, 2, 7, 10, 13 } },
+            // 6th chords
+            { "6",               "6",       4, { 0, 4, 7, 9 } },
+            { "minor6",          "m6",      4, { 0, 3, 7, 9 } },
+            { "69",              "69",      5, { 0, 4, 7, 9, 14 } },
+            { "m69",             "m69",     5, { 0, 3, 7, 9, 14 } },
+            // Altered/special chords
+            { "7#11",            "7#11",    5, { 0, 4, 7, 10, 18 } },
+            { "7b13",            "7b13",    5, { 0, 4, 7, 10, 20 } },
+            { "maj9#11",         "maj9#11", 6, { 0, 4, 7, 11, 14, 18 } },
+            { "m9b5",            "m9b5",    5, { 0, 3, 6, 10, 14 } },
+            { "9#11",            "9#11",    6, { 0, 4, 7, 10, 14, 18 } },
+            { "maj7#5",          "maj7#5",  4, { 0, 4, 8, 11 } },
+            { "7alt",            "7alt",    6, { 0, 4, 8, 10, 15, 21 } },
+            { "7b5",             "7b5",     4, { 0, 4, 6, 10 } },
+            { "7#5",             "7#5",     4, { 0, 4, 8, 10 } },
+            { "augmented7",      "aug7",    4, { 0, 4, 8, 10 } },
+            { "augmentedMajor7", "augMaj7", 4, { 0, 4, 8, 11 } },
+        };
+
+        constexpr int numChordTypes = (int) (sizeof(chordTypes) / sizeof(chordTypes[0]));
+
+        // Indices into chordTypes, looked up once by id so the tables below read like the reference
+        int findChordType(const char* id)
+        {
+            for (int i = 0; i < numChordTypes; ++i)
+                if (std::strcmp(chordTypes[i].id, id) == 0)
+                    return i;
+
+            jassertfalse;
+            return 0;
+        }
+
+        struct DegreeChords
+        {
+            int count = 0;
+            juce::uint8 ids[16] = {};
+        };
+
+        struct ChordTables
+        {
+            juce::uint8 all[numChordTypes] = {};
+            DegreeChords major[7];
+            DegreeChords minor[7];
+
+            ChordTables()
+            {
+                for (int i = 0; i < numChordTypes; ++i)
+                    all[i] = (juce::uint8) i;
+
+                auto fill = [](DegreeChords& dest, std::initializer_list<const char*> ids) {
+                    for (auto* id : ids)
+                        dest.ids[dest.count++] = (juce::uint8) findChordType(id);
+                };
+
+                // MAJOR_SCALE_CHORDS from PianoXL.tsx
+                fill(major[0], { "major", "major7", "major9", "major11", "6", "69", "add9", "sus2", "sus4", "7", "9", "11" });
+                fill(major[1], { "minor", "minor7", "minor9", "m11", "minor6", "m7b5", "sus2", "sus4" });
+                fill(major[2], { "minor", "minor7", "minor9", "m11", "minor6", "sus2", "sus4" });
+                fill(major[3], { "major", "major7", "major9", "major11", "6", "add9", "sus2", "sus4", "11" });
+                fill(major[4], { "major", "7", "9", "11", "7sus4", "sus4", "sus2", "add9", "13" });
+                fill(major[5], { "minor", "minor7", "minor9", "m11", "minor6", "sus2", "sus4" });
+                fill(major[6], { "dim", "dim7", "m7b5", "minor7", "7b5", "sus2" });
+
+                // MINOR_SCALE_CHORDS from PianoXL.tsx
+                fill(minor[0], { "minor", "minor7", "minor9", "m11", "minor6", "minorMajor7", "sus2", "sus4" });
+                fill(minor[1], { "dim", "dim7", "m7b5", "minor7", "7b5", "sus2" });
+                fill(minor[2], { "major", "major7", "major9", "add9", "6", "sus2", "sus4" });
+                fill(minor[3], { "minor", "minor7", "minor9", "m11", "minor6", "sus2", "sus4" });
+                fill(minor[4], { "minor", "minor7", "minor9", "m11", "minor6", "sus2", "sus4" });
+                fill(minor[5], { "major", "major7", "major9", "6", "add9", "sus2", "sus4" });
+                fill(minor[6], { "major", "7", "9", "11", "sus2", "sus4" });
+            }
+        };
+
+        const ChordTables& getChordTables()
+        {
+            static const ChordTables tables;
+            return tables;
+        }
+    }
+
+    const char* getModeName(int modeIndex)
+    {
+        return modeNames[juce::jlimit(0, numModes - 1, modeIndex)];
+    }
+
+    juce::uint16 getScaleMask(int key, int modeIndex)
+    {
+        if (modeIndex <= 0 || modeIndex >= numModes)
+            return 0x0fff;
+
+        juce::uint16 mask = 0;
+        for (auto interval : modeIntervals[modeIndex])
+            mask |= (juce::uint16) (1 << wrapPitchClass(key + interval));
+
+        return mask;
+    }
+
+    bool isInScale(int pitchClass, int key, int modeIndex)
+    {
+        return (getScaleMask(key, modeIndex) & (1 << wrapPitchClass(pitchClass))) != 0;
+    }
+
+    int getScaleDegree(int pitchClass, int key, int modeIndex)
+    {
+        if (modeIndex <= 0 || modeIndex >= numModes)
+            return wrapPitchClass(pitchClass - key);
+
+        for (int degree = 0; degree < 7; ++degree)
+            if (wrapPitchClass(key + modeIntervals[modeIndex][degree]) == wrapPitchClass(pitchClass))
+                return degree;
+
+        return -1;
+    }
+
+    int getNumChordTypes()
+    {
+        return numChordTypes;
+    }
+
+    const ChordType& getChordType(int chordTypeId)
+    {
+        return chordTypes[juce::jlimit(0, numChordTypes - 1, chordTypeId)];
+    }
+
+    int getAvailableChordTypes(int pitchClass, int key, int modeIndex, const juce::uint8*& chordTypeIds)
+    {
+        const auto& tables = getChordTables();
+
+        if (modeIndex <= 0 || modeIndex >= numModes)
+        {
+            chordTypeIds = tables.all;
+            return numChordTypes;
+        }
+
+        const int degree = getScaleDegree(pitchClass, key, modeIndex);
+        if (degree < 0)
+        {
+            chordTypeIds = nullptr;
+            return 0;
+        }
+
+        // As in the reference, minor uses its own table and every other mode the major one
+        const auto& degreeChords = modeIndex == (int) Mode::minor ? tables.minor[degree] : tables.major[degree];
+        chordTypeIds = degreeChords.ids;
+        return degreeChords.count;
+    }
+
+    int resolveChordType(int pitchClass, int key, int modeIndex, int chordTypeIndex)
+    {
+        const juce::uint8* ids = nullptr;
+        const int count = getAvailableChordTypes(pitchClass, key, modeIndex, ids);
+
+        if (count == 0)
+            return -1;
+
+        return ids[((chordTypeIndex % count) + count) % count];
+    }
+
+    //==============================================================================
+    void ChordName::append(const char* utf8) noexcept
+    {
+        for (; *utf8 != 0 && length < capacity - 1; ++utf8)
+            text[length++] = *utf8;
+
+        jassert(*utf8 == 0); // Too long for the buffer
+        text[length] = 0;
+    }
+
+    bool ChordName::operator==(const ChordName& other) const noexcept
+    {
+        return length == other.length && std::memcmp(text, other.text, (size_t) length) == 0;
+    }
+
+    ChordName formatChordName(int rootPitchClass, int chordTypeId, int bassOffset, bool useFlats, int modeIndex) noexcept
+    {
+        const bool flats = useFlats && modeIndex == (int) Mode::free;
+
+        // Note names and suffixes are all static tables, so this is only byte copies
+        ChordName name(getNoteName(rootPitchClass, flats));
+        name.append(getChordType(chordTypeId).suffix);
+
+        if (bassOffset != 0)
+        {
+            name.append("/");
+            name.append(getNoteName(rootPitchClass + bassOffset, flats));
+        }
+
+        return name;
+    }
+
+    juce::String getChordName(int rootPitchClass, int chordTypeId, int bassOffset, bool useFlats, int modeIndex)
+    {
+        const auto name = formatChordName(rootPitchClass, chordTypeId, bassOffset, useFlats, modeIndex);
+        return juce::String(juce::CharPointer_UTF8(name.getText()));
+    }
+}
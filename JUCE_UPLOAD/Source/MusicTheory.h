@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Note naming, scales and chord tables shared by the UI and the engine.
+// Ported from utils/music.ts, utils/chord-utils.ts and PianoXL.tsx in the reference implementation.
+namespace MusicTheory
+{
+    constexpr int numPitchClasses = 12;
+    constexpr int middleC = 60;
+
+    inline const char* const sharpNoteNames[numPitchClasses] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+    inline const char* const flatNoteNames[numPitchClasses]  = { "C", "Db", "D", "Eb", "E", "F", "Gb", "G", "Ab", "A", "Bb", "B" };
+
+    constexpr int wrapPitchClass(int value) noexcept { return ((value % numPitchClasses) + numPitchClasses) % numPitchClasses; }
+
+    inline const char* getNoteName(int pitchClass, bool useFlats)
+    {
+        const int index = wrapPitchClass(pitchClass);
+        return useFlats ? flatNoteNames[index] : sharpNoteNames[index];
+    }
+
+    //==============================================================================
+    // Modes, in SELECTED_MODE order
+    enum class Mode { free = 0, major, minor, dorian, phrygian, lydian, mixolydian, locrian };
+    constexpr int numModes = 8;
+
+    const char* getModeName(int modeIndex);
+
+    // Bit n set = pitch class n is in the scale. FREE contains every note.
+    juce::uint16 getScaleMask(int key, int modeIndex);
+    bool isInScale(int pitchClass, int key, int modeIndex);
+
+    // 0-based scale degree of a pitch class, or -1 if it's not in the scale
+    int getScaleDegree(int pitchClass, int key, int modeIndex);
+
+    //==============================================================================
+    // Chord types, in PianoXL.tsx's ALL_CHORD_TYPES order
+    struct ChordType
+    {
+        const char* id;          // Name used by chord-utils.ts
+        const char* suffix;      // Appended to the root by getChordName()
+        int numIntervals;
+        juce::int8 intervals[6]; // Semitones from the root, ascending
+    };
+
+    int getNumChordTypes();
+    const ChordType& getChordType(int chordTypeId);
+
+    // Chord types selectable on a key: all of them in FREE, otherwise the list for the
+    // key's scale degree. Returns the number of entries written to the pointer.
+    int getAvailableChordTypes(int pitchClass, int key, int modeIndex, const juce::uint8*& chordTypeIds);
+
+    // Resolves a slot's CHORD_TYPE_INDEX into a chord type id, or -1 if the key
+    // isn't playable in the current mode
+    int resolveChordType(int pitchClass, int key, int modeIndex, int chordTypeIndex);
+
+    //==============================================================================
+    // A chord name as UTF-8 in a fixed inline buffer, so naming chords never allocates.
+    // The longest name the tables can make ("G#maj9#11/A#") fits with room to spare.
+    struct ChordName
+    {
+        static constexpr int capacity = 24;
+
+        ChordName() noexcept = default;
+        explicit ChordName(const char* utf8) noexcept { append(utf8); }
+
+        // Truncated (at a byte, so keep to names from the tables) if it would overflow
+        void append(const char* utf8) noexcept;
+
+        const char* getText() const noexcept { return text; }
+        int getLength() const noexcept { return length; }
+        bool isEmpty() const noexcept { return length == 0; }
+
+        bool operator==(const ChordName& other) const noexcept;
+        bool operator!=(const ChordName& other) const noexcept { return !operator==(other); }
+
+    private:
+        char text[capacity] = {};
+        int length = 0;
+    };
+
+    // e.g. "C#m7b5/G". Flats are only used in FREE mode, as in the reference.
+    ChordName formatChordName(int rootPitchClass, int chordTypeId, int bassOffset, bool useFlats, int modeIndex) noexcept;
+    juce::String getChordName(int rootPitchClass, int chordTypeId, int bassOffset, bool useFlats, int modeIndex);
+}
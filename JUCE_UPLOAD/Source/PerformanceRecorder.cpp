@@ -0,0 +1,356 @@
+#include "PerformanceRecorder.h"
+#include "EngineState.h"
+#include "VoiceLeading.h"
+#include <iostream>
+
+namespace
+{
+    constexpr int drainIntervalMs = 5;
+    constexpr int initialCapacity = 4096;        // Chords; grows on the drain thread after that
+    constexpr int ticksPerQuarterNote = 960;
+
+    constexpr juce::uint32 fileMagic = StateSerializer::makeChunkId('P', 'X', 'L', 'P');
+    constexpr int fileVersion = 2; // 1 stored RecordedChords as raw bytes; those files aren't read
+}
+
+PerformanceRecorder::PerformanceRecorder()
+    : juce::Thread("PianoXL recorder")
+{
+    chords.reserve((size_t) initialCapacity);
+    startThread();
+}
+
+PerformanceRecorder::~PerformanceRecorder()
+{
+    stopThread(1000);
+}
+
+//==============================================================================
+void PerformanceRecorder::record(juce::int64 engineTime, double ppq, int keyIndex, int slotIndex,
+                                 const Voicing& voicing, juce::int64 lengthSamples) noexcept
+{
+    RecordedChord chord;
+    chord.time = engineTime;
+    chord.ppq = ppq;
+    chord.lengthSamples = lengthSamples;
+    chord.take = currentTake.load(std::memory_order_relaxed);
+    chord.keyIndex = (juce::int8) keyIndex;
+    chord.slotIndex = (juce::int8) slotIndex;
+    chord.voicing = voicing;
+
+    if (!queue.push(chord))
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerformanceRecorder::run()
+{
+    while (!threadShouldExit())
+    {
+        drainQueue();
+        wait(drainIntervalMs);
+    }
+}
+
+void PerformanceRecorder::drainQueue()
+{
+    const juce::ScopedLock lock(progressionLock);
+    const auto take = currentTake.load();
+
+    queue.popAll([this, take](const RecordedChord& chord) {
+        if (chord.take != take)
+            return; // Queued just before the recording was restarted
+
+        if (chords.empty())
+            firstChordTime = chord.time;
+
+        chords.push_back(chord);
+        chords.back().time -= firstChordTime;
+    });
+}
+
+//==============================================================================
+void PerformanceRecorder::startRecording(const PerformanceSetup& setupAtStart)
+{
+    {
+        const juce::ScopedLock lock(progressionLock);
+        currentTake.fetch_add(1);
+        chords.clear();
+        chordsSampleRate = sampleRate;
+        recordedSetup = setupAtStart;
+    }
+
+    numDropped = 0;
+    recording = true;
+    std::cout << "Recording started" << std::endl;
+}
+
+void PerformanceRecorder::stopRecording()
+{
+    recording = false;
+    drainQueue();
+    std::cout << "Recording stopped: " << getNumRecordedChords() << " chord(s), " << numDropped.load() << " dropped" << std::endl;
+
+    if (onProgressionChanged != nullptr)
+        onProgressionChanged();
+}
+
+RecordedProgression::Ptr PerformanceRecorder::getProgression()
+{
+    drainQueue();
+
+    RecordedProgression::Ptr progression(new RecordedProgression());
+    progression->sampleRate = sampleRate;
+
+    const juce::ScopedLock lock(progressionLock);
+    progression->chords = chords;
+
+    // Playback is in samples, so a progression recorded at another rate is rescaled
+    if (chordsSampleRate > 0.0 && chordsSampleRate != progression->sampleRate)
+    {
+        const double ratio = progression->sampleRate / chordsSampleRate;
+        for (auto& chord : progression->chords)
+        {
+            chord.time = (juce::int64) std::llround((double) chord.time * ratio);
+            chord.lengthSamples = (juce::int64) std::llround((double) chord.lengthSamples * ratio);
+        }
+    }
+
+    return progression;
+}
+
+int PerformanceRecorder::getNumRecordedChords()
+{
+    drainQueue();
+
+    const juce::ScopedLock lock(progressionLock);
+    return (int) chords.size();
+}
+
+//==============================================================================
+void PerformanceRecorder::applySmoothVoicing(RecordedProgression& progression, const EngineState& state)
+{
+    if (state.smoothVoicing == 0)
+        return;
+
+    // A chord recorded in another key or with another chord type isn't among the candidates
+    std::vector<size_t> chordIndices;
+    std::vector<VoiceLeading::Step> steps;
+    for (size_t i = 0; i < progression.chords.size(); ++i)
+    {
+        const auto& chord = progression.chords[i];
+        if (!juce::isPositiveAndBelow((int) chord.keyIndex, AppStateModel::numKeys)
+            || !juce::isPositiveAndBelow((int) chord.slotIndex, AppStateModel::maxSlotsPerKey))
+            continue;
+
+        const auto& candidates = state.candidates[AppStateModel::getFlatSlotIndex(chord.keyIndex, chord.slotIndex)];
+        if (VoiceLeading::findCandidate(candidates, chord.voicing) >= 0)
+        {
+            chordIndices.push_back(i);
+            steps.push_back({ chord.keyIndex, chord.slotIndex });
+        }
+    }
+
+    std::vector<Voicing> voicings(steps.size());
+    VoiceLeading::optimiseProgression(state, steps.data(), (int) steps.size(), voicings.data());
+
+    for (size_t n = 0; n < voicings.size(); ++n)
+        progression.chords[chordIndices[n]].voicing = voicings[n];
+}
+
+juce::MidiFile PerformanceRecorder::createMidiFile(const RecordedProgression& progression, double bpm)
+{
+    bpm = bpm > 0.0 ? bpm : 120.0;
+    const auto& recorded = progression.chords;
+    const double samplesPerBeat = progression.sampleRate * 60.0 / bpm;
+    const bool useHostBeats = !recorded.empty() && recorded.front().ppq >= 0.0;
+
+    auto getBeat = [&](const RecordedChord& chord) {
+        if (useHostBeats && chord.ppq >= 0.0)
+            return chord.ppq - recorded.front().ppq;
+
+        return (double) chord.time / samplesPerBeat;
+    };
+
+    juce::MidiMessageSequence track;
+    track.addEvent(juce::MidiMessage::tempoMetaEvent(juce::roundToInt(60000000.0 / bpm)), 0.0);
+
+    for (size_t i = 0; i < recorded.size(); ++i)
+    {
+        const auto& chord = recorded[i];
+        const double start = getBeat(chord);
+
+        // A chord rings for its sustain time, or until the next one replaces it
+        double end = start + (double) chord.lengthSamples / samplesPerBeat;
+        if (i + 1 < recorded.size())
+            end = juce::jmin(end, getBeat(recorded[i + 1]));
+
+        const double startTick = start * ticksPerQuarterNote;
+        const double endTick = juce::jmax(startTick + 1.0, end * ticksPerQuarterNote);
+
+        auto addNote = [&track, startTick, endTick](int channel, int note) {
+            track.addEvent(juce::MidiMessage::noteOn(channel, note, (juce::uint8) 100), startTick);
+            track.addEvent(juce::MidiMessage::noteOff(channel, note), endTick);
+        };
+
+        for (int n = 0; n < chord.voicing.numNotes; ++n)
+            addNote(1, chord.voicing.notes[n]);
+
+        if (chord.voicing.bassNote >= 0)
+            addNote(2, chord.voicing.bassNote);
+    }
+
+    track.sort();
+    track.updateMatchedPairs();
+
+    juce::MidiFile file;
+    file.setTicksPerQuarterNote(ticksPerQuarterNote);
+    file.addTrack(track);
+    return file;
+}
+
+bool PerformanceRecorder::exportToMidiFile(const juce::File& file, double bpm, const EngineState& state)
+{
+    auto progression = getProgression();
+    applySmoothVoicing(*progression, state);
+    const auto midiFile = createMidiFile(*progression, bpm);
+
+    juce::TemporaryFile temp(file);
+    if (auto out = temp.getFile().createOutputStream())
+    {
+        const bool written = midiFile.writeTo(*out);
+        out.reset();
+        return written && temp.overwriteTargetFileWithTemporary();
+    }
+
+    return false;
+}
+
+//==============================================================================
+bool PerformanceRecorder::saveToMemoryBank(MemoryBank& bank, int bankIndex)
+{
+    const auto file = bank.getProgressionFile(bankIndex);
+    if (file == juce::File() || !file.getParentDirectory().createDirectory())
+        return false;
+
+    drainQueue();
+
+    juce::TemporaryFile temp(file);
+    if (auto out = temp.getFile().createOutputStream())
+    {
+        writeProgression(*out);
+        out->flush();
+        out.reset();
+
+        if (!temp.overwriteTargetFileWithTemporary())
+            return false;
+
+        const juce::ScopedLock lock(progressionLock);
+        return bank.store(bankIndex, recordedSetup);
+    }
+
+    return false;
+}
+
+bool PerformanceRecorder::loadFromMemoryBank(const MemoryBank& bank, int bankIndex)
+{
+    const auto file = bank.getProgressionFile(bankIndex);
+    if (!file.existsAsFile())
+        return false;
+
+    juce::FileInputStream in(file);
+    if (!in.openedOk() || !readProgression(in))
+        return false;
+
+    if (onProgressionChanged != nullptr)
+        onProgressionChanged();
+
+    return true;
+}
+
+void PerformanceRecorder::writeChunk(juce::MemoryOutputStream& out) const
+{
+    writeProgression(out);
+}
+
+void PerformanceRecorder::readChunk(const void* data, size_t sizeInBytes)
+{
+    juce::MemoryInputStream in(data, sizeInBytes, false);
+    readProgression(in);
+}
+
+void PerformanceRecorder::writeProgression(juce::OutputStream& out) const
+{
+    const juce::ScopedLock lock(progressionLock);
+
+    // Field by field, so the file doesn't depend on the struct's layout or padding
+    out.writeInt((int) fileMagic);
+    out.writeInt(fileVersion);
+    out.writeInt((int) chords.size());
+    out.writeDouble(chordsSampleRate);
+
+    for (const auto& chord : chords)
+    {
+        out.writeInt64(chord.time);
+        out.writeDouble(chord.ppq);
+        out.writeInt64(chord.lengthSamples);
+        out.writeByte((char) chord.keyIndex);
+        out.writeByte((char) chord.slotIndex);
+
+        const auto& voicing = chord.voicing;
+        out.writeByte((char) voicing.numNotes);
+        out.write(voicing.notes, voicing.numNotes);
+        out.writeByte((char) voicing.bassNote);
+        out.writeByte((char) voicing.chordType);
+        out.writeByte((char) voicing.root);
+    }
+}
+
+bool PerformanceRecorder::readProgression(juce::InputStream& in)
+{
+    if ((juce::uint32) in.readInt() != fileMagic || in.readInt() != fileVersion)
+        return false;
+
+    // time, ppq, length, key, slot, note count, bass, chord type, root
+    constexpr int bytesPerChordWithoutNotes = 8 + 8 + 8 + 1 + 1 + 1 + 1 + 1 + 1;
+
+    const int numChords = in.readInt();
+    const double recordedSampleRate = in.readDouble();
+    if (numChords < 0 || in.getNumBytesRemaining() < (juce::int64) bytesPerChordWithoutNotes * numChords)
+        return false;
+
+    std::vector<RecordedChord> loaded;
+    loaded.reserve((size_t) numChords);
+
+    for (int i = 0; i < numChords; ++i)
+    {
+        if (in.getNumBytesRemaining() < bytesPerChordWithoutNotes)
+            return false;
+
+        RecordedChord chord;
+        chord.time = in.readInt64();
+        chord.ppq = in.readDouble();
+        chord.lengthSamples = in.readInt64();
+        chord.keyIndex = (juce::int8) in.readByte();
+        chord.slotIndex = (juce::int8) in.readByte();
+
+        auto& voicing = chord.voicing;
+        voicing.numNotes = (juce::uint8) in.readByte();
+        if (voicing.numNotes > Voicing::maxNotes || in.read(voicing.notes, voicing.numNotes) != voicing.numNotes
+            || in.getNumBytesRemaining() < 3)
+            return false;
+
+        voicing.bassNote = (juce::int8) in.readByte();
+        voicing.chordType = (juce::int8) in.readByte();
+        voicing.root = (juce::int8) in.readByte();
+
+        loaded.push_back(chord);
+    }
+
+    recording = false;
+
+    const juce::ScopedLock lock(progressionLock);
+    currentTake.fetch_add(1); // Anything still queued belongs to the replaced progression
+    chords = std::move(loaded);
+    chordsSampleRate = recordedSampleRate > 0.0 ? recordedSampleRate : sampleRate.load();
+    return true;
+}
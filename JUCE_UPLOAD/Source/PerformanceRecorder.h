@@ -0,0 +1,119 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <type_traits>
+#include <vector>
+#include "CommandQueue.h"
+#include "MemoryBank.h"
+#include "StateSerializer.h"
+#include "Voicing.h"
+
+struct EngineState;
+
+// One chord press, as the audio thread played it
+struct RecordedChord
+{
+    juce::int64 time = 0;             // Samples; engine time while queued, from the first chord once recorded
+    double ppq = -1.0;                // Host beat position, -1 if the host didn't give one
+    juce::int64 lengthSamples = 0;    // How long its notes were set to ring
+    juce::uint32 take = 0;            // Recording the press belongs to
+    juce::int8 keyIndex = 0;
+    juce::int8 slotIndex = 0;
+    Voicing voicing;
+};
+
+static_assert(std::is_trivially_copyable<RecordedChord>::value, "RecordedChords are queued as raw data");
+
+// A recorded chord progression. Shared with the audio thread for playback, so it's
+// never changed once handed out; the recorder builds a fresh copy instead.
+class RecordedProgression : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<RecordedProgression>;
+
+    std::vector<RecordedChord> chords;
+    double sampleRate = 44100.0;
+};
+
+//==============================================================================
+// Captures chord presses from the audio thread into a progression.
+//
+// The audio thread only copies each press into a preallocated lock-free queue. A
+// background thread drains that queue every few milliseconds into the growing
+// progression, so a session can be any length; the queue only has to cover the gap
+// between drains, and it holds thousands of presses.
+//
+// The last progression travels with the host project as an extra state chunk, can
+// be exported as a MIDI file, and can be stored alongside a memory bank.
+class PerformanceRecorder : public StateSerializer::ExtraChunk,
+                            private juce::Thread
+{
+public:
+    static constexpr int queueCapacity = 4096;
+
+    PerformanceRecorder();
+    ~PerformanceRecorder() override;
+
+    // Audio thread
+    bool isRecording() const noexcept { return recording.load(std::memory_order_relaxed); }
+    void record(juce::int64 engineTime, double ppq, int keyIndex, int slotIndex, const Voicing& voicing, juce::int64 lengthSamples) noexcept;
+
+    // Message thread. Starting a recording replaces the last progression; setupAtStart
+    // is what gets stored when the progression is saved to a memory bank.
+    void setSampleRate(double newSampleRate) noexcept { sampleRate = newSampleRate; }
+    void startRecording(const PerformanceSetup& setupAtStart);
+    void stopRecording();
+
+    // Message thread. A snapshot of the progression so far, safe to hand to the audio thread.
+    RecordedProgression::Ptr getProgression();
+    int getNumRecordedChords();
+    int getNumDropped() const noexcept { return numDropped.load(); }
+
+    // Message thread, before the progression is handed out. With smooth voicing on in state,
+    // re-voices the whole progression for the least total movement rather than press by press.
+    // Only chords state still has among its candidates change; the rest keep their notes.
+    static void applySmoothVoicing(RecordedProgression& progression, const EngineState& state);
+
+    // Chord notes on channel 1, bass on channel 2, at 960 ticks per quarter note. Host
+    // beat positions are used where they were recorded, otherwise times follow bpm.
+    static juce::MidiFile createMidiFile(const RecordedProgression& progression, double bpm);
+    bool exportToMidiFile(const juce::File& file, double bpm, const EngineState& state);
+
+    // A memory bank's progression sits next to the bank file
+    bool saveToMemoryBank(MemoryBank& bank, int bankIndex);
+    bool loadFromMemoryBank(const MemoryBank& bank, int bankIndex);
+
+    // Called on the message thread when a recording ends or a progression is loaded
+    std::function<void()> onProgressionChanged;
+
+    // StateSerializer::ExtraChunk - the last progression is saved with the host project
+    juce::uint32 getChunkId() const override { return StateSerializer::makeChunkId('P', 'R', 'O', 'G'); }
+    void writeChunk(juce::MemoryOutputStream& out) const override;
+    void readChunk(const void* data, size_t sizeInBytes) override;
+
+private:
+    // Moves everything queued so far into the progression. The lock keeps the queue's
+    // consumer side on one thread at a time.
+    void drainQueue();
+
+    void writeProgression(juce::OutputStream& out) const;
+    bool readProgression(juce::InputStream& in);
+
+    // juce::Thread
+    void run() override;
+
+    CommandQueue<RecordedChord, queueCapacity> queue;
+    std::atomic<bool> recording { false };
+    std::atomic<juce::uint32> currentTake { 0 };
+    std::atomic<int> numDropped { 0 };
+    std::atomic<double> sampleRate { 44100.0 };
+
+    juce::CriticalSection progressionLock;
+    std::vector<RecordedChord> chords;    // Guarded by progressionLock
+    double chordsSampleRate = 44100.0;    // Rate the chords' times are in (a loaded progression may differ)
+    juce::int64 firstChordTime = 0;
+    PerformanceSetup recordedSetup;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PerformanceRecorder)
+};
@@ -1,11 +1,16 @@
 #include "PianoKeyComponent.h"
+#include "MusicTheory.h"
 
 PianoKeyComponent::PianoKeyComponent(const juce::String& noteName, bool isBlackKey, bool isInScale)
     : juce::Button(noteName) // Use noteName for button name for accessibility/debugging
 {
-    currentNoteName = noteName;
+    slotLabels[0] = MusicTheory::ChordName(noteName.toRawUTF8());
     bIsBlackKey = isBlackKey;
     bIsInScale = isInScale;
+
+    for (int i = 0; i < MusicTheory::numPitchClasses; ++i)
+        if (noteName == MusicTheory::sharpNoteNames[i])
+            pitchClass = i;
 }
 
 PianoKeyComponent::~PianoKeyComponent()
@@ -14,9 +19,14 @@ PianoKeyComponent::~PianoKeyComponent()
 
 void PianoKeyComponent::setNoteName(const juce::String& newName)
 {
-    if (currentNoteName != newName)
+    setSlotLabel(0, MusicTheory::ChordName(newName.toRawUTF8()));
+}
+
+void PianoKeyComponent::setSlotLabel(int slotIndex, const MusicTheory::ChordName& newLabel)
+{
+    if (juce::isPositiveAndBelow(slotIndex, 3) && slotLabels[slotIndex] != newLabel)
     {
-        currentNoteName = newName;
+        slotLabels[slotIndex] = newLabel;
         repaint();
     }
 }
@@ -30,6 +40,43 @@ void PianoKeyComponent::setIsInScale(bool inScale)
     }
 }
 
+void PianoKeyComponent::setSlots(int newNumSlots, juce::uint8 disabledSlotBits)
+{
+    newNumSlots = juce::jlimit(1, 3, newNumSlots);
+    disabledSlotBits &= (juce::uint8) ((1 << newNumSlots) - 1); // Only the visible slots matter
+
+    if (numSlots != newNumSlots || disabledSlots != disabledSlotBits)
+    {
+        numSlots = newNumSlots;
+        disabledSlots = disabledSlotBits;
+        repaint();
+    }
+}
+
+int PianoKeyComponent::getSlotAt(int y) const
+{
+    if (getHeight() <= 0)
+        return 0;
+
+    return juce::jlimit(0, numSlots - 1, (y * numSlots) / getHeight());
+}
+
+void PianoKeyComponent::mouseDown(const juce::MouseEvent& e)
+{
+    juce::Button::mouseDown(e); // Keeps the pressed look
+
+    if (onPress != nullptr)
+        onPress(getSlotAt(e.getPosition().y), e.source.getIndex());
+}
+
+void PianoKeyComponent::mouseUp(const juce::MouseEvent& e)
+{
+    juce::Button::mouseUp(e);
+
+    if (onRelease != nullptr)
+        onRelease(e.source.getIndex());
+}
+
 void PianoKeyComponent::paintButton(juce::Graphics& g, bool isMouseOverButton, bool isButtonDown)
 {
     auto bounds = getLocalBounds().toFloat();
@@ -47,6 +94,32 @@ void PianoKeyComponent::paintButton(juce::Graphics& g, bool isMouseOverButton, b
     g.setColour(keyColour);
     g.fillRoundedRectangle(bounds, cornerRadius);
 
+    // Disabled slots: the whole key greys out when every visible slot is disabled,
+    // otherwise only the disabled sections do
+    const bool keyIsDisabled = disabledSlots == (juce::uint8) ((1 << numSlots) - 1);
+    if (keyIsDisabled)
+    {
+        g.setColour(getDisabledColour());
+        g.fillRoundedRectangle(bounds, cornerRadius);
+        g.setColour(getDisabledBorderColour());
+        g.drawRoundedRectangle(bounds.reduced(1.5f), cornerRadius, 3.0f);
+        return; // No chord name on a disabled key
+    }
+
+    if (disabledSlots != 0)
+    {
+        const float slotHeight = bounds.getHeight() / (float) numSlots;
+        g.saveState();
+        juce::Path keyShape;
+        keyShape.addRoundedRectangle(bounds, cornerRadius);
+        g.reduceClipRegion(keyShape);
+        g.setColour(getDisabledColour());
+        for (int slot = 0; slot < numSlots; ++slot)
+            if ((disabledSlots & (1 << slot)) != 0)
+                g.fillRect(bounds.withY(bounds.getY() + slotHeight * (float) slot).withHeight(slotHeight));
+        g.restoreState();
+    }
+
     // Border
     float borderThickness = 2.0f; // As per styles.keyInScale and styles.blackKey
     juce::Colour borderColour;
@@ -81,14 +154,22 @@ void PianoKeyComponent::paintButton(juce::Graphics& g, bool isMouseOverButton, b
     // color: colors.text (assuming this is white or a light color for visibility on dark keys)
     // For now, let's use white text. This might need to be configurable or adaptive.
     g.setColour(juce::Colours::white); 
-    g.setFont(juce::Font(fontSize)); // Default weight is normal (400)
 
     // Text alignment:
     // justifyContent: 'flex-end', alignItems: 'center', paddingBottom: 10
     // This means text is at the bottom, centered horizontally.
-    auto textBounds = getLocalBounds();
-    textBounds.removeFromTop(textBounds.getHeight() - fontSize - textPaddingBottom); // Position for bottom alignment
-    textBounds.reduce(0, textPaddingBottom); // Effectively handles paddingBottom
+    // With several slots each section gets its own label, laid out the same way
+    const auto keyBounds = getLocalBounds();
+    for (int slot = 0; slot < numSlots; ++slot)
+    {
+        if ((disabledSlots & (1 << slot)) != 0)
+            continue;
 
-    g.drawText(currentNoteName, textBounds, juce::Justification::centredBottom, false);
+        auto textBounds = keyBounds.withTrimmedTop((keyBounds.getHeight() * slot) / numSlots)
+                                   .withHeight(keyBounds.getHeight() / numSlots);
+        textBounds.removeFromTop(textBounds.getHeight() - (int) fontSize - textPaddingBottom); // Position for bottom alignment
+        textBounds.reduce(0, textPaddingBottom); // Effectively handles paddingBottom
+
+        glyphCache->draw(g, slotLabels[slot].getText(), labelFont, textBounds.toFloat(), juce::Justification::centredBottom);
+    }
 } 
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "MusicTheory.h"
+#include "GlyphCache.h"
 
 class PianoKeyComponent : public juce::Button
 {
@@ -10,24 +12,56 @@ public:
 
     void paintButton(juce::Graphics& g, bool isMouseOverButton, bool isButtonDown) override;
 
+    // Called as soon as a finger or the mouse goes down on the key, and again when it
+    // lifts. touchIndex tells simultaneous touches apart (the mouse is 0).
+    std::function<void(int slotIndex, int touchIndex)> onPress;
+    std::function<void(int touchIndex)> onRelease;
+
+    void mouseDown(const juce::MouseEvent& e) override;
+    void mouseUp(const juce::MouseEvent& e) override;
+
     void setNoteName(const juce::String& newName);
+
+    // Chord name shown in a slot's section; slot 0 is the same text as setNoteName().
+    // Only repaints if the name changed, and never allocates.
+    void setSlotLabel(int slotIndex, const MusicTheory::ChordName& newLabel);
     void setIsInScale(bool inScale);
 
+    // Pitch class of this key (C = 0), derived from the note name it was created with
+    int getPitchClass() const { return pitchClass; }
+
+    // Number of chord slots the key is split into (XL/XXL/XXXL) and which of them are
+    // disabled (bit 0 = slot 0). Disabled slots are drawn greyed out.
+    void setSlots(int numSlots, juce::uint8 disabledSlotBits);
+    int getNumSlots() const { return numSlots; }
+
+    // Slot under a y position in local coordinates, top slot = 0
+    int getSlotAt(int y) const;
+
     static juce::Colour getWhiteKeyColour() { return juce::Colour::fromString("#FF4A4A4A"); }
     static juce::Colour getBlackKeyColour() { return juce::Colour::fromString("#FF000000"); }
     static juce::Colour getInScaleBorderColour() { return juce::Colour::fromString("#FFFF9500"); }
     static juce::Colour getBlackKeyDefaultBorderColour() { return juce::Colour::fromString("#FF4A4A4A"); }
+    // rgba(64,64,64,0.75) fill / rgba(64,64,64,0.7) border from PianoXL.tsx
+    static juce::Colour getDisabledColour() { return juce::Colour::fromRGBA(64, 64, 64, 191); }
+    static juce::Colour getDisabledBorderColour() { return juce::Colour::fromRGBA(64, 64, 64, 179); }
 
 
 private:
-    juce::String currentNoteName;
+    MusicTheory::ChordName slotLabels[3];
     bool bIsBlackKey;
     bool bIsInScale;
+    int pitchClass = 0;
+    int numSlots = 1;
+    juce::uint8 disabledSlots = 0;
 
     const float cornerRadius = 15.0f;
     const int textPaddingBottom = 10;
     const float fontSize = 17.6f;
     // fontWeight 400 is normal. juce::Font default weight is normal.
+    const juce::Font labelFont { juce::FontOptions(fontSize) };
+
+    juce::SharedResourcePointer<GlyphCache> glyphCache; // Shared by every key, so each name is shaped once
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PianoKeyComponent)
 }; 
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include "PluginEditor.h"
+
+PianoXLAudioProcessorEditor::PianoXLAudioProcessorEditor(PianoXLAudioProcessor& processorToEdit)
+    : AudioProcessorEditor(processorToEdit),
+      mainComponent(processorToEdit)
+{
+    addAndMakeVisible(mainComponent);
+
+    // Landscape, as the preview app's window
+    setResizable(true, true);
+    setResizeLimits(844, 390, 844 * 3, 390 * 3);
+    setSize(844, 390);
+}
+
+PianoXLAudioProcessorEditor::~PianoXLAudioProcessorEditor() = default;
+
+void PianoXLAudioProcessorEditor::resized()
+{
+    mainComponent.setBounds(getLocalBounds());
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "MainComponent.h"
+
+//==============================================================================
+// Hosts MainComponent inside the plugin window. The processor owns all state, so
+// closing and reopening the editor doesn't lose anything.
+class PianoXLAudioProcessorEditor : public juce::AudioProcessorEditor
+{
+public:
+    explicit PianoXLAudioProcessorEditor(PianoXLAudioProcessor& processorToEdit);
+    ~PianoXLAudioProcessorEditor() override;
+
+    void resized() override;
+
+private:
+    MainComponent mainComponent;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PianoXLAudioProcessorEditor)
+};
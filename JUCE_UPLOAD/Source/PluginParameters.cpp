@@ -0,0 +1,149 @@
+#include "PluginParameters.h"
+#include "Flam.h"
+#include "Arpeggiator.h"
+
+namespace
+{
+    constexpr int parameterVersion = 1;
+    constexpr int hostPollIntervalMs = 30;
+
+    juce::AudioParameterFloatAttributes withUnit(const juce::String& unit)
+    {
+        return juce::AudioParameterFloatAttributes().withLabel(unit);
+    }
+}
+
+PluginParameters::PluginParameters(juce::AudioProcessor& processor, juce::ValueTree stateToMirror)
+    : state(stateToMirror)
+{
+    auto makeFloat = [](const char* id, const char* name, juce::NormalisableRange<float> range, const juce::var& value, const juce::String& unit) {
+        return std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { id, parameterVersion }, name, range,
+                                                           (float) (double) value, withUnit(unit));
+    };
+
+    // Ranges follow the reference: the fader's 9 snap points, +/-12 dB EQ, 10..200 % sustain, 0..500 ms sample start
+    auto faderParameter = makeFloat("fader", "Fader", { 0.0f, 1.0f, 0.125f }, state.getProperty(IDs::FADER_VALUE, 0.25), {});
+    auto eqLowParameter = makeFloat("eqLow", "EQ Low", { -12.0f, 12.0f, 0.1f }, state.getProperty(IDs::EQ_LOW, 0.0), "dB");
+    auto eqMidParameter = makeFloat("eqMid", "EQ Mid", { -12.0f, 12.0f, 0.1f }, state.getProperty(IDs::EQ_MID, 0.0), "dB");
+    auto eqHighParameter = makeFloat("eqHigh", "EQ High", { -12.0f, 12.0f, 0.1f }, state.getProperty(IDs::EQ_HIGH, 0.0), "dB");
+    auto sustainParameter = makeFloat("sustain", "Sustain", { 10.0f, 200.0f, 1.0f }, state.getProperty(IDs::SUSTAIN, 100.0), "%");
+    auto sampleStartParameter = makeFloat("sampleStart", "Sample Start", { 0.0f, 500.0f, 1.0f }, state.getProperty(IDs::SAMPLE_START, 0.0), "ms");
+    auto bpmParameter = makeFloat("bpm", "BPM", { 20.0f, 300.0f, 0.1f }, state.getProperty(IDs::BPM, 120.0), "BPM");
+    auto arpGateParameter = makeFloat("arpGate", "Arp Gate", { 10.0f, 100.0f, 1.0f }, state.getProperty(IDs::ARP_GATE, 50.0), "%");
+
+    auto makeChoice = [this](const char* id, const char* name, const char* const* options, int numOptions, const juce::Identifier& property, int defaultIndex) {
+        return std::make_unique<juce::AudioParameterChoice>(juce::ParameterID { id, parameterVersion }, name,
+                                                            juce::StringArray(options, numOptions),
+                                                            juce::jlimit(0, numOptions - 1, (int) state.getProperty(property, defaultIndex)));
+    };
+
+    auto flamParameter = makeChoice("flam", "Flam", Flam::optionNames, Flam::numOptions, IDs::FLAM_VALUE, 0);
+    auto arpModeParameter = makeChoice("arpMode", "Arp Mode", Arpeggiator::patternNames, Arpeggiator::numPatterns, IDs::ARP_MODE, 0);
+    auto arpRateParameter = makeChoice("arpRate", "Arp Rate", Arpeggiator::rateNames, Arpeggiator::numRates, IDs::ARP_RATE, 4);
+
+    fader = faderParameter.get();
+    eqLow = eqLowParameter.get();
+    eqMid = eqMidParameter.get();
+    eqHigh = eqHighParameter.get();
+    sustain = sustainParameter.get();
+    sampleStart = sampleStartParameter.get();
+    flam = flamParameter.get();
+    bpm = bpmParameter.get();
+    arpMode = arpModeParameter.get();
+    arpRate = arpRateParameter.get();
+    arpGate = arpGateParameter.get();
+
+    bindings.reserve(11);
+    addBinding(processor, std::move(faderParameter), IDs::FADER_VALUE);
+    addBinding(processor, std::move(eqLowParameter), IDs::EQ_LOW);
+    addBinding(processor, std::move(eqMidParameter), IDs::EQ_MID);
+    addBinding(processor, std::move(eqHighParameter), IDs::EQ_HIGH);
+    addBinding(processor, std::move(sustainParameter), IDs::SUSTAIN);
+    addBinding(processor, std::move(sampleStartParameter), IDs::SAMPLE_START);
+    addBinding(processor, std::move(flamParameter), IDs::FLAM_VALUE);
+    addBinding(processor, std::move(bpmParameter), IDs::BPM);
+    addBinding(processor, std::move(arpModeParameter), IDs::ARP_MODE);
+    addBinding(processor, std::move(arpRateParameter), IDs::ARP_RATE);
+    addBinding(processor, std::move(arpGateParameter), IDs::ARP_GATE);
+
+    state.addListener(this);
+    startTimer(hostPollIntervalMs);
+}
+
+PluginParameters::~PluginParameters()
+{
+    stopTimer();
+    state.removeListener(this);
+}
+
+void PluginParameters::addBinding(juce::AudioProcessor& processor, std::unique_ptr<juce::RangedAudioParameter> parameter, const juce::Identifier& property)
+{
+    Binding binding;
+    binding.parameter = parameter.get();
+    binding.property = property;
+    binding.lastSyncedValue = parameter->convertFrom0to1(parameter->getValue());
+
+    bindings.push_back(binding);
+    processor.addParameter(parameter.release()); // The processor owns its parameters
+}
+
+PluginParameters::Values PluginParameters::getValues() const noexcept
+{
+    Values values;
+    values.fader = fader->get();
+    values.eqLowDb = eqLow->get();
+    values.eqMidDb = eqMid->get();
+    values.eqHighDb = eqHigh->get();
+    values.sustainPercent = sustain->get();
+    values.sampleStartMs = sampleStart->get();
+    values.flam = flam->getIndex();
+    values.bpm = bpm->get();
+    values.arpMode = arpMode->getIndex();
+    values.arpRate = arpRate->getIndex();
+    values.arpGatePercent = arpGate->get();
+    return values;
+}
+
+void PluginParameters::valueTreePropertyChanged(juce::ValueTree& tree, const juce::Identifier& property)
+{
+    if (updatingState || tree != state)
+        return;
+
+    for (auto& binding : bindings)
+        if (binding.property == property)
+            pushToHost(binding);
+}
+
+void PluginParameters::pushToHost(Binding& binding)
+{
+    const float newValue = (float) (double) state.getProperty(binding.property);
+    const float current = binding.parameter->convertFrom0to1(binding.parameter->getValue());
+
+    binding.lastSyncedValue = newValue;
+    if (juce::approximatelyEqual(current, newValue))
+        return;
+
+    binding.parameter->beginChangeGesture();
+    binding.parameter->setValueNotifyingHost(binding.parameter->convertTo0to1(newValue));
+    binding.parameter->endChangeGesture();
+}
+
+void PluginParameters::pullFromHost()
+{
+    const juce::ScopedValueSetter<bool> setter(updatingState, true);
+
+    for (auto& binding : bindings)
+    {
+        const float hostValue = binding.parameter->convertFrom0to1(binding.parameter->getValue());
+        if (juce::approximatelyEqual(hostValue, binding.lastSyncedValue))
+            continue;
+
+        binding.lastSyncedValue = hostValue;
+
+        // Host automation isn't undoable; it would fill the history with every automation point
+        if (dynamic_cast<juce::AudioParameterChoice*>(binding.parameter) != nullptr)
+            state.setProperty(binding.property, juce::roundToInt(hostValue), nullptr);
+        else
+            state.setProperty(binding.property, (double) hostValue, nullptr);
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Identifiers.h"
+
+// Host-automatable parameters, each mirroring one appState property.
+//
+// appState stays the single source of truth for the UI, undo and snapshots:
+// - UI/undo changes to a bound property are pushed to the host as a change gesture.
+// - Host automation is picked up on the message thread by a timer and written
+//   into appState without an undo record.
+// The audio thread never touches either side's locks: getValues() only reads the
+// parameters' atomics.
+class PluginParameters : private juce::ValueTree::Listener,
+                         private juce::Timer
+{
+public:
+    // Plain values for one block, read on the audio thread
+    struct Values
+    {
+        float fader = 0.25f;       // 0..1, chord level; the bass gets 1 - fader
+        float eqLowDb = 0.0f;
+        float eqMidDb = 0.0f;
+        float eqHighDb = 0.0f;
+        float sustainPercent = 100.0f;
+        float sampleStartMs = 0.0f;
+        int flam = 0;              // Index into Flam::optionNames
+        float bpm = 120.0f;        // Used when the host doesn't send a tempo
+        int arpMode = 0;           // Index into Arpeggiator::patternNames
+        int arpRate = 4;           // Index into Arpeggiator::rateNames
+        float arpGatePercent = 50.0f;
+    };
+
+    // Creates the parameters and adds them to the processor
+    PluginParameters(juce::AudioProcessor& processor, juce::ValueTree stateToMirror);
+    ~PluginParameters() override;
+
+    // Audio thread, lock-free
+    Values getValues() const noexcept;
+
+private:
+    struct Binding
+    {
+        juce::RangedAudioParameter* parameter = nullptr;
+        juce::Identifier property;
+        float lastSyncedValue = 0.0f; // Plain (denormalised) value both sides last agreed on
+    };
+
+    void addBinding(juce::AudioProcessor& processor, std::unique_ptr<juce::RangedAudioParameter> parameter, const juce::Identifier& property);
+    void pushToHost(Binding& binding);
+    void pullFromHost();
+
+    // juce::Timer
+    void timerCallback() override { pullFromHost(); }
+
+    // ValueTree::Listener methods
+    void valueTreePropertyChanged(juce::ValueTree& tree, const juce::Identifier& property) override;
+    void valueTreeChildAdded(juce::ValueTree&, juce::ValueTree&) override {}
+    void valueTreeChildRemoved(juce::ValueTree&, juce::ValueTree&, int) override {}
+    void valueTreeChildOrderChanged(juce::ValueTree&, int, int) override {}
+    void valueTreeParentChanged(juce::ValueTree&) override {}
+
+    juce::ValueTree state;
+    std::vector<Binding> bindings;
+    bool updatingState = false;
+
+    juce::AudioParameterFloat* fader = nullptr;
+    juce::AudioParameterFloat* eqLow = nullptr;
+    juce::AudioParameterFloat* eqMid = nullptr;
+    juce::AudioParameterFloat* eqHigh = nullptr;
+    juce::AudioParameterFloat* sustain = nullptr;
+    juce::AudioParameterFloat* sampleStart = nullptr;
+    juce::AudioParameterChoice* flam = nullptr;
+    juce::AudioParameterFloat* bpm = nullptr;
+    juce::AudioParameterChoice* arpMode = nullptr;
+    juce::AudioParameterChoice* arpRate = nullptr;
+    juce::AudioParameterFloat* arpGate = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginParameters)
+};
@@ -0,0 +1,151 @@
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+#include "AppStateModel.h"
+#include "StartupProfiler.h"
+
+PianoXLAudioProcessor::PianoXLAudioProcessor(bool usePersistentState)
+    : AudioProcessor(BusesProperties().withOutput("Output", juce::AudioChannelSet::stereo(), true)),
+      autosaves(usePersistentState && wrapperType == wrapperType_Standalone),
+      appState(createInitialState(autosaves)),
+      memoryBank(usePersistentState ? MemoryBank::getDefaultFile() : juce::File())
+{
+    const StartupProfiler::Scope scope("Processor setup");
+
+    // Plugin instances would overwrite each other's file and pick up each other's sessions;
+    // their state is saved and restored by the host through get/setStateInformation
+    if (autosaves)
+        autosaver = std::make_unique<StateAutosaver>(stateSnapshot, StateAutosaver::getDefaultFile());
+
+    // Memory banks live only in their own mapped file, shared by every instance; the last
+    // recorded progression travels with state snapshots
+    stateSnapshot.addExtraChunk(&recorder);
+    recorder.onProgressionChanged = [this] { stateSnapshot.markDirty(); };
+    chordEngine.setRecorder(&recorder);
+    chordEngine.setAttackCache(&attackCache);
+    chordEngine.setTuning(&tuning);
+
+    // Nothing needs the banks to draw the first frame; anything that does sooner maps them itself
+    deferredInitialiser.addTask("Map memory banks", DeferredInitialiser::Priority::high, [this] { memoryBank.load(); });
+    deferredInitialiser.onFinished = [] { StartupProfiler::writeTraceOnce(); };
+}
+
+PianoXLAudioProcessor::~PianoXLAudioProcessor()
+{
+    autosaver.reset(); // Writes any pending change while the extra chunks are still registered
+    stateSnapshot.removeExtraChunk(&recorder);
+}
+
+juce::ValueTree PianoXLAudioProcessor::createInitialState(bool loadAutosave)
+{
+    const StartupProfiler::Scope scope("Load autosaved state");
+
+    juce::ValueTree state;
+    if (loadAutosave)
+        state = StateAutosaver::loadFromFile(StateAutosaver::getDefaultFile());
+
+    if (!state.isValid())
+        state = juce::ValueTree(IDs::APP_STATE);
+
+    AppStateModel::ensureDefaults(state, nullptr);
+    return state;
+}
+
+//==============================================================================
+void PianoXLAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
+{
+    recorder.setSampleRate(sampleRate);
+    chordEngine.prepare(sampleRate, samplesPerBlock);
+
+    masterLimiter.prepare(sampleRate, samplesPerBlock, getTotalNumOutputChannels());
+    setLatencySamples(masterLimiter.getLatencySamples());
+
+    levelMeter.prepare(sampleRate);
+}
+
+void PianoXLAudioProcessor::releaseResources()
+{
+    chordEngine.reset();
+    masterLimiter.reset();
+    levelMeter.reset();
+}
+
+bool PianoXLAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
+{
+    const auto& output = layouts.getMainOutputChannelSet();
+    return output == juce::AudioChannelSet::mono() || output == juce::AudioChannelSet::stereo();
+}
+
+void PianoXLAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    // Arps and flams lock to the host's tempo and beat position when it has them
+    ChordEngine::Transport transport;
+    if (auto* playHead = getPlayHead())
+    {
+        if (const auto position = playHead->getPosition())
+        {
+            transport.bpm = position->getBpm().orFallback(0.0);
+            transport.isPlaying = position->getIsPlaying();
+
+            if (const auto ppq = position->getPpqPosition())
+            {
+                transport.hasPpqPosition = true;
+                transport.ppqPosition = *ppq;
+            }
+        }
+    }
+
+    const auto& state = engineStateBridge.getLatestState();
+
+    buffer.clear();
+    chordEngine.process(buffer, midiMessages, state, parameters.getValues(), transport);
+    masterLimiter.process(buffer, state.softClip != 0);
+    levelMeter.process(buffer);
+}
+
+//==============================================================================
+juce::AudioProcessorEditor* PianoXLAudioProcessor::createEditor()
+{
+    const StartupProfiler::Scope scope("Create editor");
+    return new PianoXLAudioProcessorEditor(*this);
+}
+
+void PianoXLAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
+{
+    stateSnapshot.copySnapshotTo(destData);
+}
+
+void PianoXLAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
+{
+    juce::MemoryBlock copy(data, (size_t) juce::jmax(0, sizeInBytes));
+
+    // The tree belongs to the message thread; some hosts restore from elsewhere
+    if (juce::MessageManager::getInstance()->isThisTheMessageThread())
+    {
+        restoreState(copy);
+    }
+    else
+    {
+        juce::MessageManager::callAsync([safeThis = juce::WeakReference<PianoXLAudioProcessor>(this), copy] {
+            if (auto* processor = safeThis.get())
+                processor->restoreState(copy);
+        });
+    }
+}
+
+void PianoXLAudioProcessor::restoreState(const juce::MemoryBlock& data)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (stateSnapshot.restoreFrom(data.getData(), data.getSize()))
+        undoManager.clearUndoHistory(); // Loading a session isn't something to undo
+}
+
+//==============================================================================
+// This creates new instances of the plugin
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    const StartupProfiler::Scope scope("Create processor");
+    return new PianoXLAudioProcessor();
+}
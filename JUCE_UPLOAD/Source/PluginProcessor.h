@@ -0,0 +1,100 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Identifiers.h"
+#include "StateSerializer.h"
+#include "StateAutosaver.h"
+#include "MemoryBank.h"
+#include "PerformanceRecorder.h"
+#include "StateUndoManager.h"
+#include "EngineStateBridge.h"
+#include "TuningManager.h"
+#include "AttackCache.h"
+#include "ChordEngine.h"
+#include "PluginParameters.h"
+#include "MasterLimiter.h"
+#include "LevelMeter.h"
+#include "DeferredInitialiser.h"
+
+//==============================================================================
+// The one AudioProcessor shared by the VST3, LV2 and Standalone builds (and the
+// headless test host). It owns the app state and everything hanging off it; the
+// editor only holds references.
+class PianoXLAudioProcessor : public juce::AudioProcessor
+{
+public:
+    // usePersistentState = false keeps the processor away from the autosave and memory
+    // bank files in the user's app data, for the headless host. Only the Standalone app
+    // autosaves; plugin instances keep their state in the host's project.
+    explicit PianoXLAudioProcessor(bool usePersistentState = true);
+    ~PianoXLAudioProcessor() override;
+
+    //==============================================================================
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    using AudioProcessor::processBlock;
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override { return true; }
+
+    const juce::String getName() const override { return JucePlugin_Name; }
+    bool acceptsMidi() const override { return true; }
+    bool producesMidi() const override { return true; }
+    bool isMidiEffect() const override { return false; }
+    double getTailLengthSeconds() const override { return 0.0; }
+
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int) override {}
+    const juce::String getProgramName(int) override { return {}; }
+    void changeProgramName(int, const juce::String&) override {}
+
+    // Host state uses the same binary snapshot as the autosave file
+    void getStateInformation(juce::MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+    //==============================================================================
+    juce::ValueTree& getAppState() { return appState; }
+    StateUndoManager& getUndoManager() { return undoManager; }
+    StateSnapshotCache& getStateSnapshot() { return stateSnapshot; }
+    MemoryBank& getMemoryBank() { return memoryBank; }
+    EngineStateBridge& getEngineStateBridge() { return engineStateBridge; }
+    ChordEngine& getChordEngine() { return chordEngine; }
+    PerformanceRecorder& getRecorder() { return recorder; }
+    AttackCache& getAttackCache() { return attackCache; }
+    TuningManager& getTuning() { return tuning; }
+    LevelMeter& getLevelMeter() { return levelMeter; }
+    DeferredInitialiser& getDeferredInitialiser() { return deferredInitialiser; }
+
+private:
+    // Loads the last autosaved state (if any) and fills in defaults
+    static juce::ValueTree createInitialState(bool loadAutosave);
+
+    // Message thread only
+    void restoreState(const juce::MemoryBlock& data);
+
+    // State members are declared first so they're constructed before anything that uses them
+    const bool autosaves; // Standalone only: the file is one per user, not per instance
+    StateUndoManager undoManager;
+    juce::ValueTree appState;
+    StateSnapshotCache stateSnapshot { appState };
+    std::unique_ptr<StateAutosaver> autosaver;
+    MemoryBank memoryBank;
+    EngineStateBridge engineStateBridge { appState };
+    PluginParameters parameters { *this, appState };
+
+    PerformanceRecorder recorder; // Outlives the engine that records into it
+    TuningManager tuning { appState };
+    AttackCache attackCache { engineStateBridge, tuning };
+    ChordEngine chordEngine;
+    MasterLimiter masterLimiter;
+    LevelMeter levelMeter; // Meters what the limiter lets out
+
+    DeferredInitialiser deferredInitialiser; // Last, so its tasks stop before anything they load into goes
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(PianoXLAudioProcessor)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PianoXLAudioProcessor)
+};
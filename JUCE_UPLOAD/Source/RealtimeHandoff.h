@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Hands reference-counted objects from the message thread to the audio thread, without
+// the audio thread ever blocking, allocating or freeing one.
+//
+// publish() keeps its own reference to every object it hands over, so when the audio
+// thread swaps in a new one the old one is never the last reference and nothing is freed
+// there. releaseUnused() drops the objects only this class still holds; call it on the
+// message thread, from a timer or before the next publish().
+//
+// The pending object sits behind a SpinLock the audio thread only ever try-locks: if the
+// message thread is mid-publish, tryTake() simply finds nothing and picks it up next block.
+template <typename ObjectType>
+class RealtimeHandoff
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<ObjectType>;
+
+    RealtimeHandoff() = default;
+
+    // Message thread. object (which may be null) is what the next tryTake() gets.
+    void publish(Ptr object)
+    {
+        if (object != nullptr)
+            retained.addIfNotAlreadyThere(object.get());
+
+        const juce::SpinLock::ScopedLockType lock(pendingLock);
+        pending = std::move(object);
+        hasPending = true;
+    }
+
+    // Audio thread. Swaps the last published object into current and returns true, if one
+    // is waiting.
+    bool tryTake(Ptr& current) noexcept
+    {
+        const juce::SpinLock::ScopedTryLockType lock(pendingLock);
+        if (!lock.isLocked() || !hasPending)
+            return false;
+
+        current = pending;
+        pending = nullptr;
+        hasPending = false;
+        return true;
+    }
+
+    // Message thread. Frees the objects the audio thread has let go of; true if there were any.
+    bool releaseUnused()
+    {
+        bool released = false;
+        for (int i = retained.size(); --i >= 0;)
+        {
+            if (retained.getObjectPointerUnchecked(i)->getReferenceCount() == 1)
+            {
+                retained.remove(i);
+                released = true;
+            }
+        }
+
+        return released;
+    }
+
+    // Message thread, once the audio thread has stopped. Lets go of everything.
+    void clear()
+    {
+        {
+            const juce::SpinLock::ScopedLockType lock(pendingLock);
+            pending = nullptr;
+            hasPending = false;
+        }
+
+        retained.clear();
+    }
+
+    // Message thread. Every object the audio thread might still hold.
+    const juce::ReferenceCountedArray<ObjectType>& getRetained() const noexcept { return retained; }
+
+private:
+    juce::SpinLock pendingLock;
+    Ptr pending;
+    bool hasPending = false;
+    juce::ReferenceCountedArray<ObjectType> retained;
+
+    JUCE_DECLARE_NON_COPYABLE(RealtimeHandoff)
+};
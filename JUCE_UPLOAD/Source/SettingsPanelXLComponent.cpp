@@ -1,10 +1,14 @@
 #include "SettingsPanelXLComponent.h"
+#include "StartupProfiler.h"
 #include <iostream>
 
 // Constructor updated to take ValueTree
-SettingsPanelXLComponent::SettingsPanelXLComponent(juce::ValueTree applicationState)
-    : appState(applicationState) // Store the ValueTree
+SettingsPanelXLComponent::SettingsPanelXLComponent(juce::ValueTree applicationState, StateUndoManager* undoManagerToUse)
+    : appState(applicationState), // Store the ValueTree
+      undoManager(undoManagerToUse)
 {
+    const StartupProfiler::Scope scope("Settings panel");
+
     // Add this component as a listener to the appState ValueTree
     appState.addListener(this);
 
@@ -23,10 +27,17 @@ SettingsPanelXLComponent::SettingsPanelXLComponent(juce::ValueTree applicationSt
     addAndMakeVisible(memoryButton);
     memoryButton.setBackgroundColour(buttonColor);
     memoryButton.setBorderColour(buttonBorder);
+    memoryButton.onClick = [this] {
+        listeners.call([this](Listener& l) { l.memoryButtonClicked(memoryButton); });
+    };
 
     addAndMakeVisible(disableButton);
     disableButton.setBackgroundColour(buttonColor);
     disableButton.setBorderColour(buttonBorder);
+    disableButton.onClick = [this] { // While selected, key presses toggle disable state
+        recordSelection("disable");
+        toggleSelection("disable");
+    };
 
     addAndMakeVisible(bassOffsetButton);
     bassOffsetButton.setBackgroundColour(buttonColor);
@@ -39,8 +50,9 @@ SettingsPanelXLComponent::SettingsPanelXLComponent(juce::ValueTree applicationSt
 
     modeSelector.setLookAndFeel(&customLookAndFeel);
     addAndMakeVisible(modeSelector);
-    modeSelector.addItem("FREE", 1);
-    modeSelector.setSelectedId(1);
+    for (int i = 0; i < MusicTheory::numModes; ++i)
+        modeSelector.addItem(MusicTheory::getModeName(i), i + 1); // Item id = SELECTED_MODE + 1
+    modeSelector.setSelectedId((int) appState.getProperty(IDs::SELECTED_MODE, 0) + 1, juce::dontSendNotification);
     modeSelector.addListener(this);
     modeSelector.getProperties().set("isSelected", false);
 
@@ -88,10 +100,9 @@ SettingsPanelXLComponent::SettingsPanelXLComponent(juce::ValueTree applicationSt
     chordLabel.setJustificationType(juce::Justification::centred);
 
     addAndMakeVisible(chordDisplay);
-    chordDisplay.setText("C#", juce::dontSendNotification);
+    chordDisplay.setChordName(MusicTheory::ChordName("C#"));
     chordDisplay.setFont(chordDisplayFont);
-    chordDisplay.setColour(juce::Label::textColourId, textColor);
-    chordDisplay.setJustificationType(juce::Justification::centred);
+    chordDisplay.setTextColour(textColor);
 
     createSelectableContainer(keyLabel, keyValueLabel, "key");
     createSelectableContainer(octaveLabel, octaveValueLabel, "octave");
@@ -108,6 +119,7 @@ SettingsPanelXLComponent::SettingsPanelXLComponent(juce::ValueTree applicationSt
     if (appState.isValid()) {
         valueTreePropertyChanged(appState, IDs::INVERSION_SELECTED);
         valueTreePropertyChanged(appState, IDs::INVERSION_VALUE);
+        updateKeyAndOctaveLabels();
     }
 }
 
@@ -138,13 +150,13 @@ void SettingsPanelXLComponent::setSelectedControl(const juce::String& control)
         // If the new selection is "inversion", ensure ValueTree reflects this.
         if (control == "inversion") {
             if (!(bool)appState.getProperty(IDs::INVERSION_SELECTED, false)) {
-                appState.setProperty(IDs::INVERSION_SELECTED, true, nullptr);
+                setStateProperty(IDs::INVERSION_SELECTED, true);
             }
         }
         // If "inversion" was previously selected, and now something else is, deselect inversion in ValueTree.
         else if (oldSelectedControl == "inversion") {
             if ((bool)appState.getProperty(IDs::INVERSION_SELECTED, false)) {
-                appState.setProperty(IDs::INVERSION_SELECTED, false, nullptr);
+                setStateProperty(IDs::INVERSION_SELECTED, false);
             }
         }
         // Note: valueTreePropertyChanged will handle visual updates for inversion labels.
@@ -163,18 +175,18 @@ void SettingsPanelXLComponent::toggleSelection(const juce::String& control)
     {
         selectedControl = ""; // Deselect it (UI tracking)
         if (control == "inversion") {
-            appState.setProperty(IDs::INVERSION_SELECTED, false, nullptr); // Update ValueTree
+            setStateProperty(IDs::INVERSION_SELECTED, false); // Update ValueTree
         }
     }
     else // Clicking a new control
     {
         selectedControl = control; // Select it (UI tracking)
         if (control == "inversion") {
-            appState.setProperty(IDs::INVERSION_SELECTED, true, nullptr); // Update ValueTree
+            setStateProperty(IDs::INVERSION_SELECTED, true); // Update ValueTree
         } else {
             // If a non-inversion control is selected, ensure inversion is marked as not selected in ValueTree
             if ((bool)appState.getProperty(IDs::INVERSION_SELECTED, false)) {
-                appState.setProperty(IDs::INVERSION_SELECTED, false, nullptr);
+                setStateProperty(IDs::INVERSION_SELECTED, false);
             }
         }
     }
@@ -183,7 +195,7 @@ void SettingsPanelXLComponent::toggleSelection(const juce::String& control)
     // ensure its ValueTree state is false, unless the current selection IS "inversion".
     if (previouslySelectedControl == "inversion" && selectedControl != "inversion") {
         if ((bool)appState.getProperty(IDs::INVERSION_SELECTED, false)) {
-             appState.setProperty(IDs::INVERSION_SELECTED, false, nullptr);
+             setStateProperty(IDs::INVERSION_SELECTED, false);
         }
     }
 
@@ -217,6 +229,11 @@ void SettingsPanelXLComponent::toggleSelection(const juce::String& control)
     modeSelector.getProperties().set("isSelected", selectedControl == "mode");
     modeSelector.repaint();
 
+    const bool disableEditActive = selectedControl == "disable";
+    disableButton.setBorderColour(disableEditActive ? selectedBorder : buttonBorder);
+    if (disableEditActive != (previouslySelectedControl == "disable"))
+        listeners.call([disableEditActive](Listener& l) { l.disableEditChanged(disableEditActive); });
+
     std::cout << "Selected control (UI): " << (selectedControl.isEmpty() ? "none" : selectedControl) << std::endl;
 }
 
@@ -227,10 +244,18 @@ void SettingsPanelXLComponent::setInversionValue(int newValue)
     if (!appState.isValid()) return;
     if ((int)appState.getProperty(IDs::INVERSION_VALUE, 0) != newValue)
     {
-        appState.setProperty(IDs::INVERSION_VALUE, newValue, nullptr);
+        setStateProperty(IDs::INVERSION_VALUE, newValue);
     }
 }
 
+void SettingsPanelXLComponent::setStateProperty(const juce::Identifier& property, const juce::var& newValue)
+{
+    if (undoManager != nullptr)
+        undoManager->beginGesture(property);
+
+    appState.setProperty(property, newValue, undoManager);
+}
+
 // valueTreePropertyChanged implementation
 void SettingsPanelXLComponent::valueTreePropertyChanged(juce::ValueTree& treeWhosePropertyHasChanged, const juce::Identifier& property)
 {
@@ -241,9 +266,21 @@ void SettingsPanelXLComponent::valueTreePropertyChanged(juce::ValueTree& treeWho
             bool isSelectedFromState = appState.getProperty(IDs::INVERSION_SELECTED, false);
             int val = appState.getProperty(IDs::INVERSION_VALUE, 0);
 
-            // Update visual state for inversion labels
-            // Visual selection should depend on BOTH appState's INVERSION_SELECTED AND internal `selectedControl`
-            bool showVisualSelection = isSelectedFromState && (selectedControl == "inversion");
+            // appState is authoritative (the change may come from undo/redo or a restored snapshot),
+            // so bring the internal selectedControl in line with it
+            if (isSelectedFromState)
+            {
+                if (selectedControl == "disable")
+                {
+                    disableButton.setBorderColour(buttonBorder);
+                    listeners.call([](Listener& l) { l.disableEditChanged(false); });
+                }
+                selectedControl = "inversion";
+            }
+            else if (selectedControl == "inversion")
+                selectedControl = "";
+
+            bool showVisualSelection = isSelectedFromState;
 
             inversionLabel.setColour(juce::Label::backgroundColourId, buttonColor);
             inversionValueLabel.setColour(juce::Label::backgroundColourId, buttonColor);
@@ -273,7 +310,7 @@ void SettingsPanelXLComponent::valueTreePropertyChanged(juce::ValueTree& treeWho
         else if (property == IDs::INVERSION_VALUE)
         {
             int newValue = appState.getProperty(IDs::INVERSION_VALUE, 0);
-            inversionValueLabel.setText(juce::String(newValue), juce::dontSendNotification);
+            updateInversionValueLabel();
 
             bool isSelectedFromState = appState.getProperty(IDs::INVERSION_SELECTED, false);
             if (isSelectedFromState)
@@ -282,9 +319,37 @@ void SettingsPanelXLComponent::valueTreePropertyChanged(juce::ValueTree& treeWho
             }
             std::cout << "VT: INVERSION_VALUE changed to: " << newValue << std::endl;
         }
+        else if (property == IDs::SELECTED_KEY || property == IDs::SELECTED_OCTAVE || property == IDs::USE_FLATS)
+        {
+            updateKeyAndOctaveLabels();
+        }
+        else if (property == IDs::SMOOTH_VOICING)
+        {
+            updateInversionValueLabel();
+        }
+        else if (property == IDs::SELECTED_MODE)
+        {
+            modeSelector.setSelectedId((int) appState.getProperty(IDs::SELECTED_MODE, 0) + 1, juce::dontSendNotification);
+        }
     }
 }
 
+void SettingsPanelXLComponent::updateInversionValueLabel()
+{
+    // In smooth voicing the inversion is picked per chord, so there's no single value to show
+    const bool smooth = appState.getProperty(IDs::SMOOTH_VOICING, false);
+    inversionValueLabel.setText(smooth ? juce::String("AUTO") : juce::String((int) appState.getProperty(IDs::INVERSION_VALUE, 0)),
+                                juce::dontSendNotification);
+}
+
+void SettingsPanelXLComponent::updateKeyAndOctaveLabels()
+{
+    const int key = appState.getProperty(IDs::SELECTED_KEY, 0);
+    const bool useFlats = appState.getProperty(IDs::USE_FLATS, false);
+    keyValueLabel.setText(MusicTheory::getNoteName(key, useFlats), juce::dontSendNotification);
+    octaveValueLabel.setText(juce::String((int) appState.getProperty(IDs::SELECTED_OCTAVE, 0)), juce::dontSendNotification);
+}
+
 void SettingsPanelXLComponent::mouseDown(const juce::MouseEvent& event)
 {
     auto* clickedComponent = event.eventComponent;
@@ -302,6 +367,7 @@ void SettingsPanelXLComponent::mouseDown(const juce::MouseEvent& event)
         
         if (controlName.isNotEmpty())
         {
+            recordSelection(controlName);
             toggleSelection(controlName);
         }
     }
@@ -311,10 +377,44 @@ void SettingsPanelXLComponent::comboBoxChanged(juce::ComboBox* comboBoxThatHasCh
 {
     if (comboBoxThatHasChanged == &modeSelector)
     {
+        const int newMode = modeSelector.getSelectedId() - 1;
+
+        if (inputTrace != nullptr)
+        {
+            InputEvent event { 0.0, InputEvent::Type::selectMode };
+            event.code = newMode;
+            inputTrace->record(event);
+        }
+
+        if (newMode >= 0 && newMode != (int) appState.getProperty(IDs::SELECTED_MODE, 0))
+            setStateProperty(IDs::SELECTED_MODE, newMode);
+
         toggleSelection("mode");
     }
 }
 
+void SettingsPanelXLComponent::recordSelection(const juce::String& control)
+{
+    if (inputTrace == nullptr)
+        return;
+
+    InputEvent event { 0.0, InputEvent::Type::selectControl };
+    event.code = InputTrace::getControlIndex(control);
+    inputTrace->record(event);
+}
+
+void SettingsPanelXLComponent::replayInput(const InputEvent& event)
+{
+    if (event.type == InputEvent::Type::selectControl && juce::isPositiveAndBelow(event.code, InputTrace::numControls))
+    {
+        toggleSelection(InputTrace::controlNames[event.code]);
+    }
+    else if (event.type == InputEvent::Type::selectMode)
+    {
+        modeSelector.setSelectedId(event.code + 1, juce::sendNotificationSync);
+    }
+}
+
 void SettingsPanelXLComponent::createSelectableContainer(juce::Label& label, juce::Label& value, const juce::String& controlName)
 {
     label.setMouseCursor(juce::MouseCursor::PointingHandCursor);
@@ -4,6 +4,10 @@
 #include "IconButton.h"
 #include "Identifiers.h" // Include the new identifiers
 #include "CustomLookAndFeel.h"
+#include "MusicTheory.h"
+#include "StateUndoManager.h"
+#include "InputTrace.h"
+#include "ChordDisplayComponent.h"
 
 class SettingsPanelXLComponent : public juce::Component,
                                 private juce::ComboBox::Listener, // For modeSelector
@@ -16,12 +20,14 @@ public:
     public:
         virtual ~Listener() = default;
         virtual void inversionSelectionChanged(bool isSelected, int value) = 0;
+        virtual void memoryButtonClicked(juce::Component& /*button*/) {}
+        virtual void disableEditChanged(bool /*isActive*/) {}
     };
 
     void addListener(Listener* l) { listeners.add(l); }
     void removeListener(Listener* l) { listeners.remove(l); }
 
-    SettingsPanelXLComponent(juce::ValueTree applicationState); // Modified constructor
+    SettingsPanelXLComponent(juce::ValueTree applicationState, StateUndoManager* undoManagerToUse = nullptr);
     ~SettingsPanelXLComponent() override;
 
     void paint(juce::Graphics& g) override;
@@ -38,6 +44,14 @@ public:
     // Method to get current inversion value (mainly for MainComponent's initial query if needed)
     int getInversionValue() const;
 
+    // Name of the last chord played, shown in the chord display
+    void setChordDisplayName(const MusicTheory::ChordName& chordName) { chordDisplay.setChordName(chordName); }
+
+    // Control selections and mode changes go into the trace while it's recording;
+    // replayInput plays back the selectControl and selectMode events
+    void setInputTrace(InputTrace* traceToUse) { inputTrace = traceToUse; }
+    void replayInput(const InputEvent& event);
+
 private:
     // ComboBox::Listener
     void comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged) override;
@@ -55,6 +69,13 @@ private:
     const juce::Colour selectedBorder = juce::Colour::fromFloatRGBA(0.4f, 0.4f, 0.4f, 0.8f);
     
     juce::ValueTree appState; // Reference to the application state
+    StateUndoManager* undoManager = nullptr; // Every change made from the panel goes through this
+    InputTrace* inputTrace = nullptr;
+
+    void recordSelection(const juce::String& control);
+
+    // Sets a property on appState as part of an undoable gesture
+    void setStateProperty(const juce::Identifier& property, const juce::var& newValue);
 
     // Track which control is currently selected (internal UI state, not directly in ValueTree for now)
     juce::String selectedControl;
@@ -72,6 +93,12 @@ private:
     // Helper method to toggle selection
     void toggleSelection(const juce::String& control);
 
+    // Refreshes the KEY / OCT value labels from appState
+    void updateKeyAndOctaveLabels();
+
+    // INV value label: the inversion, or AUTO while smooth voicing is on
+    void updateInversionValueLabel();
+
     // ValueTree::Listener methods
     void valueTreePropertyChanged(juce::ValueTree& treeWhosePropertyHasChanged, const juce::Identifier& property) override;
     void valueTreeChildAdded (juce::ValueTree&, juce::ValueTree&) override {}
@@ -104,7 +131,7 @@ private:
     juce::Label inversionLabel;           // "INV" text
     juce::Label inversionValueLabel;      // "0" value
     juce::Label chordLabel;               // "CHORD" text
-    juce::Label chordDisplay;             // "C#" value
+    ChordDisplayComponent chordDisplay;   // "C#" value
     
     // Fonts and text properties
     const juce::Font displayFont { "Arial", 24.0f, juce::Font::plain };
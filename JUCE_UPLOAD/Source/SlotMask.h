@@ -0,0 +1,39 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AppStateModel.h"
+
+// Key/slot disable state packed into a single 36-bit mask (12 keys x 3 slots, key-major,
+// same order as AppStateModel::getFlatSlotIndex). Checking a press is one AND.
+namespace SlotMask
+{
+    using Mask = juce::uint64;
+
+    constexpr int numBits = AppStateModel::numSlots;
+    constexpr Mask allSlots = (Mask (1) << numBits) - 1;
+
+    constexpr Mask bitFor(int keyIndex, int slotIndex) noexcept
+    {
+        return Mask (1) << AppStateModel::getFlatSlotIndex(keyIndex, slotIndex);
+    }
+
+    // All slots belonging to one key
+    constexpr Mask bitsForKey(int keyIndex) noexcept
+    {
+        return ((Mask (1) << AppStateModel::maxSlotsPerKey) - 1) << (keyIndex * AppStateModel::maxSlotsPerKey);
+    }
+
+    constexpr bool isDisabled(Mask mask, int keyIndex, int slotIndex) noexcept
+    {
+        return (mask & bitFor(keyIndex, slotIndex)) != 0;
+    }
+
+    // The slot bits of one key, shifted down so bit 0 = slot 0
+    constexpr juce::uint8 getKeyBits(Mask mask, int keyIndex) noexcept
+    {
+        return (juce::uint8) ((mask >> (keyIndex * AppStateModel::maxSlotsPerKey)) & ((1u << AppStateModel::maxSlotsPerKey) - 1));
+    }
+
+    inline Mask fromVar(const juce::var& value) { return (Mask) (juce::int64) value & allSlots; }
+    inline juce::var toVar(Mask mask)             { return (juce::int64) (mask & allSlots); }
+}
@@ -0,0 +1,221 @@
+#include "SmfReader.h"
+#include <algorithm>
+#include <array>
+
+namespace SmfReader
+{
+    namespace
+    {
+        constexpr int numChannels = 16;
+        constexpr int numNoteNumbers = 128;
+
+        // Bounds-checked reading over the file's bytes; running off the end just sets failed
+        struct Cursor
+        {
+            const juce::uint8* data;
+            size_t position, end;
+            bool failed = false;
+
+            bool isAtEnd() const noexcept { return position >= end; }
+
+            int readByte() noexcept
+            {
+                if (position >= end)
+                {
+                    failed = true;
+                    return 0;
+                }
+
+                return data[position++];
+            }
+
+            juce::uint32 readBigEndian(int numBytes) noexcept
+            {
+                juce::uint32 value = 0;
+                for (int i = 0; i < numBytes; ++i)
+                    value = (value << 8) | (juce::uint32) readByte();
+
+                return value;
+            }
+
+            // Variable-length quantity: seven bits a byte, at most four bytes
+            juce::uint32 readVariableLength() noexcept
+            {
+                juce::uint32 value = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    const int byte = readByte();
+                    value = (value << 7) | (juce::uint32) (byte & 0x7f);
+                    if ((byte & 0x80) == 0)
+                        return value;
+                }
+
+                failed = true;
+                return value;
+            }
+
+            void skip(size_t numBytes) noexcept
+            {
+                if (numBytes > end - position)
+                {
+                    failed = true;
+                    position = end;
+                    return;
+                }
+
+                position += numBytes;
+            }
+        };
+
+        bool hasChunkId(const Cursor& cursor, const char* id) noexcept
+        {
+            return cursor.end - cursor.position >= 4 && std::memcmp(cursor.data + cursor.position, id, 4) == 0;
+        }
+
+        // Reads one track whose first event is at startTick; returns the tick it ends on
+        juce::int64 readTrack(Cursor track, juce::int64 startTick, std::vector<Note>& notes)
+        {
+            // Start tick of each channel's sounding notes, -1 where none is
+            std::array<juce::int64, numChannels * numNoteNumbers> starts;
+            std::array<juce::uint8, numChannels * numNoteNumbers> velocities;
+            starts.fill(-1);
+
+            juce::int64 tick = startTick;
+            int runningStatus = 0;
+
+            auto endNote = [&](int index) {
+                const auto start = starts[(size_t) index];
+                if (start < 0)
+                    return;
+
+                Note note;
+                note.start = start;
+                note.end = juce::jmax(start + 1, tick);
+                note.note = (juce::uint8) (index % numNoteNumbers);
+                note.velocity = velocities[(size_t) index];
+                note.channel = (juce::uint8) (index / numNoteNumbers);
+                notes.push_back(note);
+                starts[(size_t) index] = -1;
+            };
+
+            while (!track.isAtEnd() && !track.failed)
+            {
+                tick += track.readVariableLength();
+
+                int status = track.readByte();
+                if (status < 0x80)
+                {
+                    if (runningStatus == 0)
+                        break; // Data with no status to run on: the rest can't be trusted
+
+                    --track.position; // That was the first data byte
+                    status = runningStatus;
+                }
+
+                if (status == 0xff)
+                {
+                    const int type = track.readByte();
+                    track.skip(track.readVariableLength());
+                    if (type == 0x2f)
+                        break; // End of track
+                }
+                else if (status == 0xf0 || status == 0xf7)
+                {
+                    runningStatus = 0;
+                    track.skip(track.readVariableLength());
+                }
+                else if (status >= 0xf0)
+                {
+                    break; // System common/real-time messages don't belong in a file
+                }
+                else
+                {
+                    runningStatus = status;
+                    const int type = status & 0xf0;
+                    const int data1 = track.readByte() & 0x7f;
+                    const int data2 = (type == 0xc0 || type == 0xd0) ? 0 : track.readByte() & 0x7f;
+                    const int index = (status & 0x0f) * numNoteNumbers + data1;
+
+                    if (type == 0x90 && data2 > 0)
+                    {
+                        endNote(index); // A repeated note-on ends the one before it
+                        starts[(size_t) index] = tick;
+                        velocities[(size_t) index] = (juce::uint8) data2;
+                    }
+                    else if (type == 0x80 || type == 0x90)
+                    {
+                        endNote(index);
+                    }
+                }
+            }
+
+            for (int index = 0; index < numChannels * numNoteNumbers; ++index)
+                endNote(index);
+
+            return tick;
+        }
+    }
+
+    bool readNotes(const void* data, size_t size, Header& header, std::vector<Note>& notes, juce::String& error)
+    {
+        notes.clear();
+
+        Cursor cursor { static_cast<const juce::uint8*>(data), 0, size };
+        if (data == nullptr || !hasChunkId(cursor, "MThd"))
+        {
+            error = "not a MIDI file";
+            return false;
+        }
+
+        cursor.skip(4);
+        const auto headerLength = cursor.readBigEndian(4);
+        header.format = (int) cursor.readBigEndian(2);
+        header.numTracks = (int) cursor.readBigEndian(2);
+        const auto division = cursor.readBigEndian(2);
+
+        if (cursor.failed || headerLength < 6)
+        {
+            error = "MIDI file header is cut short";
+            return false;
+        }
+
+        if ((division & 0x8000) != 0)
+        {
+            // SMPTE: frames per second (stored negated) x ticks per frame
+            const int framesPerSecond = -(int) (juce::int8) (division >> 8);
+            header.ticksPerQuarterNote = juce::jmax(1, framesPerSecond * (int) (division & 0xff));
+        }
+        else
+        {
+            header.ticksPerQuarterNote = juce::jmax(1, (int) division);
+        }
+
+        cursor.skip(headerLength - 6);
+
+        // Format 2 tracks are independent patterns, so each starts where the one before ended
+        juce::int64 trackStart = 0;
+
+        // Chunks other than MTrk are skipped, as the spec asks
+        while (!cursor.failed && cursor.end - cursor.position >= 8)
+        {
+            const bool isTrack = hasChunkId(cursor, "MTrk");
+            cursor.skip(4);
+            const size_t length = juce::jmin((size_t) cursor.readBigEndian(4), cursor.end - cursor.position);
+
+            if (isTrack)
+            {
+                const auto trackEnd = readTrack({ cursor.data, cursor.position, cursor.position + length }, trackStart, notes);
+                if (header.format == 2)
+                    trackStart = trackEnd;
+            }
+
+            cursor.skip(length);
+        }
+
+        std::sort(notes.begin(), notes.end(), [](const Note& a, const Note& b) {
+            return a.start != b.start ? a.start < b.start : a.note < b.note;
+        });
+
+        return true;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+// Reads the notes out of a Standard MIDI File straight from its bytes - typically a
+// juce::MemoryMappedFile - without copying the file or building MidiMessages. Meant
+// for scanning whole libraries, where juce::MidiFile's per-event allocations dominate.
+//
+// Formats 0, 1 and 2; format 2 tracks are independent patterns, so each is placed after
+// the one before it ends rather than on top of it. Running status, meta events and sysex
+// are handled; only note-ons and note-offs are kept.
+namespace SmfReader
+{
+    struct Note
+    {
+        juce::int64 start = 0;      // Ticks from the start of the file
+        juce::int64 end = 0;        // > start
+        juce::uint8 note = 0;
+        juce::uint8 velocity = 0;
+        juce::uint8 channel = 0;    // 0..15, so 9 is the GM drum channel
+    };
+
+    struct Header
+    {
+        int format = 0;
+        int numTracks = 0;
+        int ticksPerQuarterNote = 480; // SMPTE files are given in ticks per second instead
+    };
+
+    // Replaces notes with every note in the file, sorted by start. Notes still held at
+    // the end of their track end there. notes is only cleared, never shrunk, so a
+    // vector reused across files stops allocating once it's big enough.
+    // Returns false with a reason in error if the data isn't a MIDI file; a truncated
+    // track keeps what was read before it broke off.
+    bool readNotes(const void* data, size_t size, Header& header, std::vector<Note>& notes, juce::String& error);
+}
@@ -0,0 +1,108 @@
+#include "SpectrumComponent.h"
+
+SpectrumComponent::SpectrumComponent(LevelMeter& meterToRead)
+    : meter(meterToRead)
+{
+    setInterceptsMouseClicks(false, false); // The keys underneath stay playable
+    bandDecibels.fill(floorDecibels);
+}
+
+SpectrumComponent::~SpectrumComponent()
+{
+    stopTimer();
+    meter.setSpectrumEnabled(false);
+}
+
+void SpectrumComponent::visibilityChanged()
+{
+    const bool showing = isVisible();
+    meter.setSpectrumEnabled(showing);
+
+    if (showing)
+    {
+        startTimerHz(refreshRateHz);
+    }
+    else
+    {
+        stopTimer();
+        bandDecibels.fill(floorDecibels);
+    }
+}
+
+void SpectrumComponent::timerCallback()
+{
+    if (meter.popLatestSnapshot(snapshot))
+    {
+        analyse();
+    }
+    else
+    {
+        // Nothing new (silence from the host, or it stopped calling): let the bands fall
+        for (auto& band : bandDecibels)
+            band = juce::jmax(floorDecibels, band - fallDecibelsPerSecond / (float) refreshRateHz);
+    }
+
+    repaint();
+}
+
+void SpectrumComponent::analyse()
+{
+    std::copy(std::begin(snapshot.samples), std::end(snapshot.samples), fftData.begin());
+    std::fill(fftData.begin() + LevelMeter::fftSize, fftData.end(), 0.0f);
+
+    window.multiplyWithWindowingTable(fftData.data(), (size_t) LevelMeter::fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    // A full-scale sine comes out at about fftSize / 4 through a Hann window
+    const float normalise = 4.0f / (float) LevelMeter::fftSize;
+    const int numBins = LevelMeter::fftSize / 2;
+    const float nyquist = (float) snapshot.sampleRate * 0.5f;
+    const float lowest = juce::jmin(lowestFrequency, nyquist * 0.5f);
+    const float fall = fallDecibelsPerSecond / (float) refreshRateHz;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        // Log-spaced edges from lowestFrequency to Nyquist, at least one bin wide
+        const float lowFrequency = lowest * std::pow(nyquist / lowest, (float) band / (float) numBands);
+        const float highFrequency = lowest * std::pow(nyquist / lowest, (float) (band + 1) / (float) numBands);
+        const int firstBin = juce::jlimit(1, numBins - 1, (int) (lowFrequency / nyquist * (float) numBins));
+        const int lastBin = juce::jlimit(firstBin, numBins - 1, (int) (highFrequency / nyquist * (float) numBins));
+
+        float magnitude = 0.0f;
+        for (int bin = firstBin; bin <= lastBin; ++bin)
+            magnitude = juce::jmax(magnitude, fftData[(size_t) bin]);
+
+        const float decibels = juce::Decibels::gainToDecibels(magnitude * normalise, floorDecibels);
+        bandDecibels[(size_t) band] = juce::jmax(decibels, bandDecibels[(size_t) band] - fall);
+    }
+}
+
+void SpectrumComponent::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+    const float bandWidth = bounds.getWidth() / (float) (numBands - 1);
+
+    juce::Path outline;
+    for (int band = 0; band < numBands; ++band)
+    {
+        const float proportion = juce::jlimit(0.0f, 1.0f, 1.0f - bandDecibels[(size_t) band] / floorDecibels);
+        const float x = bounds.getX() + bandWidth * (float) band;
+        const float y = bounds.getBottom() - bounds.getHeight() * proportion;
+
+        if (band == 0)
+            outline.startNewSubPath(x, y);
+        else
+            outline.lineTo(x, y);
+    }
+
+    juce::Path fill(outline);
+    fill.lineTo(bounds.getBottomRight());
+    fill.lineTo(bounds.getBottomLeft());
+    fill.closeSubPath();
+
+    g.setColour(fillColour);
+    g.fillPath(fill);
+
+    g.setColour(lineColour);
+    g.strokePath(outline, juce::PathStrokeType(1.5f));
+}
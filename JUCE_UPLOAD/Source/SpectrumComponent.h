@@ -0,0 +1,45 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "LevelMeter.h"
+
+// Translucent spectrum of the output, drawn over the keys while it's shown.
+//
+// The audio thread only hands over decimated snapshots (see LevelMeter); the windowing
+// and FFT run here, at most once a frame, and the bins are folded into log-spaced bands
+// that fall smoothly between frames. While hidden, the meter is told to stop taking
+// snapshots and the timer stops, so a closed spectrum costs nothing.
+class SpectrumComponent : public juce::Component,
+                          private juce::Timer
+{
+public:
+    explicit SpectrumComponent(LevelMeter& meterToRead);
+    ~SpectrumComponent() override;
+
+    void paint(juce::Graphics& g) override;
+    void visibilityChanged() override;
+
+private:
+    void timerCallback() override;
+    void analyse();
+
+    static constexpr int refreshRateHz = 30;
+    static constexpr int numBands = 48;
+    static constexpr float lowestFrequency = 40.0f;
+    static constexpr float floorDecibels = -72.0f;
+    static constexpr float fallDecibelsPerSecond = 36.0f;
+
+    LevelMeter& meter;
+    LevelMeter::Snapshot snapshot;
+
+    juce::dsp::FFT fft { LevelMeter::fftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t) LevelMeter::fftSize, juce::dsp::WindowingFunction<float>::hann };
+    std::array<float, 2 * LevelMeter::fftSize> fftData {};
+
+    std::array<float, numBands> bandDecibels {};
+
+    const juce::Colour fillColour = juce::Colours::white.withAlpha(0.12f);
+    const juce::Colour lineColour = juce::Colours::white.withAlpha(0.35f);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumComponent)
+};
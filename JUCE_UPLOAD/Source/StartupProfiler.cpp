@@ -0,0 +1,177 @@
+#include "StartupProfiler.h"
+#include <iostream>
+
+struct StartupProfiler::Session
+{
+    Session()
+        : originTicks(juce::Time::getHighResolutionTicks())
+    {
+        const auto variable = juce::SystemStats::getEnvironmentVariable("PIANOXL_STARTUP_TRACE", {});
+        if (variable.isNotEmpty())
+        {
+            traceFile = juce::File::isAbsolutePath(variable) ? juce::File(variable) : getDefaultTraceFile();
+            enabled = true;
+        }
+    }
+
+    std::atomic<bool> enabled { false };
+    const juce::int64 originTicks;           // Times in the trace count from here
+
+    Event events[maxEvents];
+    std::atomic<int> numEvents { 0 };        // Claimed slots, possibly still being filled
+
+    juce::CriticalSection fileLock;
+    juce::File traceFile;                    // Guarded by fileLock
+    bool hasWrittenOnce = false;             // Guarded by fileLock
+};
+
+StartupProfiler::Session& StartupProfiler::getSession()
+{
+    static Session session;
+    return session;
+}
+
+//==============================================================================
+StartupProfiler::Scope::Scope(const char* phaseName) noexcept
+    : name(phaseName)
+{
+    if (isEnabled())
+        startTicks = juce::Time::getHighResolutionTicks();
+}
+
+StartupProfiler::Scope::~Scope()
+{
+    if (startTicks != 0)
+        record(name, startTicks, juce::Time::getHighResolutionTicks());
+}
+
+//==============================================================================
+bool StartupProfiler::isEnabled() noexcept
+{
+    return getSession().enabled.load(std::memory_order_relaxed);
+}
+
+void StartupProfiler::enable(const juce::File& traceFile)
+{
+    auto& session = getSession();
+    {
+        const juce::ScopedLock sl(session.fileLock);
+        session.traceFile = traceFile;
+    }
+    session.enabled = true;
+}
+
+void StartupProfiler::mark(const char* name) noexcept
+{
+    if (isEnabled())
+        record(name, juce::Time::getHighResolutionTicks(), -1);
+}
+
+void StartupProfiler::record(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept
+{
+    auto& session = getSession();
+    const int index = session.numEvents.fetch_add(1, std::memory_order_relaxed);
+    if (index >= maxEvents)
+        return; // Startup is long over by now
+
+    auto& event = session.events[index];
+    event.name = name;
+    event.startTicks = startTicks;
+    event.endTicks = endTicks;
+    event.threadId = (juce::uint64) (juce::pointer_sized_uint) juce::Thread::getCurrentThreadId();
+    event.isComplete.store(true, std::memory_order_release);
+}
+
+int StartupProfiler::getNumEvents() noexcept
+{
+    return juce::jmin(maxEvents, getSession().numEvents.load());
+}
+
+//==============================================================================
+juce::File StartupProfiler::getDefaultTraceFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("PianoXL")
+               .getChildFile("StartupTrace.json");
+}
+
+juce::File StartupProfiler::getTraceFile()
+{
+    auto& session = getSession();
+    const juce::ScopedLock sl(session.fileLock);
+    return session.traceFile;
+}
+
+bool StartupProfiler::writeTrace()
+{
+    if (!isEnabled())
+        return false;
+
+    auto& session = getSession();
+    const juce::ScopedLock sl(session.fileLock);
+
+    const double ticksPerMicrosecond = (double) juce::Time::getHighResolutionTicksPerSecond() / 1.0e6;
+    auto toMicroseconds = [&](juce::int64 ticks) { return (double) (ticks - session.originTicks) / ticksPerMicrosecond; };
+
+    // Thread ids are long and opaque; number them in order of appearance instead
+    juce::Array<juce::uint64> threads;
+    juce::Array<juce::var> traceEvents;
+
+    for (int i = 0; i < getNumEvents(); ++i)
+    {
+        const auto& event = session.events[i];
+        if (!event.isComplete.load(std::memory_order_acquire))
+            continue; // Still being written by another thread
+
+        threads.addIfNotAlreadyThere(event.threadId);
+
+        auto* object = new juce::DynamicObject();
+        object->setProperty("name", juce::String(event.name));
+        object->setProperty("cat", "startup");
+        object->setProperty("pid", 1);
+        object->setProperty("tid", threads.indexOf(event.threadId) + 1);
+        object->setProperty("ts", toMicroseconds(event.startTicks));
+
+        if (event.endTicks < 0)
+        {
+            object->setProperty("ph", "i");
+            object->setProperty("s", "p"); // Drawn across the whole process
+        }
+        else
+        {
+            object->setProperty("ph", "X");
+            object->setProperty("dur", toMicroseconds(event.endTicks) - toMicroseconds(event.startTicks));
+        }
+
+        traceEvents.add(juce::var(object));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("traceEvents", traceEvents);
+    root->setProperty("displayTimeUnit", "ms");
+
+    if (!session.traceFile.getParentDirectory().createDirectory()
+        || !session.traceFile.replaceWithText(juce::JSON::toString(juce::var(root))))
+    {
+        std::cout << "StartupProfiler: couldn't write " << session.traceFile.getFullPathName() << std::endl;
+        return false;
+    }
+
+    std::cout << "StartupProfiler: wrote " << traceEvents.size() << " events to "
+              << session.traceFile.getFullPathName() << std::endl;
+    return true;
+}
+
+void StartupProfiler::writeTraceOnce()
+{
+    {
+        auto& session = getSession();
+        const juce::ScopedLock sl(session.fileLock);
+        if (session.hasWrittenOnce)
+            return;
+
+        session.hasWrittenOnce = true;
+    }
+
+    writeTrace();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+// Timeline of how long startup takes, phase by phase, for every plugin instance in the
+// process. Off unless the PIANOXL_STARTUP_TRACE environment variable is set (to a file
+// path, or to anything else for the default file) or enable() is called first thing.
+//
+// Phases are recorded with a Scope around the code in question, from any thread, into
+// a fixed array without locking. writeTrace() saves them in Chrome's trace event format,
+// which chrome://tracing and Perfetto open directly. While it's off, a Scope costs one
+// relaxed atomic load.
+class StartupProfiler
+{
+public:
+    static constexpr int maxEvents = 512;
+
+    // Times the enclosing block. name must outlive the profiler (a string literal).
+    class Scope
+    {
+    public:
+        explicit Scope(const char* phaseName) noexcept;
+        ~Scope();
+
+    private:
+        const char* name;
+        juce::int64 startTicks = 0;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+    static bool isEnabled() noexcept;
+    static void enable(const juce::File& traceFile);
+
+    // A moment rather than a phase, such as the first frame being painted
+    static void mark(const char* name) noexcept;
+
+    static int getNumEvents() noexcept;
+
+    // Writes everything recorded so far. The first call after startup has finished
+    // (writeTraceOnce) is the one that normally ends up on disk.
+    static bool writeTrace();
+    static void writeTraceOnce();
+
+    static juce::File getTraceFile();
+    static juce::File getDefaultTraceFile();
+
+private:
+    struct Event
+    {
+        const char* name = nullptr;
+        juce::int64 startTicks = 0;
+        juce::int64 endTicks = -1;            // -1 for a mark
+        juce::uint64 threadId = 0;
+        std::atomic<bool> isComplete { false };
+    };
+
+    struct Session;
+    static Session& getSession();
+    static void record(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept;
+
+    StartupProfiler() = delete;
+};
@@ -0,0 +1,81 @@
+#include "StateAutosaver.h"
+#include <iostream>
+
+StateAutosaver::StateAutosaver(StateSnapshotCache& snapshotCache, const juce::File& targetFile, int checkIntervalMs)
+    : juce::Thread("PianoXL Autosave"),
+      cache(snapshotCache),
+      file(targetFile),
+      intervalMs(checkIntervalMs)
+{
+    // Whatever is in the cache right now came from (or matches) what's on disk
+    lastWrittenGeneration = cache.getGeneration();
+    startThread(juce::Thread::Priority::low);
+}
+
+StateAutosaver::~StateAutosaver()
+{
+    stopThread(4000);
+
+    // Catch changes made after the thread's last pass (e.g. right before quitting)
+    cache.flushPendingChanges();
+    writeSnapshotIfChanged();
+}
+
+juce::File StateAutosaver::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("PianoXL")
+               .getChildFile("AppState.pxls");
+}
+
+juce::ValueTree StateAutosaver::loadFromFile(const juce::File& fileToLoad)
+{
+    juce::MemoryBlock data;
+    if (!fileToLoad.existsAsFile() || !fileToLoad.loadFileAsData(data))
+        return {};
+
+    return StateSerializer::readState(data.getData(), data.getSize());
+}
+
+void StateAutosaver::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(intervalMs);
+
+        if (!threadShouldExit())
+            writeSnapshotIfChanged();
+    }
+}
+
+bool StateAutosaver::writeSnapshotIfChanged()
+{
+    const auto generation = cache.getGeneration();
+    if (generation == lastWrittenGeneration)
+        return false;
+
+    cache.copySnapshotTo(pendingData);
+
+    if (!file.getParentDirectory().createDirectory())
+        return false;
+
+    juce::TemporaryFile temp(file);
+
+    if (auto out = temp.getFile().createOutputStream())
+    {
+        if (!out->write(pendingData.getData(), pendingData.getSize()))
+            return false;
+
+        out->flush();
+        out.reset();
+
+        if (temp.overwriteTargetFileWithTemporary())
+        {
+            lastWrittenGeneration = generation;
+            return true;
+        }
+    }
+
+    std::cout << "Autosave failed: " << file.getFullPathName() << std::endl;
+    return false;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "StateSerializer.h"
+
+// Background thread that writes the latest app state snapshot to disk, but only
+// when the snapshot has changed since the last write. Files are replaced atomically
+// (write to a temporary file, then move over the target) so a crash mid-write never
+// leaves a truncated snapshot behind.
+class StateAutosaver : private juce::Thread
+{
+public:
+    StateAutosaver(StateSnapshotCache& snapshotCache, const juce::File& targetFile, int checkIntervalMs = 2000);
+    ~StateAutosaver() override; // Flushes any pending change before returning
+
+    // Wakes the thread so a pending change is written without waiting for the interval.
+    void saveSoon() { notify(); }
+
+    // Default location for the standalone app's autosave file.
+    static juce::File getDefaultFile();
+
+    // Loads a snapshot file written by this class. Returns an invalid tree on failure.
+    static juce::ValueTree loadFromFile(const juce::File& file);
+
+private:
+    void run() override;
+    bool writeSnapshotIfChanged();
+
+    StateSnapshotCache& cache;
+    const juce::File file;
+    const int intervalMs;
+    juce::MemoryBlock pendingData;
+    juce::uint64 lastWrittenGeneration = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StateAutosaver)
+};
@@ -0,0 +1,159 @@
+#include "StateSerializer.h"
+#include "AppStateModel.h"
+
+//==============================================================================
+void StateSerializer::writeState(const juce::ValueTree& state, juce::MemoryBlock& destData,
+                                 const juce::Array<ExtraChunk*>& extraChunks)
+{
+    juce::MemoryOutputStream out(destData, false); // Overwrites, keeping the block's allocation
+
+    out.writeInt((int) magic);
+    out.writeShort((short) currentVersion);
+    out.writeShort((short) (1 + extraChunks.size())); // Number of chunks
+
+    // Chunk sizes aren't known until the payload has been written, so patch them afterwards
+    auto writeChunk = [&out](juce::uint32 chunkId, const std::function<void()>& writePayload) {
+        out.writeInt((int) chunkId);
+        const auto sizePosition = out.getPosition();
+        out.writeInt(0);
+        const auto payloadStart = out.getPosition();
+        writePayload();
+        const auto payloadEnd = out.getPosition();
+
+        out.setPosition(sizePosition);
+        out.writeInt((int) (payloadEnd - payloadStart));
+        out.setPosition(payloadEnd);
+    };
+
+    writeChunk(stateChunkId, [&] { state.writeToStream(out); });
+
+    for (auto* chunk : extraChunks)
+        writeChunk(chunk->getChunkId(), [&] { chunk->writeChunk(out); });
+
+    out.flush();
+}
+
+juce::ValueTree StateSerializer::readState(const void* data, size_t sizeInBytes,
+                                           const juce::Array<ExtraChunk*>& extraChunks)
+{
+    if (data == nullptr || sizeInBytes < 8)
+        return {};
+
+    juce::MemoryInputStream in(data, sizeInBytes, false);
+
+    if ((juce::uint32) in.readInt() != magic)
+        return {};
+
+    const int version = in.readShort();
+    if (version < 1 || version > currentVersion)
+        return {};
+
+    const int numChunks = in.readShort();
+    juce::ValueTree result;
+
+    // Extra chunks are only handed over once the whole snapshot has been validated
+    juce::Array<std::pair<ExtraChunk*, juce::Range<juce::int64>>> extraPayloads;
+
+    for (int i = 0; i < numChunks && !in.isExhausted(); ++i)
+    {
+        const auto chunkId = (juce::uint32) in.readInt();
+        const auto chunkSize = (juce::int64) (juce::uint32) in.readInt();
+        const auto chunkStart = in.getPosition();
+
+        if (chunkStart + chunkSize > (juce::int64) sizeInBytes)
+            return {}; // Truncated snapshot
+
+        if (chunkId == stateChunkId)
+        {
+            juce::MemoryInputStream chunkStream(static_cast<const char*>(data) + chunkStart, (size_t) chunkSize, false);
+            result = juce::ValueTree::readFromStream(chunkStream);
+        }
+        else
+        {
+            for (auto* chunk : extraChunks)
+                if (chunk->getChunkId() == chunkId)
+                    extraPayloads.add({ chunk, { chunkStart, chunkStart + chunkSize } });
+        }
+
+        in.setPosition(chunkStart + chunkSize);
+    }
+
+    if (!result.hasType(IDs::APP_STATE))
+        return {};
+
+    for (auto& payload : extraPayloads)
+        payload.first->readChunk(static_cast<const char*>(data) + payload.second.getStart(),
+                                 (size_t) payload.second.getLength());
+
+    return result;
+}
+
+//==============================================================================
+StateSnapshotCache::StateSnapshotCache(juce::ValueTree stateToWatch)
+    : state(stateToWatch)
+{
+    state.addListener(this);
+    refresh();
+}
+
+StateSnapshotCache::~StateSnapshotCache()
+{
+    cancelPendingUpdate();
+    state.removeListener(this);
+}
+
+void StateSnapshotCache::markDirty()
+{
+    dirty = true;
+    triggerAsyncUpdate();
+}
+
+void StateSnapshotCache::addExtraChunk(StateSerializer::ExtraChunk* chunk)
+{
+    extraChunks.addIfNotAlreadyThere(chunk);
+    markDirty();
+}
+
+void StateSnapshotCache::removeExtraChunk(StateSerializer::ExtraChunk* chunk)
+{
+    extraChunks.removeFirstMatchingValue(chunk);
+    markDirty();
+}
+
+void StateSnapshotCache::refresh()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    dirty = false;
+    StateSerializer::writeState(state, scratch, extraChunks);
+
+    {
+        const juce::SpinLock::ScopedLockType lock(snapshotLock);
+        snapshot.swapWith(scratch);
+    }
+
+    ++generation;
+}
+
+void StateSnapshotCache::copySnapshotTo(juce::MemoryBlock& destData)
+{
+    if (dirty && juce::MessageManager::existsAndIsCurrentThread())
+        handleUpdateNowIfNeeded();
+
+    const juce::SpinLock::ScopedLockType lock(snapshotLock);
+    destData = snapshot;
+}
+
+bool StateSnapshotCache::restoreFrom(const void* data, size_t sizeInBytes)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    auto restored = StateSerializer::readState(data, sizeInBytes, extraChunks);
+    if (!restored.isValid())
+        return false;
+
+    state.copyPropertiesAndChildrenFrom(restored, nullptr);
+    // Older snapshots may be missing properties that were added since
+    AppStateModel::ensureDefaults(state, nullptr);
+    return true;
+}
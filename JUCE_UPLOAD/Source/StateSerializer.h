@@ -0,0 +1,104 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include "Identifiers.h"
+
+// Compact, versioned binary snapshot format for the app state.
+//
+// Layout (little endian):
+//   uint32 magic ("PXLS"), uint16 format version, uint16 number of chunks
+//   then per chunk: uint32 chunk id (four-character code), uint32 size, payload
+//
+// Readers skip chunks they don't know, so new data can be added without breaking
+// older snapshots. The version only changes if an existing chunk changes meaning.
+class StateSerializer
+{
+public:
+    static constexpr juce::uint32 makeChunkId(char a, char b, char c, char d)
+    {
+        return (juce::uint32) (juce::uint8) a
+             | ((juce::uint32) (juce::uint8) b << 8)
+             | ((juce::uint32) (juce::uint8) c << 16)
+             | ((juce::uint32) (juce::uint8) d << 24);
+    }
+
+    static constexpr juce::uint32 magic = makeChunkId('P', 'X', 'L', 'S');
+    static constexpr int currentVersion = 1;
+
+    static constexpr juce::uint32 stateChunkId = makeChunkId('S', 'T', 'A', 'T'); // ValueTree binary
+
+    // Data that lives outside the ValueTree (e.g. the memory bank) can add its own chunk
+    class ExtraChunk
+    {
+    public:
+        virtual ~ExtraChunk() = default;
+        virtual juce::uint32 getChunkId() const = 0;
+        virtual void writeChunk(juce::MemoryOutputStream& out) const = 0;
+        virtual void readChunk(const void* data, size_t sizeInBytes) = 0;
+    };
+
+    // Serialises the whole app state tree plus any extra chunks into destData (replacing its contents).
+    static void writeState(const juce::ValueTree& state, juce::MemoryBlock& destData,
+                           const juce::Array<ExtraChunk*>& extraChunks = {});
+
+    // Returns an invalid tree if the data isn't a snapshot this build understands.
+    // Extra chunks with a matching id are handed their payload.
+    static juce::ValueTree readState(const void* data, size_t sizeInBytes,
+                                     const juce::Array<ExtraChunk*>& extraChunks = {});
+};
+
+//==============================================================================
+// Keeps a serialised copy of the app state up to date so hosts and the autosaver
+// can grab a snapshot from any thread without touching the ValueTree.
+// Changes are batched through an AsyncUpdater, so a burst of property changes
+// costs a single re-serialisation on the message thread.
+class StateSnapshotCache : private juce::ValueTree::Listener,
+                           private juce::AsyncUpdater
+{
+public:
+    explicit StateSnapshotCache(juce::ValueTree stateToWatch);
+    ~StateSnapshotCache() override;
+
+    // Safe to call from any thread. On the message thread, pending changes are
+    // serialised first; elsewhere the most recent snapshot is returned.
+    void copySnapshotTo(juce::MemoryBlock& destData);
+
+    // Message thread only. Serialises any changes that are still waiting for the async update.
+    void flushPendingChanges() { handleUpdateNowIfNeeded(); }
+
+    // Message thread only. Registers data to be stored alongside the tree. Call markDirty()
+    // whenever that data changes, since the cache can't see it.
+    void addExtraChunk(StateSerializer::ExtraChunk* chunk);
+    void removeExtraChunk(StateSerializer::ExtraChunk* chunk);
+    void markDirty();
+
+    // Incremented every time the cached snapshot is refreshed.
+    juce::uint64 getGeneration() const noexcept { return generation.load(); }
+
+    // Message thread only. Replaces the watched state with the contents of a snapshot.
+    bool restoreFrom(const void* data, size_t sizeInBytes);
+
+private:
+    void refresh();
+
+    // AsyncUpdater
+    void handleAsyncUpdate() override { refresh(); }
+
+    // ValueTree::Listener methods
+    void valueTreePropertyChanged(juce::ValueTree&, const juce::Identifier&) override { markDirty(); }
+    void valueTreeChildAdded(juce::ValueTree&, juce::ValueTree&) override { markDirty(); }
+    void valueTreeChildRemoved(juce::ValueTree&, juce::ValueTree&, int) override { markDirty(); }
+    void valueTreeChildOrderChanged(juce::ValueTree&, int, int) override { markDirty(); }
+    void valueTreeParentChanged(juce::ValueTree&) override {}
+
+    juce::ValueTree state;
+    juce::Array<StateSerializer::ExtraChunk*> extraChunks;
+    juce::MemoryBlock snapshot;
+    juce::MemoryBlock scratch; // Reused between refreshes to avoid reallocating
+    juce::SpinLock snapshotLock;
+    std::atomic<bool> dirty { true };
+    std::atomic<juce::uint64> generation { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StateSnapshotCache)
+};
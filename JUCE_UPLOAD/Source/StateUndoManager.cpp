@@ -0,0 +1,36 @@
+#include "StateUndoManager.h"
+
+StateUndoManager::StateUndoManager(int budgetInUnits, int coalesceWindowMs)
+    : juce::UndoManager(budgetInUnits, 1), // Keep at least the latest transaction, otherwise the budget wins
+      coalesceWindow((juce::uint32) coalesceWindowMs)
+{
+}
+
+void StateUndoManager::beginGesture(const juce::Identifier& gesture)
+{
+    const auto now = juce::Time::getMillisecondCounter();
+
+    if (gesture != lastGesture || now - lastGestureTime > coalesceWindow)
+        beginNewTransaction(gesture.toString());
+
+    lastGesture = gesture;
+    lastGestureTime = now;
+}
+
+void StateUndoManager::beginDistinctTransaction(const juce::String& transactionName)
+{
+    beginNewTransaction(transactionName);
+    lastGesture = {};
+}
+
+bool StateUndoManager::undoGesture()
+{
+    lastGesture = {};
+    return undo();
+}
+
+bool StateUndoManager::redoGesture()
+{
+    lastGesture = {};
+    return redo();
+}
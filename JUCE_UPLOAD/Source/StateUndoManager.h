@@ -0,0 +1,35 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// UndoManager used for every app state mutation.
+//
+// - Rapid repeats of the same gesture (holding plus/minus, dragging the fader) are
+//   merged into one transaction. Within a transaction the ValueTree actions for the
+//   same property coalesce, so a long drag costs a single action.
+// - History has a hard budget: once the stored actions exceed it, the oldest
+//   transactions are dropped first. ValueTree actions report roughly their size in
+//   bytes, so the budget is approximately a byte count.
+class StateUndoManager : public juce::UndoManager
+{
+public:
+    explicit StateUndoManager(int budgetInUnits = 64 * 1024, int coalesceWindowMs = 600);
+
+    // Starts a new transaction unless the previous change belonged to the same gesture
+    // and happened less than the coalesce window ago.
+    void beginGesture(const juce::Identifier& gesture);
+
+    // Starts a transaction that never merges with its neighbours (e.g. a memory recall).
+    void beginDistinctTransaction(const juce::String& transactionName);
+
+    // Undo/redo that also end the current gesture, so the next edit starts fresh
+    bool undoGesture();
+    bool redoGesture();
+
+private:
+    const juce::uint32 coalesceWindow;
+    juce::Identifier lastGesture;
+    juce::uint32 lastGestureTime = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StateUndoManager)
+};
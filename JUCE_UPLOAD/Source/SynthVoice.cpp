@@ -0,0 +1,233 @@
+#include "SynthVoice.h"
+#include <limits>
+
+SynthVoice::Shape::Shape(double newSampleRate, float sustainPercent, float sampleStartMs)
+{
+    sampleRate = (float) newSampleRate;
+    sustainProportion = sustainPercent / 100.0f;
+    decayMultiplier = std::pow(sustainProportion, 1.0f / (decaySeconds * sampleRate));
+    attackStep = 1.0f / (attackSeconds * sampleRate);
+    endReleaseStep = 1.0f / juce::jmax(1.0f, releaseSeconds * sampleRate);
+    skippedSamples = juce::jmax(0, (int) (sampleStartMs * 0.001f * sampleRate));
+    skippedDecay = std::pow(decayMultiplier, (float) skippedSamples);
+}
+
+void SynthVoice::start(float frequency, float gain, bool isBassVoice, int sourceNoteToUse, int startDelaySamples,
+                       int lengthSamples, const Shape& shape)
+{
+    *this = SynthVoice();
+    active = true;
+    sourceNote = sourceNoteToUse;
+    isBass = isBassVoice;
+    startDelay = startDelaySamples;
+    phaseIncrement = juce::MathConstants<float>::twoPi * frequency / shape.sampleRate;
+    level = gain;
+    floorLevel = gain * shape.sustainProportion;
+    decayMultiplier = shape.decayMultiplier;
+    attackStep = shape.attackStep;
+    endReleaseStep = shape.endReleaseStep;
+    samplesUntilRelease = juce::jmax(1, lengthSamples);
+
+    // Only a note too short for the whole sample start needs its own decay worked out
+    const int skippedSamples = juce::jmin(shape.skippedSamples, samplesUntilRelease - 1);
+    if (skippedSamples > 0)
+    {
+        const float decay = skippedSamples == shape.skippedSamples ? shape.skippedDecay
+                                                                   : std::pow(decayMultiplier, (float) skippedSamples);
+        level = juce::jlimit(juce::jmin(gain, floorLevel), juce::jmax(gain, floorLevel), gain * decay);
+        samplesUntilRelease -= skippedSamples;
+        phase = std::fmod(phaseIncrement * (float) skippedSamples, juce::MathConstants<float>::twoPi);
+    }
+}
+
+void SynthVoice::stop(float seconds, double sampleRate) noexcept
+{
+    if (startDelay > 0 && releaseStep == 0.0f)
+        active = false; // Flammed note that hasn't sounded yet
+    else
+        startRelease(seconds, sampleRate);
+}
+
+void SynthVoice::startRelease(float seconds, double sampleRate) noexcept
+{
+    const float step = 1.0f / juce::jmax(1.0f, seconds * (float) sampleRate);
+    releaseStep = releaseStep > 0.0f ? juce::jmax(releaseStep, step) : step;
+}
+
+void SynthVoice::render(float* left, float* right, const float* busGains, int numSamples) noexcept
+{
+    SynthVoice* self = this;
+    renderVoices(&self, 1, left, right, busGains, busGains, numSamples);
+}
+
+//==============================================================================
+namespace
+{
+    using Lanes = juce::dsp::SIMDRegister<float>;
+
+    constexpr int lanes = SynthVoice::envelopeLanes;
+    constexpr int laneWidth = (int) Lanes::SIMDNumElements;
+    constexpr int numRegisters = lanes / laneWidth;
+    constexpr int envelopeBlockSize = 64;   // Samples of gain worked out at a time, kept on the stack
+
+    static_assert(lanes % laneWidth == 0, "envelopeLanes must fill whole SIMD registers");
+
+    Lanes clamp(Lanes value, Lanes low, Lanes high) noexcept
+    {
+        return Lanes::min(high, Lanes::max(low, value));
+    }
+
+    // The envelope state of a group of voices, one lane each. Unused lanes stay silent.
+    //
+    // Every test is a clamp rather than a branch. The start delay and release countdown
+    // are whole numbers of samples, so clamp(x + 1, 0, 1) is exactly 1 once x reaches 0
+    // and exactly 0 before: that's what gates each lane from the sample it starts on,
+    // and what starts each release on the sample it was due.
+    struct EnvelopeLanes
+    {
+        Lanes level[numRegisters] {};
+        Lanes levelMin[numRegisters] {};        // The decay is a clamp to [levelMin, levelMax]
+        Lanes levelMax[numRegisters] {};        // rather than a test against the floor
+        Lanes decayMultiplier[numRegisters] {};
+        Lanes attack[numRegisters] {};
+        Lanes attackStep[numRegisters] {};
+        Lanes release[numRegisters] {};
+        Lanes releaseStep[numRegisters] {};
+        Lanes releaseCountdown[numRegisters] {}; // Samples until the release starts, <= 0 once it has
+        Lanes startOffset[numRegisters] {};      // Samples of start delay left in this stretch
+
+        static void setLane(Lanes* registers, int lane, float value) noexcept
+        {
+            registers[lane / laneWidth].set((size_t) (lane % laneWidth), value);
+        }
+
+        static float getLane(const Lanes* registers, int lane) noexcept
+        {
+            return registers[lane / laneWidth].get((size_t) (lane % laneWidth));
+        }
+
+        void load(int lane, const SynthVoice& voice) noexcept
+        {
+            setLane(level, lane, voice.level);
+            setLane(levelMin, lane, voice.decayMultiplier < 1.0f ? voice.floorLevel : 0.0f);
+            setLane(levelMax, lane, voice.decayMultiplier > 1.0f ? voice.floorLevel : std::numeric_limits<float>::max());
+            setLane(decayMultiplier, lane, voice.decayMultiplier);
+            setLane(attack, lane, voice.attackLevel);
+            setLane(attackStep, lane, voice.attackStep);
+            setLane(release, lane, voice.releaseGain);
+
+            const bool releasing = voice.releaseStep > 0.0f;
+            setLane(releaseStep, lane, releasing ? voice.releaseStep : voice.endReleaseStep);
+            setLane(releaseCountdown, lane, releasing ? 0.0f : (float) voice.samplesUntilRelease);
+        }
+
+        void store(int lane, SynthVoice& voice) const noexcept
+        {
+            voice.level = getLane(level, lane);
+            voice.attackLevel = getLane(attack, lane);
+            voice.releaseGain = getLane(release, lane);
+
+            const float countdown = getLane(releaseCountdown, lane);
+            if (countdown <= 0.0f)
+                voice.releaseStep = getLane(releaseStep, lane);
+            else
+                voice.samplesUntilRelease = (int) countdown;
+
+            voice.active = voice.releaseGain > 0.0f;
+        }
+
+        // Writes each lane's gain for numSamples samples to gains[sample * lanes + lane] and
+        // advances the envelopes. Lanes still in their start delay hold still and give 0.
+        void process(float* gains, int numSamples) noexcept
+        {
+            const auto zero = Lanes::expand(0.0f);
+            const auto one = Lanes::expand(1.0f);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto position = Lanes::expand((float) i + 1.0f);
+
+                for (int r = 0; r < numRegisters; ++r)
+                {
+                    const auto running = clamp(position - startOffset[r], zero, one);
+                    (level[r] * attack[r] * release[r] * running).copyToRawArray(gains + i * lanes + r * laneWidth);
+
+                    attack[r] = Lanes::min(one, attack[r] + attackStep[r] * running);
+
+                    // Decay towards the floor (sustain above 100% swells up to it instead)
+                    level[r] += (clamp(level[r] * decayMultiplier[r], levelMin[r], levelMax[r]) - level[r]) * running;
+
+                    releaseCountdown[r] -= running;
+                    const auto releasing = clamp(one - releaseCountdown[r], zero, one) * running;
+                    release[r] = Lanes::max(zero, release[r] - releaseStep[r] * releasing);
+                }
+            }
+        }
+    };
+}
+
+void SynthVoice::renderVoices(SynthVoice* const* voicesToRender, int numVoices, float* left, float* right,
+                              const float* chordGains, const float* bassGains, int numSamples) noexcept
+{
+    jassert(numVoices <= lanes);
+
+    EnvelopeLanes envelopes;
+    int startDelays[lanes] {};
+
+    for (int v = 0; v < numVoices; ++v)
+    {
+        if (voicesToRender[v]->active)
+        {
+            envelopes.load(v, *voicesToRender[v]);
+            startDelays[v] = voicesToRender[v]->startDelay;
+        }
+    }
+
+    alignas(Lanes::SIMDRegisterSize) float gains[envelopeBlockSize * lanes];
+
+    for (int blockStart = 0; blockStart < numSamples; blockStart += envelopeBlockSize)
+    {
+        const int blockLength = juce::jmin(envelopeBlockSize, numSamples - blockStart);
+
+        for (int v = 0; v < lanes; ++v)
+            EnvelopeLanes::setLane(envelopes.startOffset, v, (float) juce::jmin(startDelays[v], blockLength));
+
+        envelopes.process(gains, blockLength);
+
+        for (int v = 0; v < numVoices; ++v)
+        {
+            auto& voice = *voicesToRender[v];
+            if (!voice.active)
+                continue;
+
+            const int offset = juce::jmin(startDelays[v], blockLength);
+            startDelays[v] -= offset;
+
+            const float* busGains = (voice.isBass ? bassGains : chordGains) + blockStart;
+            float* const outLeft = left + blockStart;
+            float* const outRight = right != nullptr ? right + blockStart : nullptr;
+
+            for (int i = offset; i < blockLength; ++i)
+            {
+                const float sample = std::sin(voice.phase) * gains[i * lanes + v] * busGains[i];
+                outLeft[i] += sample;
+                if (outRight != nullptr)
+                    outRight[i] += sample;
+
+                voice.phase += voice.phaseIncrement;
+                if (voice.phase >= juce::MathConstants<float>::twoPi)
+                    voice.phase -= juce::MathConstants<float>::twoPi;
+            }
+        }
+    }
+
+    for (int v = 0; v < numVoices; ++v)
+    {
+        auto& voice = *voicesToRender[v];
+        if (!voice.active)
+            continue;
+
+        voice.startDelay = startDelays[v];
+        envelopes.store(v, voice);
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// One note of the built-in sound: a sine that decays towards the sustain level over
+// two seconds, as playChord in audio-utils.ts, then fades out after its length.
+//
+// Plain data, so a voice's whole state can be copied: the AttackCache renders a
+// chord's opening with these and hands the voices over mid-note.
+//
+// Voices are rendered in groups of up to envelopeLanes: their attack, decay and release
+// are worked out together in SIMD registers, one lane per voice, with no per-sample
+// branches. A release starts on the exact sample it was triggered at, whether by stop()
+// or by the note's length running out.
+struct SynthVoice
+{
+    static constexpr int envelopeLanes = 8;
+
+    static constexpr float attackSeconds = 0.002f;
+    static constexpr float decaySeconds = 2.0f;     // exponentialRampToValueAtTime(..., startTime + 2.0)
+    static constexpr float releaseSeconds = 0.05f;
+    static constexpr float noteGain = 0.5f;         // initialGain in audio-utils.ts
+    static constexpr float bassGain = 0.85f;
+
+    // Level is normalised by note count so a six-note chord isn't louder than a triad
+    static float getChordNoteGain(int numNotes) noexcept { return noteGain / std::sqrt((float) juce::jmax(1, numNotes)); }
+
+    // currentSustain * 100 ms
+    static juce::int64 getNoteLengthSamples(float sustainPercent, double sampleRate) noexcept
+    {
+        return (juce::int64) (sustainPercent / 10.0f * sampleRate);
+    }
+
+    // The parts of a note's envelope that only depend on the sound settings, worked out
+    // when those change rather than at every note-on
+    struct Shape
+    {
+        Shape() = default;
+        Shape(double sampleRate, float sustainPercent, float sampleStartMs);
+
+        float sampleRate = 44100.0f;
+        float sustainProportion = 1.0f;
+        float decayMultiplier = 1.0f;
+        float attackStep = 0.0f;
+        float endReleaseStep = 0.0f;
+        int skippedSamples = 0;       // Sample start
+        float skippedDecay = 1.0f;    // decayMultiplier ^ skippedSamples
+    };
+
+    bool active = false;
+    int sourceNote = -1;          // MIDI note or touch source that started it, -1 for neither
+    bool isBass = false;          // Bass voices follow 1 - fader, chord voices follow fader
+    int startDelay = 0;           // Samples of flam before the voice sounds
+    float phase = 0.0f;
+    float phaseIncrement = 0.0f;
+    float level = 0.0f;
+    float floorLevel = 0.0f;      // Level the decay settles at (sustain %)
+    float decayMultiplier = 1.0f;
+    float attackLevel = 0.0f;     // Short ramp so notes don't click in
+    float attackStep = 0.0f;
+    float releaseStep = 0.0f;     // > 0 while fading out
+    float releaseGain = 1.0f;
+    float endReleaseStep = 0.0f;  // Fade used when the note's length runs out
+    int samplesUntilRelease = 0;
+
+    // Sample start skips into the note, as starting a sample further in would. The
+    // frequency comes from a TuningTable.
+    void start(float frequency, float gain, bool isBassVoice, int sourceNoteToUse, int startDelaySamples,
+               int lengthSamples, const Shape& shape);
+
+    // Fades out over seconds. A voice still waiting out its start delay is dropped instead,
+    // unless it's already fading (one taking over from a cached attack mid-fade).
+    void stop(float seconds, double sampleRate) noexcept;
+    void startRelease(float seconds, double sampleRate) noexcept;
+
+    // Adds up to numSamples to left (and right, if not null), scaled sample by sample by busGains
+    void render(float* left, float* right, const float* busGains, int numSamples) noexcept;
+
+    // Renders numVoices (up to envelopeLanes) voices together, as render() would one by
+    // one; each follows chordGains or bassGains depending on isBass
+    static void renderVoices(SynthVoice* const* voicesToRender, int numVoices, float* left, float* right,
+                             const float* chordGains, const float* bassGains, int numSamples) noexcept;
+
+    float getLoudness() const noexcept { return level * releaseGain; }
+};
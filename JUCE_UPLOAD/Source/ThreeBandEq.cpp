@@ -0,0 +1,119 @@
+#include "ThreeBandEq.h"
+
+namespace
+{
+    constexpr float bandFrequencies[] = { 320.0f, 1000.0f, 3200.0f };
+    constexpr float peakQ = 1.0f;
+}
+
+void ThreeBandEq::prepare(double newSampleRate, int numChannels)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    channels = juce::jlimit(1, maxChannels, numChannels);
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        gains[band].reset(sampleRate, rampSeconds);
+        updateCoefficients((Band) band, gains[band].getCurrentValue());
+    }
+
+    reset();
+}
+
+void ThreeBandEq::reset()
+{
+    for (auto& bandStates : states)
+        for (auto& state : bandStates)
+            state = FilterState();
+}
+
+void ThreeBandEq::setTargetGains(float lowDb, float midDb, float highDb) noexcept
+{
+    gains[low].setTargetValue(juce::jlimit(-12.0f, 12.0f, lowDb));
+    gains[mid].setTargetValue(juce::jlimit(-12.0f, 12.0f, midDb));
+    gains[high].setTargetValue(juce::jlimit(-12.0f, 12.0f, highDb));
+}
+
+void ThreeBandEq::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    const int numChannels = juce::jmin(channels, buffer.getNumChannels());
+
+    while (numSamples > 0)
+    {
+        const int chunk = juce::jmin(numSamples, updateInterval);
+
+        for (int band = 0; band < numBands; ++band)
+        {
+            if (gains[band].isSmoothing())
+            {
+                gains[band].skip(chunk - 1);
+                updateCoefficients((Band) band, gains[band].getNextValue());
+            }
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* samples = buffer.getWritePointer(channel, startSample);
+
+            for (int band = 0; band < numBands; ++band)
+            {
+                const auto& c = coefficients[band];
+                auto& s = states[band][channel];
+
+                // Transposed direct form II
+                for (int i = 0; i < chunk; ++i)
+                {
+                    const float in = samples[i];
+                    const float out = c.b0 * in + s.z1;
+                    s.z1 = c.b1 * in - c.a1 * out + s.z2;
+                    s.z2 = c.b2 * in - c.a2 * out;
+                    samples[i] = out;
+                }
+            }
+        }
+
+        startSample += chunk;
+        numSamples -= chunk;
+    }
+}
+
+void ThreeBandEq::updateCoefficients(Band band, float gainDb) noexcept
+{
+    // RBJ cookbook filters; shelves use slope 1 as the Web Audio BiquadFilterNode does
+    const double A = std::pow(10.0, gainDb / 40.0);
+    const double w0 = juce::MathConstants<double>::twoPi * bandFrequencies[band] / sampleRate;
+    const double cosW0 = std::cos(w0);
+    const double sinW0 = std::sin(w0);
+
+    double b0, b1, b2, a0, a1, a2;
+
+    if (band == mid)
+    {
+        const double alpha = sinW0 / (2.0 * peakQ);
+        b0 = 1.0 + alpha * A;
+        b1 = -2.0 * cosW0;
+        b2 = 1.0 - alpha * A;
+        a0 = 1.0 + alpha / A;
+        a1 = -2.0 * cosW0;
+        a2 = 1.0 - alpha / A;
+    }
+    else
+    {
+        const double twoSqrtAAlpha = 2.0 * std::sqrt(A) * (sinW0 / 2.0 * std::sqrt(2.0));
+        const double sign = band == low ? 1.0 : -1.0; // The high shelf mirrors the low one
+
+        b0 = A * ((A + 1.0) - sign * (A - 1.0) * cosW0 + twoSqrtAAlpha);
+        b1 = sign * 2.0 * A * ((A - 1.0) - sign * (A + 1.0) * cosW0);
+        b2 = A * ((A + 1.0) - sign * (A - 1.0) * cosW0 - twoSqrtAAlpha);
+        a0 = (A + 1.0) + sign * (A - 1.0) * cosW0 + twoSqrtAAlpha;
+        a1 = -sign * 2.0 * ((A - 1.0) + sign * (A + 1.0) * cosW0);
+        a2 = (A + 1.0) + sign * (A - 1.0) * cosW0 - twoSqrtAAlpha;
+    }
+
+    auto& c = coefficients[band];
+    c.b0 = (float) (b0 / a0);
+    c.b1 = (float) (b1 / a0);
+    c.b2 = (float) (b2 / a0);
+    c.a1 = (float) (a1 / a0);
+    c.a2 = (float) (a2 / a0);
+}
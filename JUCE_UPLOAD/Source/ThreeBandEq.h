@@ -0,0 +1,51 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// The three-band EQ from initAudio in audio-utils.ts: low shelf at 320 Hz, peak at
+// 1 kHz (Q 1) and high shelf at 3.2 kHz, each +/-12 dB.
+//
+// Gain changes are ramped. While a ramp is running the coefficients are recomputed
+// every updateInterval samples, which is fine-grained enough not to zipper and
+// cheap enough for dense automation. Nothing allocates after prepare().
+class ThreeBandEq
+{
+public:
+    enum Band { low = 0, mid, high, numBands };
+
+    static constexpr int updateInterval = 16;
+
+    ThreeBandEq() = default;
+
+    void prepare(double newSampleRate, int numChannels);
+    void reset();
+
+    // Audio thread. Takes effect as a ramp over the next rampSeconds.
+    void setTargetGains(float lowDb, float midDb, float highDb) noexcept;
+
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+private:
+    struct Coefficients
+    {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    };
+
+    struct FilterState
+    {
+        float z1 = 0.0f, z2 = 0.0f;
+    };
+
+    static constexpr int maxChannels = 2;
+    static constexpr double rampSeconds = 0.05;
+
+    void updateCoefficients(Band band, float gainDb) noexcept;
+
+    double sampleRate = 44100.0;
+    int channels = 2;
+    juce::SmoothedValue<float> gains[numBands];
+    Coefficients coefficients[numBands];
+    FilterState states[numBands][maxChannels];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ThreeBandEq)
+};
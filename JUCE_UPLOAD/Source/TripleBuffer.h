@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Single-producer / single-consumer triple buffer.
+//
+// The writer always owns one slot it can fill at leisure; publish() swaps it with the
+// shared middle slot. The reader swaps the middle slot into its own slot only when
+// something new has been published. Neither side blocks or allocates, and the reader
+// always sees a complete value, never one that is half written.
+template <typename ValueType>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    //==============================================================================
+    // Writer side (one thread only)
+    ValueType& getWriteBuffer() noexcept { return slots[(std::size_t) writeIndex].value; }
+
+    void publish() noexcept
+    {
+        const int previous = middle.exchange(writeIndex | newDataFlag, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    //==============================================================================
+    // Reader side (one thread only). Returns the most recently published value.
+    const ValueType& read() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & newDataFlag) != 0)
+        {
+            const int previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+            readIndex = previous & indexMask;
+        }
+
+        return slots[(std::size_t) readIndex].value;
+    }
+
+    bool hasNewData() const noexcept { return (middle.load(std::memory_order_relaxed) & newDataFlag) != 0; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int newDataFlag = 4;
+
+    // Keep each slot on its own cache line so the two threads don't false-share
+    struct alignas(64) Slot { ValueType value {}; };
+
+    std::array<Slot, 3> slots {};
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> middle { 2 };
+};
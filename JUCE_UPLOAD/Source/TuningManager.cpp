@@ -0,0 +1,130 @@
+#include "TuningManager.h"
+#include "Identifiers.h"
+#include <iostream>
+
+namespace
+{
+    constexpr int collectIntervalMs = 50;
+}
+
+TuningManager::TuningManager(juce::ValueTree stateToUse)
+    : state(stateToUse)
+{
+    // Straight away, so the engine has a table from its first block; a scale follows shortly
+    publishTable(TuningTable::createEqualTemperament(getRequest().a4));
+    state.addListener(this);
+
+    if (getRequest().scale.isNotEmpty())
+        requestBuild();
+
+    startTimer(collectIntervalMs);
+}
+
+TuningManager::~TuningManager()
+{
+    stopTimer();
+    state.removeListener(this);
+    pool.removeAllJobs(true, 2000);
+}
+
+TuningManager::Request TuningManager::getRequest() const
+{
+    Request request;
+    request.a4 = state.getProperty(IDs::TUNING_A4, TuningTable::defaultA4);
+    request.scale = state.getProperty(IDs::TUNING_SCALE).toString();
+    request.keyboardMap = state.getProperty(IDs::TUNING_KEYBOARD_MAP).toString();
+    return request;
+}
+
+TuningTable::Ptr TuningManager::build(const Request& request, juce::String& error)
+{
+    if (request.scale.trim().isEmpty())
+        return TuningTable::createEqualTemperament(request.a4);
+
+    return TuningTable::createFromScala(request.scale, request.keyboardMap, request.a4, error);
+}
+
+void TuningManager::requestBuild()
+{
+    const auto request = getRequest();
+
+    juce::uint32 requestNumber;
+    {
+        const juce::ScopedLock sl(buildLock);
+        requestNumber = ++latestRequest;
+    }
+
+    pool.removeAllJobs(false, 0); // A build that hasn't started is out of date already
+    pool.addJob([this, request, requestNumber] {
+        juce::String error;
+        auto table = build(request, error);
+
+        const juce::ScopedLock sl(buildLock);
+        if (requestNumber != latestRequest)
+            return; // Superseded while it was building
+
+        builtTable = table;
+        buildError = error;
+        hasBuilt = true;
+    });
+}
+
+void TuningManager::buildNow()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    {
+        const juce::ScopedLock sl(buildLock);
+        ++latestRequest; // Anything still building is superseded
+        hasBuilt = true;
+        buildError.clear();
+        builtTable = build(getRequest(), buildError);
+    }
+
+    collectBuilt();
+}
+
+void TuningManager::collectBuilt()
+{
+    TuningTable::Ptr table;
+    juce::String error;
+    {
+        const juce::ScopedLock sl(buildLock);
+        if (!hasBuilt)
+            return;
+
+        table = builtTable;
+        error = buildError;
+        builtTable = nullptr;
+        hasBuilt = false;
+    }
+
+    lastError = error;
+
+    if (table == nullptr)
+    {
+        std::cout << "Tuning not loaded: " << error << std::endl;
+        return;
+    }
+
+    std::cout << "Tuning: " << table->getName() << std::endl;
+    publishTable(table);
+}
+
+void TuningManager::publishTable(TuningTable::Ptr table)
+{
+    currentTable = table;
+    tables.publish(table);
+}
+
+void TuningManager::timerCallback()
+{
+    collectBuilt();
+    tables.releaseUnused();
+}
+
+void TuningManager::valueTreePropertyChanged(juce::ValueTree& tree, const juce::Identifier& property)
+{
+    if (tree == state && (property == IDs::TUNING_A4 || property == IDs::TUNING_SCALE || property == IDs::TUNING_KEYBOARD_MAP))
+        requestBuild();
+}
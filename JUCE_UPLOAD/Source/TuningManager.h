@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "TuningTable.h"
+#include "RealtimeHandoff.h"
+
+// Keeps a TuningTable built for the tuning in the app state: TUNING_A4, plus the text of
+// a Scala scale and keyboard map when one has been loaded.
+//
+// Tables are built on a background thread whenever those change (parsing and the pow()
+// per note never happen on the audio thread) and handed to the audio thread whole through
+// a RealtimeHandoff. A scale that fails to parse is reported and the previous tuning stays.
+class TuningManager : private juce::ValueTree::Listener,
+                      private juce::Timer
+{
+public:
+    explicit TuningManager(juce::ValueTree stateToUse);
+    ~TuningManager() override;
+
+    // Message thread. The newest table built, which the audio thread gets next.
+    TuningTable::Ptr getCurrentTable() const { return currentTable; }
+
+    // Audio thread. Swaps a newly built table into current, if one is waiting.
+    void updateTable(TuningTable::Ptr& current) noexcept { tables.tryTake(current); }
+
+    // Message thread. Builds the current tuning right away instead of on the background
+    // thread, for hosts without a running message loop.
+    void buildNow();
+
+    // Message thread. Why the last scale didn't load; empty if it did.
+    const juce::String& getLastError() const noexcept { return lastError; }
+
+private:
+    struct Request
+    {
+        double a4 = TuningTable::defaultA4;
+        juce::String scale, keyboardMap;
+    };
+
+    Request getRequest() const;
+    static TuningTable::Ptr build(const Request& request, juce::String& error);
+
+    void requestBuild();
+    void collectBuilt();
+    void publishTable(TuningTable::Ptr table);
+
+    // juce::Timer - picks up built tables and frees ones the audio thread is done with
+    void timerCallback() override;
+
+    void valueTreePropertyChanged(juce::ValueTree& tree, const juce::Identifier& property) override;
+    void valueTreeChildAdded(juce::ValueTree&, juce::ValueTree&) override {}
+    void valueTreeChildRemoved(juce::ValueTree&, juce::ValueTree&, int) override {}
+    void valueTreeChildOrderChanged(juce::ValueTree&, int, int) override {}
+    void valueTreeParentChanged(juce::ValueTree&) override {}
+
+    juce::ValueTree state;
+    TuningTable::Ptr currentTable;
+    juce::String lastError;
+
+    juce::CriticalSection buildLock;
+    juce::uint32 latestRequest = 0;              // Guarded by buildLock; older builds are dropped
+    TuningTable::Ptr builtTable;                 // Guarded by buildLock
+    juce::String buildError;                     // Guarded by buildLock
+    bool hasBuilt = false;                       // Guarded by buildLock
+
+    RealtimeHandoff<TuningTable> tables;
+
+    juce::ThreadPool pool { 1 };                 // Last, so its jobs are gone before anything they use
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TuningManager)
+};
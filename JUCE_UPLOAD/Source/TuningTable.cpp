@@ -0,0 +1,186 @@
+#include "TuningTable.h"
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    // Lines that aren't '!' comments, each trimmed. Blank ones count: a scale's description may be empty.
+    juce::StringArray getScalaLines(const juce::String& text)
+    {
+        juce::StringArray lines;
+        for (const auto& line : juce::StringArray::fromLines(text))
+        {
+            if (line.startsWithChar('!'))
+                continue;
+
+            lines.add(line.trim());
+        }
+
+        return lines;
+    }
+
+    // A scale degree: cents if it has a '.', otherwise a ratio ("3/2") or a whole number ("2")
+    bool parsePitch(const juce::String& line, double& cents)
+    {
+        const auto text = line.upToFirstOccurrenceOf(" ", false, false).upToFirstOccurrenceOf("\t", false, false);
+        if (text.isEmpty())
+            return false;
+
+        if (text.containsChar('.'))
+        {
+            cents = text.getDoubleValue();
+            return text.containsOnly("0123456789.-+");
+        }
+
+        if (!text.containsOnly("0123456789/"))
+            return false;
+
+        const double numerator = text.upToFirstOccurrenceOf("/", false, false).getDoubleValue();
+        const double denominator = text.containsChar('/') ? text.fromFirstOccurrenceOf("/", false, false).getDoubleValue() : 1.0;
+        if (numerator <= 0.0 || denominator <= 0.0)
+            return false;
+
+        cents = 1200.0 * std::log2(numerator / denominator);
+        return true;
+    }
+
+    // First whitespace-separated word of a .kbm line
+    juce::String firstWord(const juce::String& line)
+    {
+        return line.upToFirstOccurrenceOf(" ", false, false).upToFirstOccurrenceOf("\t", false, false);
+    }
+
+    double equalTemperamentFrequency(int midiNote, double a4Hz)
+    {
+        return a4Hz * std::pow(2.0, (midiNote - 69) / 12.0);
+    }
+}
+
+//==============================================================================
+void TuningTable::setFrequency(int midiNote, double frequency) noexcept
+{
+    frequencies[(size_t) midiNote] = (float) frequency;
+    playbackRates[(size_t) midiNote] = (float) (frequency / equalTemperamentFrequency(midiNote, defaultA4));
+}
+
+TuningTable::Ptr TuningTable::createEqualTemperament(double a4Hz)
+{
+    a4Hz = juce::jlimit(minA4, maxA4, a4Hz);
+
+    Ptr table(new TuningTable());
+    table->name = "12-TET, A4 = " + juce::String(a4Hz, 1) + " Hz";
+
+    for (int note = 0; note < numNotes; ++note)
+        table->setFrequency(note, equalTemperamentFrequency(note, a4Hz));
+
+    return table;
+}
+
+TuningTable::Ptr TuningTable::createFromScala(const juce::String& scale, const juce::String& keyboardMap, double a4Hz, juce::String& error)
+{
+    a4Hz = juce::jlimit(minA4, maxA4, a4Hz);
+
+    // .scl: description, number of degrees, then each degree above the 1/1; the last is the period
+    const auto scaleLines = getScalaLines(scale);
+    const int numDegrees = scaleLines.size() > 1 ? firstWord(scaleLines[1]).getIntValue() : 0;
+    if (numDegrees <= 0 || scaleLines.size() < 2 + numDegrees)
+    {
+        error = "Scale file has no degrees, or fewer than it says";
+        return nullptr;
+    }
+
+    std::vector<double> degreeCents((size_t) numDegrees + 1, 0.0);
+    for (int i = 1; i <= numDegrees; ++i)
+    {
+        if (!parsePitch(scaleLines[i + 1], degreeCents[(size_t) i]))
+        {
+            error = "Scale degree " + juce::String(i) + " isn't cents or a ratio: " + scaleLines[i + 1];
+            return nullptr;
+        }
+    }
+
+    const double period = degreeCents[(size_t) numDegrees];
+
+    // Degrees beyond the scale continue into the next period
+    auto centsOfDegree = [&](int degree) {
+        const int periods = (int) std::floor((double) degree / numDegrees);
+        return periods * period + degreeCents[(size_t) (degree - periods * numDegrees)];
+    };
+
+    // .kbm: map size, first and last note, middle note, reference note and frequency,
+    // formal octave degree, then one degree (or 'x' for unmapped) per key of the map
+    int mapSize = 0, firstNote = 0, lastNote = numNotes - 1, middleNote = 60, referenceNote = 69, octaveDegree = numDegrees;
+    double referenceFrequency = a4Hz;
+    std::vector<int> mapping;
+
+    if (keyboardMap.trim().isNotEmpty())
+    {
+        const auto mapLines = getScalaLines(keyboardMap);
+        if (mapLines.size() < 7)
+        {
+            error = "Keyboard map is missing its header";
+            return nullptr;
+        }
+
+        mapSize = juce::jmax(0, firstWord(mapLines[0]).getIntValue());
+        firstNote = juce::jlimit(0, numNotes - 1, firstWord(mapLines[1]).getIntValue());
+        lastNote = juce::jlimit(0, numNotes - 1, firstWord(mapLines[2]).getIntValue());
+        middleNote = firstWord(mapLines[3]).getIntValue();
+        referenceNote = juce::jlimit(0, numNotes - 1, firstWord(mapLines[4]).getIntValue());
+        referenceFrequency = firstWord(mapLines[5]).getDoubleValue();
+        octaveDegree = firstWord(mapLines[6]).getIntValue();
+
+        if (referenceFrequency <= 0.0)
+        {
+            error = "Keyboard map's reference frequency must be above 0";
+            return nullptr;
+        }
+
+        // Keys missing from the end of the map are unmapped
+        for (int i = 0; i < mapSize; ++i)
+        {
+            const auto entry = 7 + i < mapLines.size() ? firstWord(mapLines[7 + i]) : juce::String("x");
+            mapping.push_back(entry.equalsIgnoreCase("x") ? -1 : entry.getIntValue());
+        }
+    }
+
+    const double mapPeriod = octaveDegree > 0 ? centsOfDegree(octaveDegree) : period;
+
+    // Cents above the middle note's 1/1, or false for an unmapped note
+    auto noteCents = [&](int note, double& cents) {
+        const int steps = note - middleNote;
+
+        if (mapSize == 0)
+        {
+            cents = centsOfDegree(steps);
+            return true;
+        }
+
+        const int repeats = (int) std::floor((double) steps / mapSize);
+        const int degree = mapping[(size_t) (steps - repeats * mapSize)];
+        if (degree < 0)
+            return false;
+
+        cents = repeats * mapPeriod + centsOfDegree(degree);
+        return true;
+    };
+
+    double referenceCents = 0.0;
+    if (!noteCents(referenceNote, referenceCents))
+    {
+        error = "Keyboard map leaves its own reference note unmapped";
+        return nullptr;
+    }
+
+    Ptr table(new TuningTable());
+    table->name = scaleLines[0].isNotEmpty() ? scaleLines[0] : juce::String("Scala tuning");
+
+    for (int note = 0; note < numNotes; ++note)
+    {
+        double cents = 0.0;
+        const bool isMapped = note >= firstNote && note <= lastNote && noteCents(note, cents);
+        table->setFrequency(note, isMapped ? referenceFrequency * std::pow(2.0, (cents - referenceCents) / 1200.0) : 0.0);
+    }
+
+    return table;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// Frequency of every MIDI note, worked out once so starting a note is a table lookup
+// rather than a pow(). Built for 12-TET at any A4, or from a Scala scale (.scl) with an
+// optional keyboard mapping (.kbm), following the formats at huygens-fokker.org/scala.
+//
+// Tables never change once built: the TuningManager builds new ones off the audio
+// thread and swaps them in whole.
+class TuningTable : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<TuningTable>;
+
+    static constexpr int numNotes = 128;
+    static constexpr double defaultA4 = 440.0;
+    static constexpr double minA4 = 392.0;
+    static constexpr double maxA4 = 494.0;
+
+    static Ptr createEqualTemperament(double a4Hz);
+
+    // Without a keyboard map, note 60 is the scale's 1/1 and note 69 sounds at a4Hz, as
+    // Scala's default; a map brings its own reference note and frequency. Returns nullptr
+    // and sets error if either file doesn't parse.
+    static Ptr createFromScala(const juce::String& scale, const juce::String& keyboardMap, double a4Hz, juce::String& error);
+
+    // 0 for a note the keyboard map leaves unmapped: it isn't played
+    float getFrequency(int midiNote) const noexcept { return frequencies[(size_t) juce::jlimit(0, numNotes - 1, midiNote)]; }
+
+    // Relative to 12-TET at A4 = 440 Hz, for anything that plays recordings back
+    float getPlaybackRate(int midiNote) const noexcept { return playbackRates[(size_t) juce::jlimit(0, numNotes - 1, midiNote)]; }
+
+    const juce::String& getName() const noexcept { return name; }
+
+private:
+    TuningTable() = default;
+
+    void setFrequency(int midiNote, double frequency) noexcept;
+
+    std::array<float, numNotes> frequencies {};
+    std::array<float, numNotes> playbackRates {};
+    juce::String name;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TuningTable)
+};
@@ -0,0 +1,211 @@
+#include "VoiceLeading.h"
+#include "EngineState.h"
+#include "MusicTheory.h"
+#include "VoicingEngine.h"
+
+namespace VoiceLeading
+{
+    namespace
+    {
+        // Notes are ascending, so the nearest match can be found with one forward sweep
+        int sumOfNearestDistances(const Voicing& source, const Voicing& target, int total, int limit) noexcept
+        {
+            int j = 0;
+            for (int i = 0; i < source.numNotes && total < limit; ++i)
+            {
+                const int note = source.notes[i];
+                while (j + 1 < target.numNotes && std::abs(target.notes[j + 1] - note) <= std::abs(target.notes[j] - note))
+                    ++j;
+
+                total += std::abs(target.notes[j] - note);
+            }
+
+            return total;
+        }
+
+        // Second-highest note down an octave for 4+ note chords, middle note up an octave for triads
+        Voicing spread(const Voicing& closeVoicing)
+        {
+            Voicing result = closeVoicing;
+            const int n = result.numNotes;
+            if (n < 3)
+                return result;
+
+            if (n >= 4)
+            {
+                const int dropped = result.notes[n - 2] - 12;
+                if (dropped < 0)
+                    return result;
+
+                std::copy_backward(result.notes, result.notes + n - 2, result.notes + n - 1);
+                result.notes[0] = (juce::uint8) dropped;
+            }
+            else
+            {
+                const int raised = result.notes[1] + 12;
+                if (raised > 127)
+                    return result;
+
+                result.notes[1] = result.notes[2];
+                result.notes[2] = (juce::uint8) raised;
+            }
+
+            return result;
+        }
+
+        bool sameNotes(const Voicing& a, const Voicing& b) noexcept
+        {
+            return a.numNotes == b.numNotes && std::equal(a.notes, a.notes + a.numNotes, b.notes);
+        }
+
+        // Chords with fewer notes than inversion steps come round to the same notes; keep one copy.
+        // Returns the candidate's index, or -1 if it has nothing to play.
+        int addCandidate(Candidates& dest, const Voicing& candidate) noexcept
+        {
+            const int existing = findCandidate(dest, candidate);
+            if (existing >= 0 || !candidate.isPlayable())
+                return existing;
+
+            dest.voicings[dest.numCandidates] = candidate;
+            return dest.numCandidates++;
+        }
+    }
+
+    int findCandidate(const Candidates& candidates, const Voicing& voicing) noexcept
+    {
+        for (int i = 0; i < candidates.numCandidates; ++i)
+            if (sameNotes(candidates.voicings[i], voicing))
+                return i;
+
+        return -1;
+    }
+
+    int getMovementCost(const Voicing& from, const Voicing& to, int limit) noexcept
+    {
+        if (from.numNotes == 0 || to.numNotes == 0)
+            return 0;
+
+        const int total = sumOfNearestDistances(to, from, 0, limit);
+        return total < limit ? sumOfNearestDistances(from, to, total, limit) : total;
+    }
+
+    void buildCandidates(EngineState& state)
+    {
+        for (int index = 0; index < AppStateModel::numSlots; ++index)
+        {
+            auto& dest = state.candidates[index];
+            dest = {};
+
+            const auto& base = state.voicings[index];
+            if (!base.isPlayable())
+                continue;
+
+            const int keyIndex = index / AppStateModel::maxSlotsPerKey;
+            for (int inversion = minInversion; inversion <= maxInversion; ++inversion)
+            {
+                const auto closeVoicing = VoicingEngine::buildVoicing(keyIndex, base.chordType, state.octave, inversion, state.bassOffset[index]);
+                const int closeIndex = addCandidate(dest, closeVoicing);
+                addCandidate(dest, spread(closeVoicing));
+
+                // The default may have come round to an earlier inversion's notes; it points at that copy
+                if (inversion == state.inversion && closeIndex >= 0)
+                    dest.defaultCandidate = (juce::uint8) closeIndex;
+            }
+        }
+    }
+
+    const Voicing& chooseVoicing(const Candidates& candidates, const Voicing* previous) noexcept
+    {
+        const auto& defaultVoicing = candidates.voicings[candidates.defaultCandidate];
+        if (previous == nullptr || !previous->isPlayable() || candidates.numCandidates == 0)
+            return defaultVoicing;
+
+        // Branch and bound: the best cost so far is the limit for every later candidate
+        int bestIndex = candidates.defaultCandidate;
+        int bestCost = getMovementCost(*previous, defaultVoicing);
+
+        for (int i = 0; i < candidates.numCandidates && bestCost > 0; ++i)
+        {
+            const int cost = getMovementCost(*previous, candidates.voicings[i], bestCost);
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestIndex = i;
+            }
+        }
+
+        return candidates.voicings[bestIndex];
+    }
+
+    void optimiseProgression(const EngineState& state, const Step* steps, int numSteps, Voicing* dest)
+    {
+        // Steps with nothing to play (out of scale) are skipped; the chords either side are led into each other
+        std::vector<const Candidates*> playable;
+        std::vector<int> playableStep;
+        for (int step = 0; step < numSteps; ++step)
+        {
+            const auto keyIndex = juce::jlimit(0, AppStateModel::numKeys - 1, steps[step].keyIndex);
+            const auto slotIndex = juce::jlimit(0, AppStateModel::maxSlotsPerKey - 1, steps[step].slotIndex);
+            const auto& candidates = state.candidates[AppStateModel::getFlatSlotIndex(keyIndex, slotIndex)];
+
+            dest[step] = Voicing();
+            if (candidates.numCandidates > 0)
+            {
+                playable.push_back(&candidates);
+                playableStep.push_back(step);
+            }
+        }
+
+        const size_t n = playable.size();
+        if (n == 0)
+            return;
+
+        // totalCost[i][c] = cheapest way to reach candidate c of playable step i
+        std::vector<std::array<int, maxCandidates>> totalCost(n);
+        std::vector<std::array<juce::uint8, maxCandidates>> cameFrom(n);
+
+        for (int c = 0; c < playable[0]->numCandidates; ++c)
+            totalCost[0][(size_t) c] = c == playable[0]->defaultCandidate ? 0 : 1; // Start from the chosen inversion when it's as good
+
+        for (size_t i = 1; i < n; ++i)
+        {
+            const auto& previous = *playable[i - 1];
+            const auto& current = *playable[i];
+
+            for (int c = 0; c < current.numCandidates; ++c)
+            {
+                int best = std::numeric_limits<int>::max();
+                int bestFrom = 0;
+
+                for (int p = 0; p < previous.numCandidates; ++p)
+                {
+                    const int base = totalCost[i - 1][(size_t) p];
+                    if (base >= best)
+                        continue; // Can't beat the best path found so far
+
+                    const int cost = base + getMovementCost(previous.voicings[p], current.voicings[c], best - base);
+                    if (cost < best)
+                    {
+                        best = cost;
+                        bestFrom = p;
+                    }
+                }
+
+                totalCost[i][(size_t) c] = best;
+                cameFrom[i][(size_t) c] = (juce::uint8) bestFrom;
+            }
+        }
+
+        // Walk back from the cheapest final candidate
+        int chosen = 0;
+        for (int c = 1; c < playable[n - 1]->numCandidates; ++c)
+            if (totalCost[n - 1][(size_t) c] < totalCost[n - 1][(size_t) chosen])
+                chosen = c;
+
+        for (size_t i = n; i-- > 0;)
+        {
+            dest[playableStep[i]] = playable[i]->voicings[chosen];
+            chosen = cameFrom[i][(size_t) chosen];
+        }
+    }
+}
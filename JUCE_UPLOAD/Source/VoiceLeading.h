@@ -0,0 +1,55 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Voicing.h"
+
+struct EngineState;
+
+// "Smooth voicing": instead of the fixed INVERSION_VALUE, each press picks whichever
+// voicing of the chord moves the fewest semitones from the previous chord.
+//
+// The candidates (every inversion in INVERSION_VALUE's -2..+3 range, close and spread)
+// are built per slot when the state is compiled, so they're already there for the
+// current key and mode. Live selection is then a pruned scan over at most
+// maxCandidates small sorted arrays - a few hundred integer operations.
+namespace VoiceLeading
+{
+    constexpr int minInversion = -2;
+    constexpr int maxInversion = 3;
+    constexpr int numSpreads = 2; // Close position and spread (drop-2 / open triad)
+    constexpr int maxCandidates = (maxInversion - minInversion + 1) * numSpreads;
+
+    struct Candidates
+    {
+        juce::uint8 numCandidates = 0;
+        juce::uint8 defaultCandidate = 0; // The one matching INVERSION_VALUE in close position
+        Voicing voicings[maxCandidates] = {};
+    };
+
+    // Semitones of movement between two chords: each note of one is matched to the
+    // nearest note of the other, in both directions. Stops early and returns something
+    // >= limit once the running total reaches limit.
+    int getMovementCost(const Voicing& from, const Voicing& to, int limit = std::numeric_limits<int>::max()) noexcept;
+
+    // Fills state.candidates from state.voicings' inputs. Message thread only.
+    void buildCandidates(EngineState& state);
+
+    // Best candidate to follow `previous`. With no previous chord this is the default voicing.
+    // Ties go to the default, so a progression that's already smooth keeps the chosen inversion.
+    const Voicing& chooseVoicing(const Candidates& candidates, const Voicing* previous) noexcept;
+
+    // Index of the candidate with the same notes as voicing, or -1 if there isn't one
+    int findCandidate(const Candidates& candidates, const Voicing& voicing) noexcept;
+
+    // One chord of a progression: the key and the slot on it that was pressed
+    struct Step
+    {
+        int keyIndex = 0;
+        int slotIndex = 0;
+    };
+
+    // Offline: picks the voicing of every step so the total movement across the whole
+    // progression is minimal (Viterbi over the candidates of consecutive steps).
+    // dest receives one voicing per step; steps with nothing to play get an empty one.
+    void optimiseProgression(const EngineState& state, const Step* steps, int numSteps, Voicing* dest);
+}
@@ -0,0 +1,356 @@
+#include "VoiceRenderPool.h"
+
+#if JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#elif JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <semaphore.h>
+ #include <cerrno>
+#endif
+
+namespace
+{
+    enum WorkerState { idle, signalled, running };
+
+    // Counting semaphore for waking the workers. signal() is an atomic add, plus a call into
+    // the OS only when a worker is actually asleep; unlike WaitableEvent it never takes a
+    // mutex, so the audio thread can't be held up by a worker holding it.
+    class WakeSemaphore
+    {
+    public:
+        WakeSemaphore()
+        {
+           #if JUCE_MAC || JUCE_IOS
+            semaphore = dispatch_semaphore_create(0);
+           #elif JUCE_WINDOWS
+            semaphore = CreateSemaphoreW(nullptr, 0, 0x7fffffff, nullptr);
+           #else
+            sem_init(&semaphore, 0, 0);
+           #endif
+        }
+
+        ~WakeSemaphore()
+        {
+           #if JUCE_MAC || JUCE_IOS
+            dispatch_release(semaphore);
+           #elif JUCE_WINDOWS
+            CloseHandle(semaphore);
+           #else
+            sem_destroy(&semaphore);
+           #endif
+        }
+
+        void signal() noexcept
+        {
+            // A negative count is the number of threads asleep in wait()
+            if (count.fetch_add(1, std::memory_order_release) < 0)
+            {
+               #if JUCE_MAC || JUCE_IOS
+                dispatch_semaphore_signal(semaphore);
+               #elif JUCE_WINDOWS
+                ReleaseSemaphore(semaphore, 1, nullptr);
+               #else
+                sem_post(&semaphore);
+               #endif
+            }
+        }
+
+        void wait() noexcept
+        {
+            if (count.fetch_sub(1, std::memory_order_acquire) > 0)
+                return;
+
+           #if JUCE_MAC || JUCE_IOS
+            dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+           #elif JUCE_WINDOWS
+            WaitForSingleObject(semaphore, INFINITE);
+           #else
+            while (sem_wait(&semaphore) != 0 && errno == EINTR) {}
+           #endif
+        }
+
+    private:
+        std::atomic<int> count { 0 };
+
+       #if JUCE_MAC || JUCE_IOS
+        dispatch_semaphore_t semaphore;
+       #elif JUCE_WINDOWS
+        HANDLE semaphore;
+       #else
+        sem_t semaphore;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(WakeSemaphore)
+    };
+}
+
+//==============================================================================
+class VoiceRenderPool::Worker : public juce::Thread
+{
+public:
+    Worker(Workers& ownerToUse, int participantIndex)
+        : juce::Thread("PianoXL voices " + juce::String(participantIndex)),
+          owner(ownerToUse),
+          participant(participantIndex)
+    {
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        wakeUp.signal();
+        stopThread(1000);
+    }
+
+    // Audio thread, once per block the workers are taken for
+    void wake() noexcept
+    {
+        wakeUp.signal();
+    }
+
+    // Audio thread, per render() call; the worker is already awake and waiting for it
+    void start() noexcept
+    {
+        state.store(signalled, std::memory_order_release);
+    }
+
+    // Audio thread, once every chunk has been taken
+    void finish() noexcept
+    {
+        // Never got going: its chunks were all taken by the others
+        int expected = signalled;
+        if (state.compare_exchange_strong(expected, idle, std::memory_order_acq_rel))
+            return;
+
+        // Still on its last chunk
+        while (state.load(std::memory_order_acquire) == running)
+            juce::Thread::yield();
+    }
+
+private:
+    void run() override;
+
+    Workers& owner;
+    const int participant;
+    std::atomic<int> state { idle };
+    WakeSemaphore wakeUp;
+};
+
+//==============================================================================
+// The process's worker threads, shared by every pool through a SharedResourcePointer.
+// One pool at a time takes them, for a block at a time.
+class VoiceRenderPool::Workers
+{
+public:
+    Workers()
+    {
+        // At least one, so a pool asked for workers on a single core still gets to use them
+        const int numWorkers = juce::jlimit(1, maxWorkers, juce::SystemStats::getNumCpus() - 1);
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            workers.push_back(std::make_unique<Worker>(*this, i + 1));
+
+            // Real-time priority where the OS allows it, so workers aren't the ones left waiting
+            if (!workers.back()->startRealtimeThread(juce::Thread::RealtimeOptions{}.withMaximumProcessingTimeMs(5.0)))
+                workers.back()->startThread(juce::Thread::Priority::highest);
+        }
+    }
+
+    ~Workers()
+    {
+        workers.clear();
+    }
+
+    int getNumWorkers() const noexcept { return (int) workers.size(); }
+    Worker& getWorker(int index) noexcept { return *workers[(size_t) index]; }
+
+    // Audio thread. Fails while another pool has them.
+    bool tryTake(VoiceRenderPool& pool) noexcept
+    {
+        VoiceRenderPool* expected = nullptr;
+        return taker.compare_exchange_strong(expected, &pool, std::memory_order_acq_rel);
+    }
+
+    void release() noexcept { taker.store(nullptr, std::memory_order_release); }
+
+    VoiceRenderPool* getTaker() const noexcept { return taker.load(std::memory_order_acquire); }
+
+private:
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<VoiceRenderPool*> taker { nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE(Workers)
+};
+
+void VoiceRenderPool::Worker::run()
+{
+    while (!threadShouldExit())
+    {
+        wakeUp.wait();
+
+        // Every render() call of the block, until the pool that took the workers lets them go
+        while (owner.getTaker() != nullptr && !threadShouldExit())
+        {
+            int expected = signalled;
+            if (state.compare_exchange_strong(expected, running, std::memory_order_acq_rel))
+            {
+                // Only the pool holding the workers signals them, and it can't let go until this finishes
+                owner.getTaker()->renderChunks(participant);
+                state.store(idle, std::memory_order_release);
+            }
+            else
+            {
+                juce::Thread::yield();
+            }
+        }
+    }
+}
+
+//==============================================================================
+VoiceRenderPool::VoiceRenderPool(int numWorkers)
+    : numWorkersWanted(numWorkers >= 0 ? juce::jmin(numWorkers, maxWorkers)
+                                       : juce::jlimit(0, maxWorkers, juce::SystemStats::getNumCpus() - 1))
+{
+}
+
+VoiceRenderPool::~VoiceRenderPool()
+{
+    jassert(!hasWorkersForBlock);
+    workers = nullptr;
+}
+
+void VoiceRenderPool::prepare(int maximumBlockSize, int maximumVoices)
+{
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+    activeVoices.allocate((size_t) juce::jmax(1, maximumVoices), true);
+
+    if (numWorkersWanted > 0)
+    {
+        workerMixes.setSize(2 * numWorkersWanted, maxBlockSize, false, true, true);
+
+        if (workers == nullptr)
+            workers = std::make_unique<juce::SharedResourcePointer<Workers>>();
+    }
+}
+
+int VoiceRenderPool::getNumWorkers() const noexcept
+{
+    return workers != nullptr ? juce::jmin(numWorkersWanted, (*workers)->getNumWorkers()) : 0;
+}
+
+void VoiceRenderPool::beginBlock(const SynthVoice* voices, int numVoices) noexcept
+{
+    jassert(!hasWorkersForBlock);
+
+    const int numWorkers = getNumWorkers();
+    if (numWorkers == 0)
+        return;
+
+    int numActive = 0;
+    for (int i = 0; i < numVoices; ++i)
+        numActive += voices[i].active ? 1 : 0;
+
+    if (numActive < minVoicesForThreads || !(*workers)->tryTake(*this))
+        return;
+
+    hasWorkersForBlock = true;
+    for (int w = 0; w < numWorkers; ++w)
+        (*workers)->getWorker(w).wake();
+}
+
+void VoiceRenderPool::endBlock() noexcept
+{
+    if (!hasWorkersForBlock)
+        return;
+
+    hasWorkersForBlock = false;
+    (*workers)->release();
+}
+
+void VoiceRenderPool::render(SynthVoice* voices, int numVoices, float* left, float* right,
+                             const float* chordGainsToUse, const float* bassGainsToUse, int numSamplesToRender) noexcept
+{
+    jassert(numSamplesToRender <= maxBlockSize);
+
+    numActiveVoices = 0;
+    for (int i = 0; i < numVoices; ++i)
+        if (voices[i].active)
+            activeVoices[numActiveVoices++] = voices + i;
+
+    audioLeft = left;
+    audioRight = right;
+    chordGains = chordGainsToUse;
+    bassGains = bassGainsToUse;
+    numSamples = numSamplesToRender;
+
+    const int numChunks = (numActiveVoices + voicesPerChunk - 1) / voicesPerChunk;
+    lastBlockThreaded = hasWorkersForBlock && numActiveVoices >= minVoicesForThreads && numChunks > 1;
+    numParticipants = lastBlockThreaded ? juce::jmin(numChunks, getNumWorkers() + 1) : 1;
+
+    // Contiguous shares, so a participant's chunks are next to each other in memory
+    for (int p = 0; p < numParticipants; ++p)
+    {
+        nextChunk[(size_t) p].store(numChunks * p / numParticipants, std::memory_order_relaxed);
+        endChunk[(size_t) p] = numChunks * (p + 1) / numParticipants;
+        hasRendered[(size_t) p] = false;
+    }
+
+    for (int p = 1; p < numParticipants; ++p)
+        (*workers)->getWorker(p - 1).start();
+
+    renderChunks(0);
+
+    for (int p = 1; p < numParticipants; ++p)
+    {
+        (*workers)->getWorker(p - 1).finish();
+        if (!hasRendered[(size_t) p])
+            continue;
+
+        juce::FloatVectorOperations::add(left, workerMixes.getReadPointer(2 * (p - 1)), numSamples);
+        if (right != nullptr)
+            juce::FloatVectorOperations::add(right, workerMixes.getReadPointer(2 * (p - 1) + 1), numSamples);
+    }
+}
+
+void VoiceRenderPool::renderChunks(int participant) noexcept
+{
+    float* left = audioLeft;
+    float* right = audioRight;
+    if (participant > 0)
+    {
+        left = workerMixes.getWritePointer(2 * (participant - 1));
+        right = workerMixes.getWritePointer(2 * (participant - 1) + 1);
+    }
+
+    // Own share first, then whatever is left of everyone else's
+    for (int offset = 0; offset < numParticipants; ++offset)
+    {
+        const int victim = (participant + offset) % numParticipants;
+        auto& cursor = nextChunk[(size_t) victim];
+
+        for (int chunk = cursor.fetch_add(1, std::memory_order_relaxed); chunk < endChunk[(size_t) victim];
+             chunk = cursor.fetch_add(1, std::memory_order_relaxed))
+        {
+            if (participant > 0 && !hasRendered[(size_t) participant])
+            {
+                juce::FloatVectorOperations::clear(left, numSamples);
+                juce::FloatVectorOperations::clear(right, numSamples);
+                hasRendered[(size_t) participant] = true;
+            }
+
+            renderChunk(chunk, left, right);
+        }
+    }
+}
+
+void VoiceRenderPool::renderChunk(int chunk, float* left, float* right) noexcept
+{
+    const int start = chunk * voicesPerChunk;
+    const int end = juce::jmin(numActiveVoices, start + voicesPerChunk);
+
+    SynthVoice::renderVoices(activeVoices + start, end - start, left, right, chordGains, bassGains, numSamples);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include "SynthVoice.h"
+
+// Spreads one block's voice rendering across a few real-time worker threads.
+//
+// The active voices are cut into small chunks and every participant (the audio thread
+// plus each worker) starts on its own share. Each share has an atomic cursor, so
+// whoever runs out first steals chunks from the others without any locks. Workers mix
+// into their own buffers, and the audio thread adds those up at the end.
+//
+// The workers belong to the process, not to one plugin instance: every pool shares the
+// same few threads, and an instance takes them for a whole block at a time. They're woken
+// once per block, through a semaphore that never takes a lock, and then wait for each
+// render() call of the block by spinning, since a block is rendered in several pieces
+// (one per MIDI event). A block that starts with too few voices, or while another
+// instance has the workers, stays on the audio thread.
+//
+// A worker that hasn't picked up a render() call by the time every chunk is taken is
+// simply skipped, so the audio thread only ever waits for chunks that are actually being
+// rendered. Below minVoicesForThreads active voices, or with no spare cores, everything
+// stays on the audio thread - waking threads would cost more than it saves.
+class VoiceRenderPool
+{
+public:
+    static constexpr int maxWorkers = 3;
+    static constexpr int voicesPerChunk = SynthVoice::envelopeLanes; // One chunk's envelopes run side by side
+    static constexpr int minVoicesForThreads = 24;
+
+    // Uses up to numWorkers of the shared workers; < 0 picks one per spare core, up to maxWorkers
+    explicit VoiceRenderPool(int numWorkers = -1);
+    ~VoiceRenderPool();
+
+    // Message thread. Sizes the mix buffers and starts the shared workers on first use.
+    void prepare(int maximumBlockSize, int maximumVoices);
+
+    // Audio thread, around the render() calls of one block. Takes the workers for the
+    // block if it starts with enough active voices and no other instance has them.
+    void beginBlock(const SynthVoice* voices, int numVoices) noexcept;
+    void endBlock() noexcept;
+
+    // Audio thread. Adds every active voice in voices to left (and right, if not null).
+    void render(SynthVoice* voices, int numVoices, float* left, float* right,
+                const float* chordGains, const float* bassGains, int numSamples) noexcept;
+
+    int getNumWorkers() const noexcept;
+
+    // Blocks the last render() split across threads
+    bool wasLastBlockThreaded() const noexcept { return lastBlockThreaded; }
+
+private:
+    class Worker;
+    class Workers;
+
+    static constexpr int maxParticipants = maxWorkers + 1; // Index 0 is the audio thread
+
+    // Renders chunks until none are left anywhere, starting with participant's own share
+    void renderChunks(int participant) noexcept;
+    void renderChunk(int chunk, float* left, float* right) noexcept;
+
+    const int numWorkersWanted;
+    std::unique_ptr<juce::SharedResourcePointer<Workers>> workers;
+    bool hasWorkersForBlock = false;
+    int maxBlockSize = 0;
+
+    // Each worker's own mix, two channels apiece
+    juce::AudioBuffer<float> workerMixes;
+
+    // The current render() call's job, written by the audio thread before any worker is signalled
+    juce::HeapBlock<SynthVoice*> activeVoices;
+    int numActiveVoices = 0;
+    float* audioLeft = nullptr;
+    float* audioRight = nullptr;
+    const float* chordGains = nullptr;
+    const float* bassGains = nullptr;
+    int numSamples = 0;
+    int numParticipants = 1;
+    std::array<std::atomic<int>, maxParticipants> nextChunk {};
+    std::array<int, maxParticipants> endChunk {};
+    std::array<bool, maxParticipants> hasRendered {}; // Mix buffer cleared and written by this call
+
+    bool lastBlockThreaded = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoiceRenderPool)
+};
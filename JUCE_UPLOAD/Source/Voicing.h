@@ -0,0 +1,21 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <type_traits>
+
+// The concrete MIDI notes for one slot: chord voicing plus the separate bass note.
+// Stored by value in EngineState so a key press is a plain copy.
+struct Voicing
+{
+    static constexpr int maxNotes = 8;
+
+    juce::uint8 numNotes = 0;          // 0 = nothing to play (key out of scale)
+    juce::uint8 notes[maxNotes] = {};  // Ascending
+    juce::int8 bassNote = -1;          // -1 = no bass
+    juce::int8 chordType = -1;         // MusicTheory chord type id
+    juce::int8 root = 0;               // Pitch class of the slot's key
+
+    bool isPlayable() const noexcept { return numNotes > 0; }
+};
+
+static_assert(std::is_trivially_copyable<Voicing>::value, "Voicing is copied across threads as raw data");
@@ -0,0 +1,67 @@
+#include "VoicingEngine.h"
+#include "EngineState.h"
+#include "MusicTheory.h"
+
+namespace VoicingEngine
+{
+    Voicing buildVoicing(int rootPitchClass, int chordTypeId, int octave, int inversion, int bassOffset)
+    {
+        Voicing voicing;
+        voicing.root = (juce::int8) MusicTheory::wrapPitchClass(rootPitchClass);
+        voicing.chordType = (juce::int8) chordTypeId;
+
+        if (chordTypeId < 0)
+            return voicing;
+
+        const auto& type = MusicTheory::getChordType(chordTypeId);
+        const int numNotes = juce::jmin(type.numIntervals, Voicing::maxNotes);
+
+        int notes[Voicing::maxNotes];
+        const int rootNote = MusicTheory::middleC + voicing.root + 12 * octave;
+        for (int i = 0; i < numNotes; ++i)
+            notes[i] = rootNote + type.intervals[i];
+
+        // Each positive step moves the lowest note up an octave, each negative step the
+        // highest note down one, so the notes stay in ascending order
+        for (int i = 0; i < std::abs(inversion); ++i)
+        {
+            if (inversion > 0)
+            {
+                const int lowest = notes[0] + 12;
+                std::copy(notes + 1, notes + numNotes, notes);
+                notes[numNotes - 1] = lowest;
+            }
+            else
+            {
+                const int highest = notes[numNotes - 1] - 12;
+                std::copy_backward(notes, notes + numNotes - 1, notes + numNotes);
+                notes[0] = highest;
+            }
+        }
+
+        for (int i = 0; i < numNotes; ++i)
+        {
+            if (notes[i] < 0 || notes[i] > 127)
+                continue; // Dropped rather than folded, so the voicing keeps its shape
+
+            voicing.notes[voicing.numNotes++] = (juce::uint8) notes[i];
+        }
+
+        const int bassIndex = MusicTheory::wrapPitchClass(voicing.root + bassOffset);
+        voicing.bassNote = (juce::int8) (48 + bassIndex + (bassIndex >= 5 ? -12 : 0));
+        return voicing;
+    }
+
+    void buildVoicings(EngineState& state)
+    {
+        for (int key = 0; key < AppStateModel::numKeys; ++key)
+        {
+            for (int slot = 0; slot < AppStateModel::maxSlotsPerKey; ++slot)
+            {
+                const int index = AppStateModel::getFlatSlotIndex(key, slot);
+                const int chordType = MusicTheory::resolveChordType(key, state.key, state.mode, state.chordTypeIndex[index]);
+                state.voicings[index] = buildVoicing(key, chordType, state.octave, state.inversion, state.bassOffset[index]);
+            }
+        }
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Voicing.h"
+
+struct EngineState;
+
+// Turns (root, chord type, octave, inversion, bass offset) into MIDI notes, following
+// handleKeyPress in PianoXL.tsx. buildVoicings() fills the per-slot cache in an
+// EngineState whenever it's compiled, so nothing is computed when a key is pressed.
+namespace VoicingEngine
+{
+    // Chord in root position at octave 0 sits on middle C; bass is C3-based and
+    // drops an octave from F upwards, as in the reference
+    Voicing buildVoicing(int rootPitchClass, int chordTypeId, int octave, int inversion, int bassOffset);
+
+    // Fills state.voicings from the other EngineState fields
+    void buildVoicings(EngineState& state);
+}